@@ -0,0 +1,213 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+// Dither benchmark. Writes stereo float samples as 16 bit PCM to a sink
+// that throws them away: without dither, through the strided copy loop
+// that dither.c ran before it had real dither, and with every dither type
+// set through SFC_SET_DITHER_ON_WRITE. Reports samples per second of each,
+// the cost of its pass on top of the plain write, and memcpy() of the
+// same input for reference.
+//
+// Usage: aurorafw-audio-bench-dither [seconds of audio]
+
+// LibSNDFile
+#include <sndfile.h>
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const int benchSampleRate = 48000;
+static const int benchChannels = 2;
+
+// Size of the dither buffer before real dither, in floats
+static const int copyBufferLen = 8192 / sizeof(float);
+
+// Virtual file that accepts and discards everything written to it
+static sf_count_t sinkPosition = 0;
+
+static sf_count_t sinkGetLength(void* )
+{
+	return sinkPosition;
+}
+
+static sf_count_t sinkSeek(sf_count_t offset, int whence, void* )
+{
+	if(whence == SEEK_SET)
+		sinkPosition = offset;
+	else if(whence == SEEK_CUR)
+		sinkPosition += offset;
+	return sinkPosition;
+}
+
+static sf_count_t sinkRead(void* , sf_count_t , void* )
+{
+	return 0;
+}
+
+static sf_count_t sinkWrite(const void* , sf_count_t count, void* )
+{
+	sinkPosition += count;
+	return count;
+}
+
+static sf_count_t sinkTell(void* )
+{
+	return sinkPosition;
+}
+
+static SF_VIRTUAL_IO sinkIO = { sinkGetLength, sinkSeek, sinkRead, sinkWrite, sinkTell };
+
+static SNDFILE* openSink()
+{
+	SF_INFO info = {};
+	info.samplerate = benchSampleRate;
+	info.channels = benchChannels;
+	info.format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+	sinkPosition = 0;
+	return sf_open_virtual(&sinkIO, SFM_WRITE, &info, nullptr);
+}
+
+// The pass dither_float() made before real dither: a per-channel strided copy
+static void copyLoop(const float* in, float* out, int frames, int channels)
+{
+	for(int ch = 0; ch < channels; ch++)
+		for(int k = ch; k < channels * frames; k += channels)
+			out[k] = in[k];
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Writes the samples with the given dither type (SFD_NO_DITHER for none),
+// and returns the seconds it took
+static double writeDithered(const std::vector<float>& samples, int type)
+{
+	SNDFILE* file = openSink();
+	if(type != SFD_NO_DITHER) {
+		SF_DITHER_INFO dither = { type, 1.0, "" };
+		sf_command(file, SFC_SET_DITHER_ON_WRITE, &dither, sizeof(dither));
+	}
+
+	const Clock::time_point start = Clock::now();
+	sf_write_float(file, samples.data(), samples.size());
+	const double seconds = secondsSince(start);
+
+	sf_close(file);
+	return seconds;
+}
+
+// Writes the samples through the old copy loop, chunk by chunk like
+// dither_write_float() did, and returns the seconds it took
+static double writeCopied(const std::vector<float>& samples)
+{
+	SNDFILE* file = openSink();
+	std::vector<float> buffer(copyBufferLen);
+	const int chunk = copyBufferLen / benchChannels * benchChannels;
+
+	const Clock::time_point start = Clock::now();
+	for(size_t offset = 0; offset < samples.size(); offset += chunk) {
+		const int count = (int)std::min<size_t>(chunk, samples.size() - offset);
+		copyLoop(samples.data() + offset, buffer.data(), count / benchChannels, benchChannels);
+		sf_write_float(file, buffer.data(), count);
+	}
+	const double seconds = secondsSince(start);
+
+	sf_close(file);
+	return seconds;
+}
+
+static double copyMemory(const std::vector<float>& samples, std::vector<float>& copy)
+{
+	const Clock::time_point start = Clock::now();
+	std::memcpy(copy.data(), samples.data(), samples.size() * sizeof(float));
+	const double seconds = secondsSince(start);
+
+	// Keeps the copy from being optimized away
+	return copy[copy.size() / 2] == 2.0f ? 0.0 : seconds;
+}
+
+// Best of a few runs, the first one also faults the pages in
+template<typename Run>
+static double best(Run run)
+{
+	double seconds = run();
+	for(int i = 0; i < 4; i++) {
+		const double now = run();
+		if(now < seconds)
+			seconds = now;
+	}
+	return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+	const double audioSeconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+	std::vector<float> samples((size_t)(audioSeconds * benchSampleRate) * benchChannels);
+
+	// Music-like levels, well above the 16 bit LSB
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> level(-0.5f, 0.5f);
+	for(float& sample : samples)
+		sample = level(random);
+
+	struct Mode {
+		const char* name;
+		int type;
+	};
+	const Mode modes[] = {
+		{ "white", SFD_WHITE },
+		{ "triangular", SFD_TRIANGULAR_PDF },
+		{ "shaped highpass", SFD_SHAPED_HIGHPASS },
+		{ "shaped f-weighted", SFD_SHAPED_F_WEIGHTED }
+	};
+
+	const double plain = best([&]() { return writeDithered(samples, SFD_NO_DITHER); });
+	const double perSample = 1e9 / samples.size();
+
+	std::printf("%zu stereo samples of float to 16 bit PCM\n", samples.size());
+	std::printf("%-18s %12s %10s %14s\n", "mode", "Msamples/s", "GB/s", "pass ns/sample");
+
+	std::vector<float> copy(samples.size());
+	const double memory = best([&]() { return copyMemory(samples, copy); });
+	std::printf("%-18s %12.1f %10.2f %14s\n", "memcpy", samples.size() / memory / 1e6,
+		samples.size() * sizeof(float) / memory / 1e9, "-");
+	std::printf("%-18s %12.1f %10.2f %14s\n", "no dither", samples.size() / plain / 1e6,
+		samples.size() * sizeof(float) / plain / 1e9, "-");
+
+	const double copied = best([&]() { return writeCopied(samples); });
+	std::printf("%-18s %12.1f %10.2f %14.3f\n", "old copy loop", samples.size() / copied / 1e6,
+		samples.size() * sizeof(float) / copied / 1e9, (copied - plain) * perSample);
+
+	for(const Mode& mode : modes) {
+		const double seconds = best([&]() { return writeDithered(samples, mode.type); });
+		std::printf("%-18s %12.1f %10.2f %14.3f\n", mode.name, samples.size() / seconds / 1e6,
+			samples.size() * sizeof(float) / seconds / 1e9, (seconds - plain) * perSample);
+	}
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+// Gain kernel benchmark. Applies volume and panning to interleaved mono,
+// stereo and 5.1 buffers with the per-sample loop audioOutputCallback used
+// before the DSP kernels, then with applyGains() and applyGainRamp() on the
+// instruction set picked at runtime, and reports samples per second of each.
+//
+// Usage: aurorafw-audio-bench-gain [frames per buffer]
+
+#include <AuroraFW/Audio/AudioBackend.h>
+#include <AuroraFW/Audio/AudioDSP.h>
+#include <AuroraFW/Audio/AudioOutput.h>
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace AuroraFW::AudioManager;
+
+// Each measure runs for about this long
+static const double benchSeconds = 0.5;
+
+// The loop at the end of audioOutputCallback before the DSP kernels, which
+// asks the source for its panning on every sample
+static void applyGainsLoop(float* output, size_t frames, int channels, float volume, AudioSource* source)
+{
+	for(size_t i = 0; i < frames; i++) {
+		for(uint8_t c = 0; c < channels; c++) {
+			float frame = *output;
+
+			if(source != nullptr) {
+				const float panning = source->getPanning();
+				if(c == 0)
+					frame *= (-0.5f * panning + 0.5f);
+				else if(c == 1)
+					frame *= (0.5f * panning + 0.5f);
+			}
+
+			frame *= volume * AudioBackend::getInstance().globalVolume;
+
+			*output++ = frame;
+		}
+	}
+}
+
+// Gains as AudioOStream calculates them once per buffer
+static void calculateGains(float* gains, int channels, float volume, AudioSource* source)
+{
+	const float panning = source->getPanning();
+	const float gain = volume * AudioBackend::getInstance().globalVolume;
+	for(int c = 0; c < channels; c++) {
+		if(c == 0)
+			gains[c] = gain * (-0.5f * panning + 0.5f);
+		else if(c == 1)
+			gains[c] = gain * (0.5f * panning + 0.5f);
+		else
+			gains[c] = gain;
+	}
+}
+
+// Runs a kernel over a buffer until benchSeconds pass, and returns the
+// millions of samples processed per second. The buffer is refilled every
+// 64 runs, before the gains could shrink the samples into denormals
+template<typename Kernel>
+static double measure(const std::vector<float>& samples, Kernel kernel)
+{
+	typedef std::chrono::steady_clock Clock;
+	std::vector<float> buffer(samples.size());
+	const Clock::time_point start = Clock::now();
+	size_t runs = 0;
+	double elapsed;
+	do {
+		std::copy(samples.begin(), samples.end(), buffer.begin());
+		for(int i = 0; i < 64; i++)
+			kernel(buffer.data());
+		runs += 64;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	} while(elapsed < benchSeconds);
+
+	return runs * buffer.size() / elapsed / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+	const int channelCounts[] = { 1, 2, 6 };
+	const float volume = 0.8f;
+
+	AudioBackend::start();
+	AudioSource source(1.0f, 0.0f, 0.5f);
+
+	std::printf("Instruction set: %s, %zu frames per buffer\n", getDSPInstructionSet(), frames);
+	std::printf("%8s %14s %14s %14s %10s %10s\n", "channels", "loop MS/s", "gains MS/s",
+		"ramp MS/s", "gains x", "ramp x");
+
+	for(int channels : channelCounts) {
+		const std::vector<float> samples(frames * channels, 0.25f);
+		std::vector<float> gains(channels), lastGains(channels);
+		calculateGains(lastGains.data(), channels, volume, &source);
+
+		const double loop = measure(samples, [&](float* buffer) {
+			applyGainsLoop(buffer, frames, channels, volume, &source);
+		});
+		const double kernel = measure(samples, [&](float* buffer) {
+			calculateGains(gains.data(), channels, volume, &source);
+			applyGains(buffer, frames, channels, gains.data());
+		});
+		const double ramp = measure(samples, [&](float* buffer) {
+			calculateGains(gains.data(), channels, volume, &source);
+			applyGainRamp(buffer, frames, channels, lastGains.data(), gains.data());
+		});
+
+		std::printf("%8d %14.1f %14.1f %14.1f %10.2f %10.2f\n", channels, loop, kernel, ramp,
+			kernel / loop, ramp / loop);
+	}
+
+	AudioBackend::terminate();
+	return 0;
+}
@@ -0,0 +1,131 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+// Mixing benchmark. Plays 1 to 256 looping stereo voices through the
+// AudioMixer and reports the CPU load of its single output callback, then
+// plays the same voices on an output stream each, as before the mixer.
+// Needs a default output device.
+//
+// Usage: aurorafw-audio-bench-mixer [seconds per measure]
+
+#include <AuroraFW/Audio/AudioBackend.h>
+#include <AuroraFW/Audio/AudioMixer.h>
+#include <AuroraFW/Audio/AudioOutput.h>
+
+// LibSNDFile
+#include <sndfile.h>
+
+// STD
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace AuroraFW::AudioManager;
+
+static const char* benchFile = "aurorafw-audio-bench-mixer.wav";
+
+// Writes a second of stereo noise for the voices to loop over
+static void writeVoiceFile()
+{
+	SF_INFO info = {};
+	info.samplerate = 44100;
+	info.channels = 2;
+	info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+
+	std::vector<float> samples(info.samplerate * info.channels);
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+	for(float& sample : samples)
+		sample = noise(random);
+
+	SNDFILE* file = sf_open(benchFile, SFM_WRITE, &info);
+	sf_writef_float(file, samples.data(), info.samplerate);
+	sf_close(file);
+}
+
+// Plays the voices and returns the mean CPU load of every output stream
+// involved, that is, the mixer's one or the voices' own
+static double measureLoad(std::vector<std::unique_ptr<AudioOStream>>& voices, bool mixed, double seconds)
+{
+	for(std::unique_ptr<AudioOStream>& voice : voices) {
+		voice->audioPlayMode = AudioPlayMode::Loop;
+		voice->play();
+	}
+
+	// PortAudio averages the load over the last callbacks
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	const int samples = static_cast<int>(seconds * 10);
+	double load = 0;
+	for(int i = 0; i < samples; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if(mixed) {
+			load += voices.front()->getCpuLoad();
+		} else {
+			for(std::unique_ptr<AudioOStream>& voice : voices)
+				load += voice->getCpuLoad();
+		}
+	}
+
+	for(std::unique_ptr<AudioOStream>& voice : voices)
+		voice->stop();
+
+	return load / samples;
+}
+
+int main(int argc, char* argv[])
+{
+	const double seconds = argc > 1 ? std::atof(argv[1]) : 3.0;
+	const size_t voiceCounts[] = { 1, 16, 64, 256 };
+
+	AudioBackend::start();
+	writeVoiceFile();
+
+	std::printf("%8s %16s %16s %16s\n", "voices", "mixer load %", "per voice %", "streams load %");
+	for(size_t count : voiceCounts) {
+		std::vector<std::unique_ptr<AudioOStream>> voices;
+
+		// Every voice shares the same mapping of the file
+		AudioBackend::getInstance().startMixer();
+		for(size_t i = 0; i < count; i++)
+			voices.emplace_back(new AudioOStream(benchFile, nullptr, true));
+		const double mixerLoad = measureLoad(voices, true, seconds);
+		voices.clear();
+		AudioBackend::getInstance().stopMixer();
+
+		std::printf("%8zu %16.3f %16.4f", count, mixerLoad * 100, mixerLoad * 100 / count);
+
+		// Most host APIs can't open that many streams at once
+		try {
+			for(size_t i = 0; i < count; i++)
+				voices.emplace_back(new AudioOStream(benchFile, nullptr, true));
+			std::printf(" %16.3f\n", measureLoad(voices, false, seconds) * 100);
+		} catch(const PAErrorException& ) {
+			std::printf(" %16s\n", "n/a");
+		}
+		voices.clear();
+	}
+
+	AudioBackend::terminate();
+	std::remove(benchFile);
+	return 0;
+}
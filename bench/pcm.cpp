@@ -0,0 +1,237 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+// PCM read benchmark. Reads raw 8, 16, 24 and 32 bit PCM of both
+// endiannesses from memory to float and double with sf_read_float() and
+// sf_read_double(), which go through the pcm.c kernels, and converts the
+// same bytes with the per-sample loop pcm.c used before them, in 8 KiB
+// chunks like its scratch buffer. Reports GB/s of PCM decoded by each, and
+// checks the two give the same samples.
+//
+// Usage: aurorafw-audio-bench-pcm [seconds of audio]
+
+// LibSNDFile
+#include <sndfile.h>
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const int benchSampleRate = 48000;
+static const int benchChannels = 2;
+
+// Size of the pcm.c scratch buffer, in bytes
+static const int chunkBytes = 8192;
+
+// Virtual file that reads from a buffer in memory
+struct MemoryFile {
+	const std::vector<unsigned char>* data;
+	sf_count_t position;
+};
+
+static sf_count_t memoryGetLength(void* user)
+{
+	return static_cast<MemoryFile*>(user)->data->size();
+}
+
+static sf_count_t memorySeek(sf_count_t offset, int whence, void* user)
+{
+	MemoryFile* file = static_cast<MemoryFile*>(user);
+	if(whence == SEEK_SET)
+		file->position = offset;
+	else if(whence == SEEK_CUR)
+		file->position += offset;
+	else
+		file->position = file->data->size() + offset;
+	return file->position;
+}
+
+static sf_count_t memoryRead(void* ptr, sf_count_t count, void* user)
+{
+	MemoryFile* file = static_cast<MemoryFile*>(user);
+	count = std::max<sf_count_t>(std::min<sf_count_t>(count, file->data->size() - file->position), 0);
+	std::memcpy(ptr, file->data->data() + file->position, count);
+	file->position += count;
+	return count;
+}
+
+static sf_count_t memoryWrite(const void* , sf_count_t , void* )
+{
+	return 0;
+}
+
+static sf_count_t memoryTell(void* user)
+{
+	return static_cast<MemoryFile*>(user)->position;
+}
+
+static SF_VIRTUAL_IO memoryIO = { memoryGetLength, memorySeek, memoryRead, memoryWrite, memoryTell };
+
+// One sample as pcm.c reads it: 8 and 16 bit as they are, 24 bit in the
+// top bits of an int, 32 bit as it is
+template<int Width, bool BigEndian, bool Unsigned>
+static inline int32_t decode(const unsigned char* ptr)
+{
+	switch(Width) {
+		case 1:
+			return Unsigned ? ptr[0] - 128 : static_cast<signed char>(ptr[0]);
+		case 2:
+			return BigEndian ? static_cast<int16_t>((ptr[0] << 8) | ptr[1])
+				: static_cast<int16_t>((ptr[1] << 8) | ptr[0]);
+		case 3:
+			return BigEndian ? static_cast<int32_t>((uint32_t(ptr[0]) << 24) | (ptr[1] << 16) | (ptr[2] << 8))
+				: static_cast<int32_t>((uint32_t(ptr[2]) << 24) | (ptr[1] << 16) | (ptr[0] << 8));
+		default:
+			return BigEndian ? static_cast<int32_t>((uint32_t(ptr[0]) << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3])
+				: static_cast<int32_t>((uint32_t(ptr[3]) << 24) | (ptr[2] << 16) | (ptr[1] << 8) | ptr[0]);
+	}
+}
+
+// The scalar path: copies a chunk to a scratch buffer, then converts it
+// one sample at a time
+template<int Width, bool BigEndian, bool Unsigned, typename T>
+static void scalarRead(const std::vector<unsigned char>& data, T* dest)
+{
+	const T normfact = T(1.0) / (Width == 1 ? 0x80 : Width == 2 ? 0x8000 : T(0x80000000));
+	unsigned char buffer[chunkBytes];
+	const size_t chunk = chunkBytes / Width * Width;
+
+	for(size_t offset = 0; offset < data.size(); offset += chunk) {
+		const size_t bytes = std::min(chunk, data.size() - offset);
+		std::memcpy(buffer, data.data() + offset, bytes);
+		for(size_t k = 0; k < bytes / Width; k++)
+			*dest++ = static_cast<T>(decode<Width, BigEndian, Unsigned>(buffer + k * Width)) * normfact;
+	}
+}
+
+struct Format {
+	const char* name;
+	int format;
+	int width;
+	void (*scalarFloat)(const std::vector<unsigned char>&, float*);
+	void (*scalarDouble)(const std::vector<unsigned char>&, double*);
+};
+
+#define BENCH_FORMAT(name, format, width, big, isUnsigned) \
+	{ name, format, width, scalarRead<width, big, isUnsigned, float>, scalarRead<width, big, isUnsigned, double> }
+
+static const Format formats[] = {
+	BENCH_FORMAT("8 bit signed", SF_FORMAT_PCM_S8, 1, false, false),
+	BENCH_FORMAT("8 bit unsigned", SF_FORMAT_PCM_U8, 1, false, true),
+	BENCH_FORMAT("16 bit LE", SF_FORMAT_PCM_16 | SF_ENDIAN_LITTLE, 2, false, false),
+	BENCH_FORMAT("16 bit BE", SF_FORMAT_PCM_16 | SF_ENDIAN_BIG, 2, true, false),
+	BENCH_FORMAT("24 bit LE", SF_FORMAT_PCM_24 | SF_ENDIAN_LITTLE, 3, false, false),
+	BENCH_FORMAT("24 bit BE", SF_FORMAT_PCM_24 | SF_ENDIAN_BIG, 3, true, false),
+	BENCH_FORMAT("32 bit LE", SF_FORMAT_PCM_32 | SF_ENDIAN_LITTLE, 4, false, false),
+	BENCH_FORMAT("32 bit BE", SF_FORMAT_PCM_32 | SF_ENDIAN_BIG, 4, true, false)
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Best of a few runs, the first one also faults the pages in
+template<typename Run>
+static double best(Run run)
+{
+	double seconds = run();
+	for(int i = 0; i < 4; i++) {
+		const double now = run();
+		if(now < seconds)
+			seconds = now;
+	}
+	return seconds;
+}
+
+// Reads the whole file through libsndfile and returns the seconds it took
+template<typename T>
+static double readLibrary(SNDFILE* file, MemoryFile& memory, std::vector<T>& dest,
+	sf_count_t (*read)(SNDFILE*, T*, sf_count_t))
+{
+	sf_seek(file, 0, SEEK_SET);
+	memory.position = 0;
+	const Clock::time_point start = Clock::now();
+	read(file, dest.data(), dest.size());
+	return secondsSince(start);
+}
+
+template<typename T>
+static double readScalar(const std::vector<unsigned char>& data, std::vector<T>& dest,
+	void (*read)(const std::vector<unsigned char>&, T*))
+{
+	const Clock::time_point start = Clock::now();
+	read(data, dest.data());
+	return secondsSince(start);
+}
+
+int main(int argc, char* argv[])
+{
+	const double audioSeconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+	const size_t samples = (size_t)(audioSeconds * benchSampleRate) * benchChannels;
+
+	std::printf("%zu samples of raw PCM from memory, GB/s of PCM decoded\n", samples);
+	std::printf("%-16s %10s %10s %8s %10s %10s %8s\n", "format", "float", "scalar", "x",
+		"double", "scalar", "x");
+
+	std::mt19937 random(1);
+	std::vector<float> floats(samples), scalarFloats(samples);
+	std::vector<double> doubles(samples), scalarDoubles(samples);
+
+	for(const Format& format : formats) {
+		std::vector<unsigned char> data(samples * format.width);
+		for(unsigned char& byte : data)
+			byte = static_cast<unsigned char>(random());
+
+		MemoryFile memory = { &data, 0 };
+		SF_INFO info = {};
+		info.samplerate = benchSampleRate;
+		info.channels = benchChannels;
+		info.format = SF_FORMAT_RAW | format.format;
+		SNDFILE* file = sf_open_virtual(&memoryIO, SFM_READ, &info, &memory);
+		if(file == nullptr) {
+			std::printf("%-16s %s\n", format.name, sf_strerror(nullptr));
+			continue;
+		}
+
+		const double gigabytes = data.size() / 1e9;
+		const double toFloat = best([&]() { return readLibrary(file, memory, floats, sf_read_float); });
+		const double scalarFloat = best([&]() { return readScalar(data, scalarFloats, format.scalarFloat); });
+		const double toDouble = best([&]() { return readLibrary(file, memory, doubles, sf_read_double); });
+		const double scalarDouble = best([&]() { return readScalar(data, scalarDoubles, format.scalarDouble); });
+		sf_close(file);
+
+		std::printf("%-16s %10.2f %10.2f %8.2f %10.2f %10.2f %8.2f", format.name,
+			gigabytes / toFloat, gigabytes / scalarFloat, scalarFloat / toFloat,
+			gigabytes / toDouble, gigabytes / scalarDouble, scalarDouble / toDouble);
+
+		if(floats != scalarFloats || doubles != scalarDoubles)
+			std::printf("  output differs from the scalar loop");
+		std::printf("\n");
+	}
+
+	return 0;
+}
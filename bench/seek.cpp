@@ -0,0 +1,207 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+// Seek benchmark. Writes FLAC and Ogg Vorbis files, then seeks to random
+// frames and reads a short block after each seek. Every seek of the
+// "no index" column runs on a freshly opened file, whose index knows
+// nothing yet, so it searches the way seeks did before the index. The
+// other columns seek with the index built by SFC_BUILD_SEEK_INDEX, and
+// on a freshly opened file again, with the index loaded from the sidecar
+// by SFC_SET_SEEK_INDEX_SIDECAR. Reports seeks per second of each and how
+// long building the index took.
+//
+// Usage: aurorafw-audio-bench-seek [seconds of audio] [seeks]
+
+// LibSNDFile
+#include <sndfile.h>
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static const int benchSampleRate = 44100;
+static const int benchChannels = 2;
+
+// Frames read after every seek
+static const int readFrames = 256;
+
+// The "no index" column stops after this long, searching is slow
+static const double searchSeconds = 10.0;
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static const double pi = 3.14159265358979323846;
+
+// Writes a sweep with some noise, which compresses about as well as music
+static bool writeFile(const char* path, int format, double seconds)
+{
+	SF_INFO info = {};
+	info.samplerate = benchSampleRate;
+	info.channels = benchChannels;
+	info.format = format;
+
+	SNDFILE* file = sf_open(path, SFM_WRITE, &info);
+	if(file == nullptr)
+		return false;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+	std::vector<float> buffer(4096 * benchChannels);
+	const sf_count_t frames = static_cast<sf_count_t>(seconds * benchSampleRate);
+
+	// libvorbis needs short writes, it keeps a whole write on the stack
+	for(sf_count_t done = 0; done < frames; done += 4096) {
+		const sf_count_t count = std::min<sf_count_t>(4096, frames - done);
+		for(sf_count_t k = 0; k < count; k++) {
+			const double t = double(done + k) / benchSampleRate;
+			const float sample = 0.4f * std::sin(2 * pi * (200 + 20 * std::fmod(t, 30.0)) * t);
+			for(int c = 0; c < benchChannels; c++)
+				buffer[k * benchChannels + c] = sample + noise(random);
+		}
+		sf_writef_float(file, buffer.data(), count);
+	}
+
+	sf_close(file);
+	return true;
+}
+
+enum class SeekIndex {
+	None,		// Whatever the seeks themselves teach it
+	Built,		// Built with SFC_BUILD_SEEK_INDEX after opening
+	Sidecar		// Loaded from the sidecar when opening
+};
+
+// Seeks to the given frames and reads after each one, and returns the
+// seeks per second. Opens the file again for every seek if fresh is set
+static double measureSeeks(const char* path, const std::vector<sf_count_t>& frames, bool fresh,
+	SeekIndex index, int& failures)
+{
+	std::vector<float> buffer(readFrames * benchChannels);
+	SNDFILE* file = nullptr;
+	double seconds = 0;
+	size_t seeks = 0;
+
+	for(sf_count_t frame : frames) {
+		if(file == nullptr || fresh) {
+			if(file != nullptr)
+				sf_close(file);
+			SF_INFO info = {};
+			file = sf_open(path, SFM_READ, &info);
+			if(index == SeekIndex::Built)
+				sf_command(file, SFC_BUILD_SEEK_INDEX, nullptr, 0);
+			else if(index == SeekIndex::Sidecar)
+				sf_command(file, SFC_SET_SEEK_INDEX_SIDECAR, nullptr, SF_TRUE);
+		}
+
+		const Clock::time_point start = Clock::now();
+		if(sf_seek(file, frame, SEEK_SET) != frame)
+			failures++;
+		sf_readf_float(file, buffer.data(), readFrames);
+		seconds += secondsSince(start);
+		seeks++;
+
+		if(index == SeekIndex::None && seconds > searchSeconds)
+			break;
+	}
+
+	sf_close(file);
+	return seeks / seconds;
+}
+
+// Builds the index and saves it next to the file, and returns the seconds
+// it took
+static double buildIndex(const char* path)
+{
+	SF_INFO info = {};
+	SNDFILE* file = sf_open(path, SFM_READ, &info);
+	sf_command(file, SFC_SET_SEEK_INDEX_SIDECAR, nullptr, SF_TRUE);
+
+	const Clock::time_point start = Clock::now();
+	sf_command(file, SFC_BUILD_SEEK_INDEX, nullptr, 0);
+	const double seconds = secondsSince(start);
+
+	sf_close(file);
+	return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+	const double audioSeconds = argc > 1 ? std::atof(argv[1]) : 300.0;
+	const size_t seekCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+	struct Format {
+		const char* name;
+		const char* path;
+		int format;
+	};
+	const Format formats[] = {
+		{ "FLAC 16 bit", "aurorafw-audio-bench-seek-16.flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_16 },
+		{ "FLAC 24 bit", "aurorafw-audio-bench-seek-24.flac", SF_FORMAT_FLAC | SF_FORMAT_PCM_24 },
+		{ "Ogg Vorbis", "aurorafw-audio-bench-seek.ogg", SF_FORMAT_OGG | SF_FORMAT_VORBIS }
+	};
+
+	std::printf("%.0f s of stereo audio, %d frames read after each seek, seeks per second\n",
+		audioSeconds, readFrames);
+	std::printf("%-12s %12s %12s %12s %10s %12s\n", "format", "no index", "index", "sidecar",
+		"x", "build ms");
+
+	std::mt19937 random(1);
+	const sf_count_t totalFrames = static_cast<sf_count_t>(audioSeconds * benchSampleRate);
+	std::uniform_int_distribution<sf_count_t> position(0, totalFrames - readFrames);
+	std::vector<sf_count_t> frames(seekCount);
+	for(sf_count_t& frame : frames)
+		frame = position(random);
+
+	for(const Format& format : formats) {
+		const std::string sidecarPath = std::string(format.path) + ".sfidx";
+		std::remove(sidecarPath.c_str());
+
+		if(!writeFile(format.path, format.format, audioSeconds)) {
+			std::printf("%-12s %s\n", format.name, sf_strerror(nullptr));
+			continue;
+		}
+
+		int failures = 0;
+		const double searched = measureSeeks(format.path, frames, true, SeekIndex::None, failures);
+		const double indexed = measureSeeks(format.path, frames, false, SeekIndex::Built, failures);
+		const double built = buildIndex(format.path);
+		const double loaded = measureSeeks(format.path, frames, true, SeekIndex::Sidecar, failures);
+
+		std::printf("%-12s %12.1f %12.1f %12.1f %10.1f %12.1f", format.name, searched, indexed,
+			loaded, indexed / searched, built * 1e3);
+		if(failures > 0)
+			std::printf("  %d seeks failed", failures);
+		std::printf("\n");
+
+		std::remove(format.path);
+		std::remove(sidecarPath.c_str());
+	}
+
+	return 0;
+}
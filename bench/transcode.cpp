@@ -0,0 +1,167 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+// Transcode benchmark. Writes a batch of short GSM 6.10 voice files, 0.5
+// to 2 seconds long, as WAV49 and as AIFF, and converts every batch to 16
+// bit WAV with an AudioTranscoder. Each batch runs with the GSM codec state
+// pool on and then with it off through SFC_SET_CODEC_STATE_POOL, and the
+// files per second of each are reported.
+//
+// Usage: aurorafw-audio-bench-transcode [files] [workers]
+
+#include <AuroraFW/Audio/AudioTranscoder.h>
+
+// LibSNDFile
+#include <sndfile.h>
+
+// STD
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace AuroraFW::AudioManager;
+
+static const int benchSampleRate = 8000;
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static const double pi = 3.14159265358979323846;
+
+// Writes a tone with some noise, roughly what a voice codec sees
+static bool writeFile(const char* path, int format, sf_count_t frames, std::mt19937& random)
+{
+	SF_INFO info = {};
+	info.samplerate = benchSampleRate;
+	info.channels = 1;
+	info.format = format;
+
+	SNDFILE* file = sf_open(path, SFM_WRITE, &info);
+	if(file == nullptr)
+		return false;
+
+	std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+	std::vector<float> samples(frames);
+	for(sf_count_t k = 0; k < frames; k++)
+		samples[k] = 0.3f * std::sin(2 * pi * 300 * k / benchSampleRate) + noise(random);
+	sf_writef_float(file, samples.data(), frames);
+
+	sf_close(file);
+	return true;
+}
+
+// Transcodes the whole batch and returns the files per second, counting
+// the files that failed
+static double measureBatch(AudioTranscoder& transcoder,
+	const std::vector<std::pair<std::string, std::string>>& files, int& failures)
+{
+	const Clock::time_point start = Clock::now();
+	std::vector<std::shared_future<AudioTranscodeResult>> results
+		= transcoder.transcode(files, SF_FORMAT_WAV | SF_FORMAT_PCM_16);
+	transcoder.wait();
+	const double seconds = secondsSince(start);
+
+	for(std::shared_future<AudioTranscodeResult>& result : results) {
+		try {
+			result.get();
+		} catch(...) {
+			failures++;
+		}
+	}
+
+	return files.size() / seconds;
+}
+
+// Best of a few batches, the first one also warms the page cache
+static double bestBatch(AudioTranscoder& transcoder,
+	const std::vector<std::pair<std::string, std::string>>& files, int& failures)
+{
+	double filesPerSecond = 0;
+	for(int i = 0; i < 3; i++) {
+		const double now = measureBatch(transcoder, files, failures);
+		if(now > filesPerSecond)
+			filesPerSecond = now;
+	}
+	return filesPerSecond;
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t fileCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+	const unsigned int workers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+
+	struct Format {
+		const char* name;
+		const char* extension;
+		int format;
+	};
+	const Format formats[] = {
+		{ "WAV49", "wav", SF_FORMAT_WAV | SF_FORMAT_GSM610 },
+		{ "AIFF", "aiff", SF_FORMAT_AIFF | SF_FORMAT_GSM610 }
+	};
+
+	AudioTranscoder transcoder(workers);
+
+	std::printf("%zu GSM 6.10 files of 0.5 to 2 s to 16 bit WAV, files per second\n", fileCount);
+	std::printf("%-8s %12s %12s %8s\n", "format", "pool", "no pool", "x");
+
+	for(const Format& format : formats) {
+		std::mt19937 random(1);
+		std::uniform_int_distribution<sf_count_t> length(benchSampleRate / 2, benchSampleRate * 2);
+
+		std::vector<std::pair<std::string, std::string>> files(fileCount);
+		bool written = true;
+		for(size_t i = 0; i < fileCount && written; i++) {
+			files[i].first = "aurorafw-audio-bench-transcode-" + std::to_string(i) + "." + format.extension;
+			files[i].second = "aurorafw-audio-bench-transcode-" + std::to_string(i) + ".out.wav";
+			written = writeFile(files[i].first.c_str(), format.format, length(random), random);
+		}
+
+		if(written) {
+			int failures = 0;
+			sf_command(nullptr, SFC_SET_CODEC_STATE_POOL, nullptr, SF_TRUE);
+			const double pooled = bestBatch(transcoder, files, failures);
+			sf_command(nullptr, SFC_SET_CODEC_STATE_POOL, nullptr, SF_FALSE);
+			const double unpooled = bestBatch(transcoder, files, failures);
+			sf_command(nullptr, SFC_SET_CODEC_STATE_POOL, nullptr, SF_TRUE);
+
+			std::printf("%-8s %12.1f %12.1f %8.2f", format.name, pooled, unpooled, pooled / unpooled);
+			if(failures > 0)
+				std::printf("  %d files failed", failures);
+			std::printf("\n");
+		} else {
+			std::printf("%-8s %s\n", format.name, sf_strerror(nullptr));
+		}
+
+		for(const std::pair<std::string, std::string>& file : files) {
+			std::remove(file.first.c_str());
+			std::remove(file.second.c_str());
+		}
+	}
+
+	return 0;
+}
@@ -41,9 +41,14 @@
 
 // STD
 #include <exception>
+#include <vector>
 
 namespace AuroraFW {
 	namespace AudioManager {
+		class AudioLoader;
+		class AudioMixer;
+		class AudioSampleCache;
+		struct AudioSource;
 
 		/**
 		 * An exception to tell the user that an internal <em>PortAudio</em> error ocurred.
@@ -214,6 +219,15 @@ namespace AuroraFW {
 			const PaDeviceInfo *_deviceInfo;
 		};
 
+		/**
+		 * An enum to indicate the desired fallout type for 3D audio.
+		 * @since snapshot20180330
+		 */
+		enum class AudioFallout {
+			Linear,		/**< Linear function. */
+			Exponential	/**< Exponential function. */
+		};
+
 		/**
 		 * A singleton struct representing an audio listener.
 		 * A singleton struct that represents an audio listener in 3D space, used for 3D effects.
@@ -226,8 +240,21 @@ namespace AuroraFW {
 
 				static void _start();
 				static void _stop();
+
+				size_t _addSource(AudioSource* , const Math::Vector3D& , float , float , AudioFallout );
+				void _removeSource(size_t );
+				void _updateSources(size_t , size_t );
+
+				// The sources are stored as a structure of arrays, so update()
+				// goes through all of them in a single, vectorizable, pass
+				std::vector<AudioSource*> _sources;
+				std::vector<float> _sourceX, _sourceY, _sourceZ;
+				std::vector<float> _sourceMedDistance, _sourceMaxDistance;
+				std::vector<AudioFallout> _sourceFallout;
+				std::vector<float> _sourceDistance, _sourcePan, _sourceStrength;
 			public:
-				friend struct AudioBackend;
+				friend class AudioBackend;
+				friend struct AudioSource;
 
 				/**
 				 * AudioListener destructor.
@@ -255,6 +282,28 @@ namespace AuroraFW {
 				 * @since snapshot20180330
 				 */
 				Math::Vector3D direction = Math::Vector3D(0, 0, -1);
+
+				/**
+				 * The listener's 3D up vector. Default is the positive Y-axis. (0, 1, 0)
+				 * @see direction
+				 * @since snapshot20180330
+				 */
+				Math::Vector3D up = Math::Vector3D(0, 1, 0);
+
+				/**
+				 * Recalculates the 3D effect (panning and strength) of every AudioSource
+				 * in a single pass. Should be called once per frame after moving the listener.
+				 * @see AudioSource::calculateValues()
+				 * @since snapshot20180330
+				 */
+				void update();
+
+				/**
+				 * Gets the number of AudioSources currently alive.
+				 * @return The number of AudioSources.
+				 * @since snapshot20180330
+				 */
+				size_t getNumSources() const;
 		};
 
 		/**
@@ -278,6 +327,10 @@ namespace AuroraFW {
 			int _numOutputDevices;
 			int _numInputDevices;
 
+			AudioMixer* _mixer = nullptr;
+			AudioSampleCache* _sampleCache = nullptr;
+			AudioLoader* _loader = nullptr;
+
 		public:
 			/**
 			 * AudioBackend destructor.
@@ -381,6 +434,48 @@ namespace AuroraFW {
 			 */
 			int getNumInputDevices();
 
+			/**
+			 * Starts the software mixer. While it's running, every new AudioOStream is
+			 * mixed into the mixer's single output stream instead of opening its own.
+			 * @param channels The number of output channels of the mixer. (default = 2)
+			 * @throws PAErrorException In case there was a <em>PortAudio</em> error.
+			 * @see stopMixer()
+			 * @see getMixer()
+			 * @since snapshot20180330
+			 */
+			void startMixer(int = 2);
+
+			/**
+			 * Stops the software mixer.
+			 * @note Streams created while the mixer was running are stopped. If they're played again, each one opens an output stream of its own (or becomes a voice of the mixer, if it was started again in the meantime).
+			 * @see startMixer(int )
+			 * @since snapshot20180330
+			 */
+			void stopMixer();
+
+			/**
+			 * Gets the software mixer.
+			 * @return A pointer to the AudioMixer. <em>nullptr</em> if the mixer isn't running.
+			 * @see startMixer(int )
+			 * @since snapshot20180330
+			 */
+			AudioMixer* getMixer();
+
+			/**
+			 * Gets the cache of decoded samples shared by all buffered AudioOStreams.
+			 * @return A reference to the AudioSampleCache.
+			 * @since snapshot20180330
+			 */
+			AudioSampleCache& getSampleCache();
+
+			/**
+			 * Gets the pool of workers that load audio files in the background.
+			 * The workers are started the first time this is called.
+			 * @return A reference to the AudioLoader.
+			 * @since snapshot20180330
+			 */
+			AudioLoader& getLoader();
+
 			/**
 			 * The global volume for all output audio.
 			 * Ideally, it should only range from 0 to 1.
@@ -0,0 +1,263 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+/**
+ * @file AuroraFW/Audio/AudioCache.h
+ * AudioCache header. This contains the cache of
+ * decoded samples shared between buffered audio
+ * streams.
+ * @since snapshot20180330
+ */
+
+#ifndef AURORAFW_AUDIO_AUDIOCACHE_H
+#define AURORAFW_AUDIO_AUDIOCACHE_H
+
+// AuroraFW
+#include <AuroraFW/Global.h>
+#if(AFW_TARGET_PRAGMA_ONCE_SUPPORT)
+	#pragma once
+#endif
+
+// LibSNDFile
+#include <sndfile.h>
+
+// STD
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		/**
+		 * A class representing the decoded samples of an audio file.
+		 * A class holding interleaved float samples. It's immutable once it's
+		 * cached, so any number of streams can read from it at the same time.
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioSampleBuffer {
+			friend class AudioSampleCache;
+
+		public:
+			/**
+			 * Constructs a silent AudioSampleBuffer.
+			 * @param frames The number of frames, without counting in the number of channels.
+			 * @param channels The number of channels.
+			 * @since snapshot20180330
+			 */
+			AudioSampleBuffer(sf_count_t , int );
+
+			/**
+			 * Destructs an AudioSampleBuffer, deleting its samples.
+			 * @since snapshot20180330
+			 */
+			~AudioSampleBuffer();
+
+			AudioSampleBuffer(const AudioSampleBuffer& ) = delete;
+			AudioSampleBuffer& operator=(const AudioSampleBuffer& ) = delete;
+
+			/**
+			 * Gets the interleaved samples.
+			 * @return A pointer to the first sample.
+			 * @since snapshot20180330
+			 */
+			const float* getSamples() const;
+
+			/**
+			 * Gets the number of frames.
+			 * @return The number of frames, without counting in the number of channels.
+			 * @since snapshot20180330
+			 */
+			sf_count_t getFrames() const;
+
+			/**
+			 * Gets the number of channels.
+			 * @return The number of channels.
+			 * @since snapshot20180330
+			 */
+			int getChannels() const;
+
+			/**
+			 * Gets the memory taken by the samples.
+			 * @return The size of the samples in bytes.
+			 * @since snapshot20180330
+			 */
+			size_t getSize() const;
+
+		private:
+			float* _samples;
+			sf_count_t _frames;
+			int _channels;
+		};
+
+		/**
+		 * A class representing a cache of decoded audio files.
+		 * A thread-safe class that decodes every file only once and shares the
+		 * result between all the buffered streams that play it. Files are keyed by
+		 * their path, modification time and size, so edited files are decoded again.
+		 * The least recently used files are evicted when the cache goes over budget.
+		 * Evicting a file only drops the cache's reference: streams still playing it
+		 * keep it alive, and it keeps being shared until the last of them is gone.
+		 * @see AudioBackend::getSampleCache()
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioSampleCache {
+		public:
+			/**
+			 * Constructs an empty AudioSampleCache.
+			 * @param budget The maximum number of bytes the cache keeps alive by itself. (default = 64 MiB)
+			 * @since snapshot20180330
+			 */
+			AudioSampleCache(size_t = 64 * 1024 * 1024);
+
+			AudioSampleCache(const AudioSampleCache& ) = delete;
+			AudioSampleCache& operator=(const AudioSampleCache& ) = delete;
+
+			/**
+			 * Gets the decoded samples of a file, decoding it on a cache miss.
+			 * @param path The path of the audio file, or <em>nullptr</em> to decode it without caching,
+			 * like a file opened from memory.
+			 * @param sndFile The <em>libsndfile</em> file object of the opened file, positioned at its start.
+			 * @param sndInfo The <em>libsndfile</em> info object of the opened file.
+			 * @param cacheHit Where to store whether the samples were served without decoding. (default = nullptr)
+			 * @return The shared, immutable samples of the file.
+			 * @since snapshot20180330
+			 */
+			std::shared_ptr<const AudioSampleBuffer> load(const char* , SNDFILE* , const SF_INFO* , bool* = nullptr);
+
+			/**
+			 * Sets the maximum number of bytes the cache keeps alive by itself.
+			 * Evicts files right away if the cache is over the new budget.
+			 * @param budget The budget in bytes. 0 keeps only the files that are being played.
+			 * @since snapshot20180330
+			 */
+			void setBudget(size_t );
+
+			/**
+			 * Gets the maximum number of bytes the cache keeps alive by itself.
+			 * @return The budget in bytes.
+			 * @since snapshot20180330
+			 */
+			size_t getBudget() const;
+
+			/**
+			 * Gets the number of bytes the cache is currently keeping alive.
+			 * @return The size of the cached samples in bytes.
+			 * @since snapshot20180330
+			 */
+			size_t getSize() const;
+
+			/**
+			 * Evicts every file from the cache.
+			 * @since snapshot20180330
+			 */
+			void clear();
+
+			/**
+			 * Gets the number of loads that were served without decoding.
+			 * @return The number of cache hits.
+			 * @since snapshot20180330
+			 */
+			uint64_t getNumHits() const;
+
+			/**
+			 * Gets the number of loads that had to decode their file.
+			 * @return The number of cache misses.
+			 * @since snapshot20180330
+			 */
+			uint64_t getNumMisses() const;
+
+			/**
+			 * Gets the number of files evicted from the cache.
+			 * @return The number of evictions.
+			 * @since snapshot20180330
+			 */
+			uint64_t getNumEvictions() const;
+
+		private:
+			struct Key {
+				std::string path;
+				long long modificationTime;
+				long long fileSize;
+
+				bool operator<(const Key& ) const;
+			};
+
+			struct Entry {
+				std::shared_ptr<const AudioSampleBuffer> buffer;
+				std::weak_ptr<const AudioSampleBuffer> weakBuffer;
+				std::list<Key>::iterator lruPosition;
+			};
+
+			void _cache(std::map<Key, Entry>::iterator );
+			void _uncache(std::map<Key, Entry>::iterator );
+			void _evict();
+			void _prune(const Key& );
+
+			mutable std::mutex _mutex;
+			std::map<Key, Entry> _entries;
+			std::list<Key> _lru;
+			size_t _budget;
+			size_t _size = 0;
+
+			std::atomic<uint64_t> _hits{0};
+			std::atomic<uint64_t> _misses{0};
+			std::atomic<uint64_t> _evictions{0};
+		};
+
+		// Inline definitions
+		inline const float* AudioSampleBuffer::getSamples() const
+		{
+			return _samples;
+		}
+
+		inline sf_count_t AudioSampleBuffer::getFrames() const
+		{
+			return _frames;
+		}
+
+		inline int AudioSampleBuffer::getChannels() const
+		{
+			return _channels;
+		}
+
+		inline size_t AudioSampleBuffer::getSize() const
+		{
+			return (size_t)_frames * _channels * sizeof(float);
+		}
+
+		inline uint64_t AudioSampleCache::getNumHits() const
+		{
+			return _hits.load(std::memory_order_relaxed);
+		}
+
+		inline uint64_t AudioSampleCache::getNumMisses() const
+		{
+			return _misses.load(std::memory_order_relaxed);
+		}
+
+		inline uint64_t AudioSampleCache::getNumEvictions() const
+		{
+			return _evictions.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+#endif // AURORAFW_AUDIO_AUDIOCACHE_H
@@ -0,0 +1,105 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+/**
+ * @file AuroraFW/Audio/AudioDSP.h
+ * AudioDSP header. This contains the vectorized
+ * kernels used to process audio buffers in the
+ * real-time callbacks.
+ * @since snapshot20180330
+ */
+
+#ifndef AURORAFW_AUDIO_AUDIODSP_H
+#define AURORAFW_AUDIO_AUDIODSP_H
+
+// AuroraFW
+#include <AuroraFW/Global.h>
+#if(AFW_TARGET_PRAGMA_ONCE_SUPPORT)
+	#pragma once
+#endif
+
+#include <AuroraFW/Internal/Config.h>
+
+// STD
+#include <cstddef>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		/**
+		 * Multiplies every sample of an interleaved buffer by the gain of its channel.
+		 * The fastest instruction set supported by the CPU (AVX2, SSE2 or NEON) is picked at runtime.
+		 * @param buffer The interleaved buffer to process in place.
+		 * @param frames The number of frames, without counting in the number of channels.
+		 * @param channels The number of channels of the buffer.
+		 * @param gains One gain per channel.
+		 * @see mixGains(float* , const float* , size_t , int , const float* )
+		 * @since snapshot20180330
+		 */
+		AFW_API void applyGains(float* , size_t , int , const float* );
+
+		/**
+		 * Multiplies every sample of an interleaved buffer by the gain of its channel and adds
+		 * it to another buffer with the same layout.
+		 * The fastest instruction set supported by the CPU (AVX2, SSE2 or NEON) is picked at runtime.
+		 * @param output The interleaved buffer to add the result to.
+		 * @param input The interleaved buffer to read from.
+		 * @param frames The number of frames, without counting in the number of channels.
+		 * @param channels The number of channels of both buffers.
+		 * @param gains One gain per channel.
+		 * @see applyGains(float* , size_t , int , const float* )
+		 * @since snapshot20180330
+		 */
+		AFW_API void mixGains(float* , const float* , size_t , int , const float* );
+
+		/**
+		 * Multiplies every sample of an interleaved buffer by the gain of its channel, linearly
+		 * ramping each gain from its start to its end value along the buffer. Used to avoid
+		 * zipper noise when the gains change between two buffers.
+		 * @param buffer The interleaved buffer to process in place.
+		 * @param frames The number of frames, without counting in the number of channels.
+		 * @param channels The number of channels of the buffer.
+		 * @param startGains One gain per channel, applied on the first frame.
+		 * @param endGains One gain per channel, reached after the last frame.
+		 * @see applyGains(float* , size_t , int , const float* )
+		 * @since snapshot20180330
+		 */
+		AFW_API void applyGainRamp(float* , size_t , int , const float* , const float* );
+
+		/**
+		 * The same as applyGainRamp(), but adding the result to another buffer with the same layout.
+		 * @param output The interleaved buffer to add the result to.
+		 * @param input The interleaved buffer to read from.
+		 * @param frames The number of frames, without counting in the number of channels.
+		 * @param channels The number of channels of both buffers.
+		 * @param startGains One gain per channel, applied on the first frame.
+		 * @param endGains One gain per channel, reached after the last frame.
+		 * @see mixGains(float* , const float* , size_t , int , const float* )
+		 * @since snapshot20180330
+		 */
+		AFW_API void mixGainRamp(float* , const float* , size_t , int , const float* , const float* );
+
+		/**
+		 * Gets the name of the instruction set picked for the audio kernels.
+		 * @return "AVX2", "SSE2", "NEON" or "Scalar".
+		 * @since snapshot20180330
+		 */
+		AFW_API const char* getDSPInstructionSet();
+	}
+}
+
+#endif // AURORAFW_AUDIO_AUDIODSP_H
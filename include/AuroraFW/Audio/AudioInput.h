@@ -31,6 +31,12 @@
 #include <AuroraFW/Audio/AudioUtils.h>
 #include <AuroraFW/Audio/AudioBackend.h>
 
+// STD
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace AuroraFW {
 	namespace AudioManager {
 
@@ -48,10 +54,13 @@ namespace AuroraFW {
 			 * @param path The path to where to save the audio stream.
 			 * @param info The AudioInfo object specifying all info about the stream.
 			 * @param int The number of frames (without considering the number of channels) to store.
+			 * 0 streams the recording to disk instead, so its length is only limited by the disk. (default = 0)
+			 * @param streamBufferFrames The number of frames the callback can get ahead of the disk writer
+			 * when streaming to disk. Ignored if the recording is stored in memory. (default = 65536)
 			 * @see ~AudioIStream()
 			 * @since snapshot20180330
 			 */
-			AudioIStream(const char* , AudioInfo* , int );
+			AudioIStream(const char* , AudioInfo* , int = 0, size_t = 65536);
 
 			/**
 			 * Destructs an audio input stream.
@@ -117,11 +126,36 @@ namespace AuroraFW {
 
 			/**
 			 * Returns is the buffer is completely filled with audio data.
+			 * When streaming to disk, this means the disk writer is falling behind.
 			 * @return <em>true</em> if the buffer is full. <em>false</em> otherwise.
 			 * @since snapshot20180330
 			 */
 			bool isBufferFull();
 
+			/**
+			 * Gets the number of times the disk writer couldn't keep up with the recording.
+			 * Each overrun drops input frames, which are missing from the file.
+			 * @return The number of overruns since the stream was created. Always 0 if the recording is stored in memory.
+			 * @see getNumDroppedFrames()
+			 * @since snapshot20180330
+			 */
+			unsigned int getNumOverruns();
+
+			/**
+			 * Gets the number of input frames dropped because the disk writer fell behind.
+			 * @return The number of dropped frames, without counting in the number of channels.
+			 * @see getNumOverruns()
+			 * @since snapshot20180330
+			 */
+			size_t getNumDroppedFrames();
+
+			/**
+			 * Gets the number of frames written to disk so far when streaming to disk.
+			 * @return The number of written frames, without counting in the number of channels.
+			 * @since snapshot20180330
+			 */
+			size_t getNumWrittenFrames();
+
 			/**
 			 * Clears the entire buffer so it can start fresh for new recordings.
 			 * @warning Calling this without saving the buffer first will discard any data currently stored in the buffer.
@@ -143,6 +177,7 @@ namespace AuroraFW {
 			/**
 			 * Saves the current audio stream (wheter it's empty, full or partially filled)
 			 * to the disk on the path specified in the constructor.
+			 * When streaming to disk, this flushes the frames still waiting for the disk writer.
 			 * @return <em>true</em> if the saving was successfull. <em>false</em> otherwise.
 			 * @since snapshot20180330
 			 */
@@ -162,6 +197,7 @@ namespace AuroraFW {
 
 			/**
 			 * The audio stream buffer, that is equal to the product of frames and the number of channels.
+			 * <em>nullptr</em> when streaming to disk.
 			 * @see bufferSize
 			 * @since snapshot20180330
 			 */
@@ -176,9 +212,42 @@ namespace AuroraFW {
 			const int bufferSize;
 
 		private:
+			void _startWriter();
+			void _stopWriter();
+			void _writerLoop();
+			bool _writeFrames(const float* , size_t );
+
 			PaStream* _paStream;
 			unsigned int _streamPosFrame = 0;
+
+			// Streaming to disk: the callback only pushes into the ring buffer,
+			// and a writer thread drains it into the file in large blocks
+			AudioRingBuffer<float>* _ringBuffer = nullptr;
+			std::thread _writerThread;
+			std::mutex _writerMutex;
+			std::condition_variable _writerCondition;
+			bool _writerRunning = false;
+			std::atomic<unsigned int> _overruns{0};
+			std::atomic<size_t> _droppedFrames{0};
+			std::atomic<size_t> _writtenFrames{0};
+			std::atomic<bool> _writeFailed{false};
 		};
+
+		// Inline definitions
+		inline unsigned int AudioIStream::getNumOverruns()
+		{
+			return _overruns.load(std::memory_order_relaxed);
+		}
+
+		inline size_t AudioIStream::getNumDroppedFrames()
+		{
+			return _droppedFrames.load(std::memory_order_relaxed);
+		}
+
+		inline size_t AudioIStream::getNumWrittenFrames()
+		{
+			return _writtenFrames.load(std::memory_order_relaxed);
+		}
 	}
 }
 
@@ -0,0 +1,199 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+/**
+ * @file AuroraFW/Audio/AudioLoader.h
+ * AudioLoader header. This contains the worker
+ * pool that loads audio files for buffered
+ * streams in the background.
+ * @since snapshot20180330
+ */
+
+#ifndef AURORAFW_AUDIO_AUDIOLOADER_H
+#define AURORAFW_AUDIO_AUDIOLOADER_H
+
+// AuroraFW
+#include <AuroraFW/Global.h>
+#if(AFW_TARGET_PRAGMA_ONCE_SUPPORT)
+	#pragma once
+#endif
+
+#include <AuroraFW/Audio/AudioCache.h>
+#include <AuroraFW/Audio/AudioUtils.h>
+#include <AuroraFW/Audio/AudioWorkerPool.h>
+
+// STD
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		/**
+		 * A struct containing the time spent loading an audio file.
+		 * @since snapshot20180330
+		 */
+		struct AFW_API AudioLoadMetrics {
+			/**
+			 * The path of the loaded file.
+			 * @since snapshot20180330
+			 */
+			std::string path;
+
+			/**
+			 * The milliseconds the load waited for a free worker.
+			 * @since snapshot20180330
+			 */
+			double queueTime = 0;
+
+			/**
+			 * The milliseconds spent opening the file and parsing its header.
+			 * @since snapshot20180330
+			 */
+			double openTime = 0;
+
+			/**
+			 * The milliseconds spent mapping or decoding the samples.
+			 * @since snapshot20180330
+			 */
+			double decodeTime = 0;
+
+			/**
+			 * The number of bytes of samples the load made available.
+			 * @since snapshot20180330
+			 */
+			size_t size = 0;
+
+			/**
+			 * Whether the samples were already in the AudioSampleCache.
+			 * @since snapshot20180330
+			 */
+			bool cacheHit = false;
+
+			/**
+			 * Whether the file was memory-mapped instead of decoded.
+			 * @since snapshot20180330
+			 */
+			bool mapped = false;
+		};
+
+		/**
+		 * A struct containing the samples of a loaded audio file.
+		 * Keeping it alive keeps the samples alive, so buffered streams created
+		 * afterwards for the same file don't load it again.
+		 * @since snapshot20180330
+		 */
+		struct AFW_API AudioLoadResult {
+			/**
+			 * The decoded samples. <em>nullptr</em> if the file was mapped instead.
+			 * @since snapshot20180330
+			 */
+			std::shared_ptr<const AudioSampleBuffer> sampleBuffer;
+
+			/**
+			 * The mapped file. <em>nullptr</em> if the file was decoded instead.
+			 * @since snapshot20180330
+			 */
+			std::shared_ptr<AudioMappedFile> mappedFile;
+
+			/**
+			 * The time spent loading the file.
+			 * @since snapshot20180330
+			 */
+			AudioLoadMetrics metrics;
+		};
+
+		/**
+		 * A class representing a pool of audio loading workers.
+		 * A class that opens and decodes (or maps) audio files on background threads,
+		 * so buffered streams can be prepared without blocking the calling thread.
+		 * Loading the same file twice while it's still pending returns the same future.
+		 * @see AudioBackend::getLoader()
+		 * @see AudioOStream::AudioOStream(const char* , const std::shared_future<AudioLoadResult>& , AudioSource* , size_t )
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioLoader {
+		public:
+			/**
+			 * Constructs an AudioLoader and starts its workers.
+			 * @param workers The number of worker threads. 0 uses one less than the number of
+			 * hardware threads, with a minimum of one. (default = 0)
+			 * @since snapshot20180330
+			 */
+			AudioLoader(unsigned int = 0);
+
+			/**
+			 * Destructs an AudioLoader, waiting for the loads in progress.
+			 * Loads still queued are abandoned, and their futures throw <em>std::future_error</em>.
+			 * @since snapshot20180330
+			 */
+			~AudioLoader();
+
+			AudioLoader(const AudioLoader& ) = delete;
+			AudioLoader& operator=(const AudioLoader& ) = delete;
+
+			/**
+			 * Queues an audio file to be loaded in the background.
+			 * @param path The path of the audio file.
+			 * @return A future that becomes ready once the file is loaded. Getting it throws
+			 * AudioFileNotFound if the file couldn't be opened.
+			 * @since snapshot20180330
+			 */
+			std::shared_future<AudioLoadResult> load(const char* );
+
+			/**
+			 * Gets the metrics of the last completed load of a file.
+			 * @param path The path of the audio file.
+			 * @param metrics Where to store the metrics.
+			 * @return <em>true</em> if the file was loaded already. <em>false</em> otherwise.
+			 * @since snapshot20180330
+			 */
+			bool getLoadMetrics(const char* , AudioLoadMetrics& ) const;
+
+			/**
+			 * Gets the metrics of every completed load, one per file.
+			 * @return The metrics of all the loaded files.
+			 * @since snapshot20180330
+			 */
+			std::vector<AudioLoadMetrics> getAllLoadMetrics() const;
+
+			/**
+			 * Gets the number of loads that haven't completed yet.
+			 * @return The number of queued and in progress loads.
+			 * @since snapshot20180330
+			 */
+			size_t getNumPending() const;
+
+		private:
+			void _run(const std::string& , double , std::promise<AudioLoadResult>& );
+			AudioLoadResult _load(const std::string& , double );
+
+			mutable std::mutex _mutex;
+			std::map<std::string, std::shared_future<AudioLoadResult>> _pending;
+			std::map<std::string, AudioLoadMetrics> _metrics;
+
+			// Last, so the workers stop before the maps they update go away
+			AudioWorkerPool _workers;
+		};
+	}
+}
+
+#endif // AURORAFW_AUDIO_AUDIOLOADER_H
@@ -0,0 +1,213 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+/**
+ * @file AuroraFW/Audio/AudioMetadata.h
+ * AudioMetadata header. This contains the metadata
+ * of audio files, read without opening them for
+ * playback, and the persistent index built by
+ * scanning directories of them.
+ * @since snapshot20180330
+ */
+
+#ifndef AURORAFW_AUDIO_AUDIOMETADATA_H
+#define AURORAFW_AUDIO_AUDIOMETADATA_H
+
+// AuroraFW
+#include <AuroraFW/Global.h>
+#if(AFW_TARGET_PRAGMA_ONCE_SUPPORT)
+	#pragma once
+#endif
+
+// LibSNDFile
+#include <sndfile.h>
+
+// STD
+#include <map>
+#include <string>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		/**
+		 * A struct holding the metadata of an audio file.
+		 * A struct with the technical information (format, samplerate, channels, frames)
+		 * and the strings (title, artist, album, etc...) of an audio file, filled by
+		 * probing the start of the file instead of opening it for playback.
+		 * @since snapshot20180330
+		 */
+		struct AFW_API AudioMetadata {
+			/**
+			 * The path of the audio file.
+			 * @since snapshot20180330
+			 */
+			std::string path;
+
+			/**
+			 * The <em>libsndfile</em> info of the audio file.
+			 * @since snapshot20180330
+			 */
+			SF_INFO info;
+
+			/**
+			 * The strings of the audio file, indexed by their <em>SF_STR_*</em> type minus
+			 * <em>SF_STR_FIRST</em>. Empty for the strings the file doesn't have.
+			 * @see getString(int )
+			 * @since snapshot20180330
+			 */
+			std::string strings[SF_STR_LAST - SF_STR_FIRST + 1];
+
+			/**
+			 * The modification time of the audio file when it was probed, in seconds since the epoch.
+			 * @since snapshot20180330
+			 */
+			long long modificationTime = 0;
+
+			/**
+			 * The nanoseconds of the modification time, so a file rewritten within the same second
+			 * is still seen as changed. Always 0 on platforms that only keep seconds.
+			 * @since snapshot20180330
+			 */
+			long modificationNanoseconds = 0;
+
+			/**
+			 * The size of the audio file in bytes when it was probed.
+			 * @since snapshot20180330
+			 */
+			long long fileSize = 0;
+
+			/**
+			 * Gets a string of the audio file.
+			 * @param type The <em>SF_STR_*</em> type of the string.
+			 * @return The string, or <em>nullptr</em> if the file doesn't have it.
+			 * @since snapshot20180330
+			 */
+			const char* getString(int ) const;
+
+			/**
+			 * Reads the metadata of an audio file with <em>sf_probe()</em>, which parses the
+			 * headers from a single small read of the start of the file.
+			 * @note FLAC and Ogg files still have their decoder set up, and Vorbis files are
+			 * read up to their last page for the length, so they probe about as slowly as
+			 * they open.
+			 * @param path The path of the audio file.
+			 * @param metadata Where to store the metadata.
+			 * @return <em>true</em> if the metadata was read. <em>false</em> if the file couldn't
+			 * be opened or isn't an audio file.
+			 * @since snapshot20180330
+			 */
+			static bool probe(const char* , AudioMetadata& );
+		};
+
+		/**
+		 * A class representing an index of audio file metadata.
+		 * A class that maps the path of each audio file found in a set of directories to
+		 * its metadata, so a library of audio files can be listed without opening them.
+		 * The index can be saved to a flat file and loaded back on the next run, after
+		 * which a scan only probes the files that changed in between.
+		 * @note It isn't thread-safe, though each scan probes the files on several threads.
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioMetadataIndex {
+		public:
+			/**
+			 * Scans a directory and brings the index up to date with the audio files in it.
+			 * Files whose modification time and size match their entry aren't probed again,
+			 * entries of files that were removed from the directory are dropped, and files
+			 * that aren't audio files are skipped.
+			 * @param directory The path of the directory.
+			 * @param recursive Whether the subdirectories are scanned too. (default = true)
+			 * @param workers The number of threads probing files, counting the calling one.
+			 * 0 uses the number of hardware threads. (default = 0)
+			 * @return The number of files probed, that is, audio files that are new or changed
+			 * since the last scan.
+			 * @since snapshot20180330
+			 */
+			size_t scan(const char* , bool = true, unsigned int = 0);
+
+			/**
+			 * Finds the metadata of an audio file.
+			 * @param path The path of the audio file, as it was found by scan().
+			 * @return The metadata, or <em>nullptr</em> if the file isn't in the index.
+			 * @since snapshot20180330
+			 */
+			const AudioMetadata* find(const char* ) const;
+
+			/**
+			 * Replaces the entries of the index with the ones saved in an index file.
+			 * The file is mapped in memory, so loading doesn't go through any audio file.
+			 * @param path The path of the index file.
+			 * @return <em>true</em> if the file was loaded. <em>false</em> if it couldn't be
+			 * read or isn't a valid index file, in which case the index is left untouched.
+			 * @see save(const char* )
+			 * @since snapshot20180330
+			 */
+			bool load(const char* );
+
+			/**
+			 * Saves the entries of the index to a file. The file is replaced atomically,
+			 * so a crash while saving leaves the previous one intact.
+			 * @param path The path of the index file.
+			 * @return <em>true</em> if the file was saved. <em>false</em> otherwise.
+			 * @see load(const char* )
+			 * @since snapshot20180330
+			 */
+			bool save(const char* ) const;
+
+			/**
+			 * Gets every entry of the index.
+			 * @return The metadata of each audio file, sorted by path.
+			 * @since snapshot20180330
+			 */
+			const std::map<std::string, AudioMetadata>& getEntries() const;
+
+			/**
+			 * Gets the number of audio files in the index.
+			 * @return The number of audio files.
+			 * @since snapshot20180330
+			 */
+			size_t size() const;
+
+			/**
+			 * Removes every entry from the index.
+			 * @since snapshot20180330
+			 */
+			void clear();
+
+		private:
+			std::map<std::string, AudioMetadata> _entries;
+		};
+
+		// Inline definitions
+		inline const std::map<std::string, AudioMetadata>& AudioMetadataIndex::getEntries() const
+		{
+			return _entries;
+		}
+
+		inline size_t AudioMetadataIndex::size() const
+		{
+			return _entries.size();
+		}
+
+		inline void AudioMetadataIndex::clear()
+		{
+			_entries.clear();
+		}
+	}
+}
+
+#endif // AURORAFW_AUDIO_AUDIOMETADATA_H
@@ -0,0 +1,177 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+/**
+ * @file AuroraFW/Audio/AudioMixer.h
+ * AudioMixer header. This contains the software mixer
+ * used to play many audio streams through a single
+ * output stream.
+ * @since snapshot20180330
+ */
+
+#ifndef AURORAFW_AUDIO_AUDIOMIXER_H
+#define AURORAFW_AUDIO_AUDIOMIXER_H
+
+// AuroraFW
+#include <AuroraFW/Global.h>
+#if(AFW_TARGET_PRAGMA_ONCE_SUPPORT)
+	#pragma once
+#endif
+
+#include <AuroraFW/Audio/AudioBackend.h>
+#include <AuroraFW/Audio/AudioUtils.h>
+
+// STD
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		struct AudioOStream;
+
+		/**
+		 * A class representing a software mixer. A class that opens a single output stream
+		 * and sums all the registered voices (AudioOStreams) into it on every callback.
+		 * It's owned by the AudioBackend, see AudioBackend::startMixer().
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioMixer {
+			friend struct AudioOStream;
+			friend int audioMixerCallback(const void* , void* , size_t ,
+			const PaStreamCallbackTimeInfo* , PaStreamCallbackFlags , void* );
+
+		public:
+			/**
+			 * Constructs an AudioMixer and starts its output stream on the default output device.
+			 * @param channels The number of output channels. (default = 2)
+			 * @throws PAErrorException In case there was a <em>PortAudio</em> error.
+			 * @since snapshot20180330
+			 */
+			AudioMixer(int = 2);
+
+			/**
+			 * Destructs an AudioMixer, stopping its output stream.
+			 * Voices still registered are detached and stopped. Playing them again opens an
+			 * output stream of their own, or makes them voices of the mixer running by then.
+			 * @since snapshot20180330
+			 */
+			~AudioMixer();
+
+			AudioMixer(const AudioMixer& ) = delete;
+			AudioMixer& operator=(const AudioMixer& ) = delete;
+
+			/**
+			 * Registers a voice on this mixer. It's mixed only while it's playing.
+			 * A mixer holds up to 256 voices, so the output callback never has to allocate.
+			 * @param voice The AudioOStream to be mixed.
+			 * @return <em>true</em> if the voice was registered. <em>false</em> if the mixer
+			 * already has 256 voices.
+			 * @note This is done automatically by AudioOStream when the mixer is running.
+			 * An AudioOStream the mixer can't take opens an output stream of its own instead.
+			 * @see removeVoice(AudioOStream* )
+			 * @since snapshot20180330
+			 */
+			bool addVoice(AudioOStream* );
+
+			/**
+			 * Unregisters a voice from this mixer. When this returns, the mixer no longer
+			 * accesses the voice, so it's safe to delete it.
+			 * @param voice The AudioOStream to be removed.
+			 * @see addVoice(AudioOStream* )
+			 * @since snapshot20180330
+			 */
+			void removeVoice(AudioOStream* );
+
+			/**
+			 * Gets the number of output channels of this mixer.
+			 * @return The number of output channels.
+			 * @since snapshot20180330
+			 */
+			int getChannels() const;
+
+			/**
+			 * Gets the sample rate of this mixer.
+			 * @return The sample rate of the output stream.
+			 * @since snapshot20180330
+			 */
+			double getSampleRate() const;
+
+			/**
+			 * Gets the current CPU load of the mixer's output stream.
+			 * @return A value ranging from 0 to 100 representing the mixer's CPU load.
+			 * @since snapshot20180330
+			 */
+			float getCpuLoad();
+
+		private:
+			enum class CommandType {
+				Add,
+				Remove,
+				Play,
+				Stop
+			};
+
+			struct Command {
+				CommandType type;
+				AudioOStream* voice;
+			};
+
+			struct Voice {
+				AudioOStream* stream;
+				bool playing;
+			};
+
+			void _sendCommand(CommandType , AudioOStream* , bool );
+			void _processCommands();
+			void _mixVoice(Voice& , float* , size_t );
+
+			const int _channels;
+			double _sampleRate;
+			PaStream* _paStream;
+
+			// Voices are only ever touched by the callback, the control
+			// threads talk to it through the command queue
+			AudioRingBuffer<Command> _commands;
+			std::mutex _commandsMutex;
+			size_t _commandsSent = 0;
+			size_t _voicesCount = 0;
+			std::atomic<size_t> _commandsProcessed{0};
+
+			std::vector<Voice> _voices;
+			float* _scratch;
+			float* _chunkGains;
+		};
+
+		int audioMixerCallback(const void* , void* , size_t ,
+		const PaStreamCallbackTimeInfo* , PaStreamCallbackFlags , void* );
+
+		// Inline definitions
+		inline int AudioMixer::getChannels() const
+		{
+			return _channels;
+		}
+
+		inline double AudioMixer::getSampleRate() const
+		{
+			return _sampleRate;
+		}
+	}
+}
+
+#endif // AURORAFW_AUDIO_AUDIOMIXER_H
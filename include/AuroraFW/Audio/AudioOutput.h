@@ -29,21 +29,21 @@
 // AuroraFW
 #include <AuroraFW/Global.h>
 #include <AuroraFW/Audio/AudioBackend.h>
+#include <AuroraFW/Audio/AudioCache.h>
+#include <AuroraFW/Audio/AudioLoader.h>
 #include <AuroraFW/Audio/AudioUtils.h>
+#include <AuroraFW/Audio/AudioMixer.h>
 #include <AuroraFW/Math/Algorithm.h>
 
+// STD
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 namespace AuroraFW {
 	namespace AudioManager {
 
-		/**
-		 * An enum to indicate the desired fallout type for 3D audio.
-		 * @since snapshot20180330
-		 */
-		enum class AudioFallout {
-			Linear,		/**< Linear function. */
-			Exponential	/**< Exponential function. */
-		};
-
 		/**
 		 * An enum to indicate the desired play mode for the audio stream.
 		 * @since snapshot20180330
@@ -72,6 +72,7 @@ namespace AuroraFW {
 		 * @since snapshot20180330
 		 */
 		struct AFW_API AudioSource {
+			friend struct AudioOStream;
 
 			/**
 			 * Constructs an AudioSource at (0, 0, 0) coordinates.
@@ -106,10 +107,17 @@ namespace AuroraFW {
 			AudioSource(const AudioSource& );
 
 			/**
-			 * The desired AudioFallout type
+			 * Destructs an AudioSource, removing it from the AudioListener.
 			 * @since snapshot20180330
 			 */
-			AudioFallout falloutType;
+			~AudioSource();
+
+			/**
+			 * The desired AudioFallout type. (default = Linear)
+			 * @note Call calculateValues() after changing it.
+			 * @since snapshot20180330
+			 */
+			AudioFallout falloutType = AudioFallout::Linear;
 
 			/**
 			 * Sets the position of the audio source.
@@ -122,6 +130,9 @@ namespace AuroraFW {
 			 * Sets the medium distance, specified in WU: it defines at which distance the sound
 			 * loses it's strength to 50%
 			 * @param medDistance The medium distance from the source's center.
+			 * 0 or less keeps the sound at full strength until the maximum distance.
+			 * @note With the exponential fallout the strength is rescaled to reach 0 at the maximum
+			 * distance, so it's a bit under 50% at the medium distance.
 			 * @see setMaxDistance(float )
 			 * @since snapshot20180330
 			 */
@@ -177,21 +188,23 @@ namespace AuroraFW {
 
 			/**
 			 * Notifies the system that the user changed some 3D values, and recalculates the 3D effect.
-			 * @note You only need to call this method if you changed any 3D value using local methods; the values given in the constructor are calculated automatically.
+			 * @note You only need to call this method if you changed any 3D value using local methods, or moved the AudioListener;
+			 * the values given in the constructor and setters are calculated automatically.
 			 * @since snapshot20180330
 			 */
 			void calculateValues();
 
 		private:
-			void _calculatePan();
-			void _calculateStrength();
+			friend class AudioListener;
 
-			Math::Vector3D _position;
-			float _medDistance;
-			float _maxDistance;
+			// The panning and strength are published together as a single
+			// atomic value, so the audio callback never sees half an update
+			void _publishGains(float , float );
+			void _loadGains(float& , float& ) const;
+			std::atomic<uint64_t> _gains{0};
 
-			float _strength = 1;
-			float _pan = 0;
+			// Index of this source's values in the AudioListener arrays
+			size_t _index;
 		};
 
 		/**
@@ -201,6 +214,7 @@ namespace AuroraFW {
 		 */
 		struct AFW_API AudioOStream {
 			friend struct AudioSource;
+			friend class AudioMixer;
 			friend int audioOutputCallback(const void* , void* , size_t ,
 			const PaStreamCallbackTimeInfo* , PaStreamCallbackFlags , void* );
 
@@ -215,13 +229,48 @@ namespace AuroraFW {
 			 * Constructs an AudioOStream with the specified file.
 			 * @param path The path of the file to be played. (including the file's extension)
 			 * @param audioSource An AudioSource object to add a 3D effect to this audio stream. (default = none)
-			 * @param buffered Specifies whether this audio stream should be pre-buffered on memory or streamed from disk. (default = false)
+			 * @param buffered Specifies whether this audio stream should be pre-buffered on memory or streamed from disk.
+			 * Uncompressed files are mapped in memory instead of being decoded upfront. (default = false)
+			 * @param streamBufferFrames The number of frames the decoder thread keeps ready when streaming from disk. Bigger values
+			 * survive longer disk stalls at the cost of memory. Ignored if the stream is buffered. (default = 16384)
+			 * @note If the AudioBackend's mixer is running, the stream is played through it instead of opening its own output stream.
 			 * @throws AudioFileNotFound In case it couldn't locate or read the audio file.
 			 * @throws PAErrorException In case there was a PortAudio error.
 			 * @see AudioOStream()
 			 * @since snapshot20180330
 			 */
-			AudioOStream(const char* , AudioSource* = nullptr, bool = false);
+			AudioOStream(const char* , AudioSource* = nullptr, bool = false, size_t = 16384);
+
+			/**
+			 * Constructs an AudioOStream with the audio file held in memory, without copying it.
+			 * @param memory The audio data, either a buffer owned by the caller or a region of a mapped pack file.
+			 * @param audioSource An AudioSource object to add a 3D effect to this audio stream. (default = none)
+			 * @param buffered Specifies whether this audio stream should be pre-buffered.
+			 * Uncompressed data is played in place instead of being decoded upfront. (default = false)
+			 * @param streamBufferFrames The number of frames the decoder thread keeps ready when streaming.
+			 * Ignored if the stream is buffered. (default = 16384)
+			 * @throws AudioFileNotFound In case the memory doesn't hold a readable audio file.
+			 * @throws PAErrorException In case there was a PortAudio error.
+			 * @see AudioMemoryFile
+			 * @since snapshot20180330
+			 */
+			AudioOStream(const std::shared_ptr<const AudioMemoryFile>& , AudioSource* = nullptr, bool = false, size_t = 16384);
+
+			/**
+			 * Constructs an AudioOStream with the specified file, loaded in the background.
+			 * The stream streams from disk until the load completes, and then switches to the
+			 * loaded samples at its current position, so play() can be called right away.
+			 * @param path The path of the file to be played. (including the file's extension)
+			 * @param load The pending load of the same file, see AudioLoader::load().
+			 * @param audioSource An AudioSource object to add a 3D effect to this audio stream. (default = none)
+			 * @param streamBufferFrames The number of frames the decoder thread keeps ready until the load completes. (default = 16384)
+			 * @note If the load fails, the stream keeps streaming from disk.
+			 * @throws AudioFileNotFound In case it couldn't locate or read the audio file.
+			 * @throws PAErrorException In case there was a PortAudio error.
+			 * @see isLoaded()
+			 * @since snapshot20180330
+			 */
+			AudioOStream(const char* , const std::shared_future<AudioLoadResult>& , AudioSource* = nullptr, size_t = 16384);
 
 			/**
 			 * Destruct an AudioOStream object.
@@ -231,6 +280,8 @@ namespace AuroraFW {
 
 			/**
 			 * Starts playing this audio stream.
+			 * When streaming, half of the stream buffer is decoded before the output
+			 * starts, so this reads from disk on the calling thread.
 			 * @throws PAErrorException In case there was a PortAudio error.
 			 * @see pause()
 			 * @see stop()
@@ -323,6 +374,22 @@ namespace AuroraFW {
 			 */
 			float getNumLoops();
 
+			/**
+			 * Gets the number of times the decoder thread couldn't keep up with playback.
+			 * Each underrun is heard as a gap of silence.
+			 * @return The number of underruns since the stream was created. Always 0 for buffered streams.
+			 * @since snapshot20180330
+			 */
+			unsigned int getNumUnderruns();
+
+			/**
+			 * Checks if this stream plays from memory. Streams loaded in the background
+			 * start returning <em>true</em> once they switched to the loaded samples.
+			 * @return <em>true</em> if the stream is buffered. <em>false</em> if it streams from disk.
+			 * @since snapshot20180330
+			 */
+			bool isLoaded();
+
 			/**
 			 * Gets the current CPU load this stream is causing.
 			 * @return A value ranging from 0 to 100 representing this stream's CPU load.
@@ -330,6 +397,20 @@ namespace AuroraFW {
 			 */
 			float getCpuLoad();
 
+			/**
+			 * Reads the stream's next frames into one array per channel instead of playing them,
+			 * so they can be processed channel by channel. Reading starts where play() would
+			 * start and moves the read position forward, looping in the <em>Loop</em> play mode.
+			 * Streams that stream from disk read the file directly, see AudioInfo::readPlanar().
+			 * @param planes One array per channel, each with room for the given number of frames.
+			 * @param frames The number of frames to read, without counting in the number of channels.
+			 * @return The number of frames actually read. The rest of the arrays is filled with silence.
+			 * Nothing is read while the stream plays. A stream that streams from disk also reads nothing
+			 * after play() until pause() or stop() is called, as its decoder thread uses the file.
+			 * @since snapshot20180330
+			 */
+			size_t readPlanar(float* const* , size_t );
+
 			/**
 			 * The stream's AudioPlayMode.
 			 * @since snapshot20180330
@@ -348,6 +429,13 @@ namespace AuroraFW {
 			 */
 			float volume = 1;
 
+			/**
+			 * The stream's panning, added to the AudioSource's one, if there's any.
+			 * Ranges from -1 (left ear only) to 1 (right ear only).
+			 * @since snapshot20180330
+			 */
+			float pan = 0;
+
 			#pragma message("TODO: Need to implement pitch")
 			/**
 			 * The stream's pitch. To be implemented...
@@ -356,11 +444,50 @@ namespace AuroraFW {
 			float pitch = 1;
 
 		private:
-			PaStream* _paStream;
-
-			float* _buffer = nullptr;
+			void _openOutput();
+			size_t _readFrames(float* , size_t , bool& );
+			void _calculateGains(float* , int , bool );
+
+			void _startDecoder();
+			void _stopDecoder();
+			void _decoderLoop();
+			bool _decodeChunk(float* , size_t );
+			bool _adoptLoad();
+
+			PaStream* _paStream = nullptr;
+
+			// Gains of the current and the previous buffer, the
+			// callback ramps between them to avoid zipper noise
+			float* _gains = nullptr;
+			float* _lastGains = nullptr;
+			bool _rampGains = false;
+
+			// Set when the stream is played through the AudioBackend's mixer
+			AudioMixer* _mixer = nullptr;
+			std::atomic<bool> _mixerPlaying{false};
+
+			// Buffered: a cursor over samples shared through the AudioSampleCache,
+			// or over the file's mapped pages
+			const float* _buffer = nullptr;
+			std::shared_ptr<const AudioSampleBuffer> _sampleBuffer;
+			std::shared_ptr<AudioMappedFile> _mappedFile;
 			unsigned int _streamPosFrame = 0;
 			uint8_t _loops = 0;
+
+			// Streaming: a decoder thread keeps the ring buffer filled, so the
+			// callback never touches the disk
+			AudioRingBuffer<float>* _ringBuffer = nullptr;
+			std::thread _decoderThread;
+			std::mutex _decoderMutex;
+			std::condition_variable _decoderCondition;
+			bool _decoderRunning = false;
+			std::atomic<bool> _decoderEOF{false};
+			std::atomic<unsigned int> _underruns{0};
+
+			// Background load: adopted by the decoder thread (or by play() while
+			// it's stopped) and published to the callback through _loadReady
+			std::shared_future<AudioLoadResult> _pendingLoad;
+			std::atomic<bool> _loadReady{false};
 			
 			AudioSource* _audioSource;
 		};
@@ -373,6 +500,16 @@ namespace AuroraFW {
 		{
 			return audioPlayMode == AudioPlayMode::Loop ? _loops : -1;
 		}
+
+		inline unsigned int AudioOStream::getNumUnderruns()
+		{
+			return _underruns.load(std::memory_order_relaxed);
+		}
+
+		inline bool AudioOStream::isLoaded()
+		{
+			return _ringBuffer == nullptr || _loadReady.load(std::memory_order_acquire);
+		}
 	}
 }
 
@@ -0,0 +1,168 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+/**
+ * @file AuroraFW/Audio/AudioTranscoder.h
+ * AudioTranscoder header. This contains the worker
+ * pool that converts batches of audio files from
+ * one format to another.
+ * @since snapshot20180330
+ */
+
+#ifndef AURORAFW_AUDIO_AUDIOTRANSCODER_H
+#define AURORAFW_AUDIO_AUDIOTRANSCODER_H
+
+// AuroraFW
+#include <AuroraFW/Global.h>
+#if(AFW_TARGET_PRAGMA_ONCE_SUPPORT)
+	#pragma once
+#endif
+
+#include <AuroraFW/Audio/AudioUtils.h>
+#include <AuroraFW/Audio/AudioWorkerPool.h>
+
+// STD
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		/**
+		 * A struct containing the outcome of transcoding an audio file.
+		 * @since snapshot20180330
+		 */
+		struct AFW_API AudioTranscodeResult {
+			/**
+			 * The path of the source file.
+			 * @since snapshot20180330
+			 */
+			std::string source;
+
+			/**
+			 * The path of the written file.
+			 * @since snapshot20180330
+			 */
+			std::string destination;
+
+			/**
+			 * The number of frames written.
+			 * @since snapshot20180330
+			 */
+			sf_count_t frames = 0;
+
+			/**
+			 * The milliseconds the file waited for a free worker.
+			 * @since snapshot20180330
+			 */
+			double queueTime = 0;
+
+			/**
+			 * The milliseconds spent opening, converting and closing both files.
+			 * @since snapshot20180330
+			 */
+			double transcodeTime = 0;
+		};
+
+		/**
+		 * A class representing a pool of audio transcoding workers.
+		 * A class that converts audio files to another format on background threads.
+		 * It's meant for large batches of short files: the workers and their sample
+		 * buffers are kept for the lifetime of the transcoder, so a file only pays for
+		 * opening, converting and closing.
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioTranscoder {
+		public:
+			/**
+			 * Constructs an AudioTranscoder and starts its workers.
+			 * @param workers The number of worker threads. 0 uses the number of
+			 * hardware threads, with a minimum of one. (default = 0)
+			 * @since snapshot20180330
+			 */
+			AudioTranscoder(unsigned int = 0);
+
+			/**
+			 * Destructs an AudioTranscoder, waiting for the files in progress.
+			 * Files still queued are abandoned, and their futures throw <em>std::future_error</em>.
+			 * @since snapshot20180330
+			 */
+			~AudioTranscoder();
+
+			AudioTranscoder(const AudioTranscoder& ) = delete;
+			AudioTranscoder& operator=(const AudioTranscoder& ) = delete;
+
+			/**
+			 * Queues an audio file to be transcoded in the background.
+			 * The written file keeps the sample rate, channels and strings of the source.
+			 * @param source The path of the audio file to read.
+			 * @param destination The path of the audio file to write.
+			 * @param format The <em>libSNDFile</em> format of the written file.
+			 * @return A future that becomes ready once the file is written. Getting it throws
+			 * AudioFileNotFound if the source couldn't be opened, or SNDFILEErrorException
+			 * if the destination couldn't be written.
+			 * @since snapshot20180330
+			 */
+			std::shared_future<AudioTranscodeResult> transcode(const char* , const char* , int );
+
+			/**
+			 * Queues a batch of audio files to be transcoded in the background.
+			 * @param files The source and destination path of each file.
+			 * @param format The <em>libSNDFile</em> format of the written files.
+			 * @return One future per file, in the same order.
+			 * @see transcode(const char* , const char* , int )
+			 * @since snapshot20180330
+			 */
+			std::vector<std::shared_future<AudioTranscodeResult>> transcode(
+				const std::vector<std::pair<std::string, std::string>>& , int );
+
+			/**
+			 * Blocks until every queued file has been transcoded.
+			 * @since snapshot20180330
+			 */
+			void wait();
+
+			/**
+			 * Gets the number of files that haven't been transcoded yet.
+			 * @return The number of queued and in progress files.
+			 * @since snapshot20180330
+			 */
+			size_t getNumPending() const;
+
+		private:
+			struct Buffers {
+				std::vector<int> samples;
+				std::vector<double> samplesDouble;
+			};
+
+			AudioWorkerPool::Task _task(const std::string& , const std::string& , int ,
+				std::shared_future<AudioTranscodeResult>& );
+			static AudioTranscodeResult _transcode(const std::string& , const std::string& , int ,
+				double , Buffers& );
+
+			// One per worker, kept across files so converting one doesn't allocate
+			std::vector<Buffers> _buffers;
+
+			// Last, so the workers stop before their buffers go away
+			AudioWorkerPool _workers;
+		};
+	}
+}
+
+#endif // AURORAFW_AUDIO_AUDIOTRANSCODER_H
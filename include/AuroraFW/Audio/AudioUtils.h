@@ -32,6 +32,7 @@
 #endif
 
 #include <AuroraFW/Internal/Config.h>
+#include <AuroraFW/Audio/AudioMetadata.h>
 
 // LibSNDFile
 #include <sndfile.h>
@@ -39,8 +40,82 @@
 // PortAudio
 #include <portaudio.h>
 
+// STD
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
 namespace AuroraFW {
 	namespace AudioManager {
+		/**
+		 * A class representing a read-only span of memory holding audio data.
+		 * A class that lets audio be opened straight from memory, either from a buffer owned
+		 * by the caller or from a region of a file mapped in memory, like an asset inside a
+		 * pack file. The data is never copied.
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioMemoryFile {
+		public:
+			/**
+			 * Constructs an AudioMemoryFile over a buffer owned by the caller.
+			 * @param data The first byte of the buffer.
+			 * @param size The size of the buffer in bytes.
+			 * @note The buffer isn't copied, so it must outlive the AudioMemoryFile and everything opened from it.
+			 * @since snapshot20180330
+			 */
+			AudioMemoryFile(const void* , sf_count_t );
+
+			/**
+			 * Maps a region of a file in memory.
+			 * @param path The path of the file.
+			 * @param offset Where the region starts, in bytes from the start of the file. (default = 0)
+			 * @param length The size of the region in bytes, clamped to the end of the file.
+			 * Negative values map until the end of the file. (default = -1)
+			 * @return A shared AudioMemoryFile. <em>nullptr</em> if the region is empty or couldn't be mapped.
+			 * @since snapshot20180330
+			 */
+			static std::shared_ptr<AudioMemoryFile> map(const char* , sf_count_t = 0, sf_count_t = -1);
+
+			/**
+			 * Destructs an AudioMemoryFile, unmapping the file region if it was mapped.
+			 * @since snapshot20180330
+			 */
+			~AudioMemoryFile();
+
+			AudioMemoryFile(const AudioMemoryFile& ) = delete;
+			AudioMemoryFile& operator=(const AudioMemoryFile& ) = delete;
+
+			/**
+			 * Gets the data.
+			 * @return A pointer to the first byte.
+			 * @since snapshot20180330
+			 */
+			const unsigned char* getData() const;
+
+			/**
+			 * Gets the size of the data.
+			 * @return The size in bytes.
+			 * @since snapshot20180330
+			 */
+			sf_count_t getSize() const;
+
+		private:
+			AudioMemoryFile() {}
+
+			const unsigned char* _data = nullptr;
+			sf_count_t _size = 0;
+
+			void* _mapping = nullptr;
+			size_t _mappingSize = 0;
+		#if defined(_WIN32)
+			void* _fileHandle = nullptr;
+			void* _mappingHandle = nullptr;
+		#endif
+		};
+
 		/**
 		 * A struct to hold audio info. A struct whose purpose is to store all the information
 		 * about an audio stream/file, either technical (samplerate, channels, etc...) or
@@ -61,12 +136,48 @@ namespace AuroraFW {
 			 */
 			AudioInfo(SF_INFO* = new SF_INFO(), SNDFILE* = nullptr);
 
+			/**
+			 * Constructs an AudioInfo object by opening the audio held in a buffer owned by the caller.
+			 * @param data The first byte of the buffer.
+			 * @param size The size of the buffer in bytes.
+			 * @note The buffer isn't copied, so it must outlive the AudioInfo.
+			 * @see isOpen()
+			 * @since snapshot20180330
+			 */
+			AudioInfo(const void* , sf_count_t );
+
+			/**
+			 * Constructs an AudioInfo object by opening the audio held in memory.
+			 * @param memory The audio data, see AudioMemoryFile::map() to open a region of a pack file.
+			 * @see isOpen()
+			 * @since snapshot20180330
+			 */
+			AudioInfo(const std::shared_ptr<const AudioMemoryFile>& );
+
+			/**
+			 * Constructs an AudioInfo object from the metadata of an audio file, like an entry of
+			 * an AudioMetadataIndex, without touching the file. The strings are taken from the
+			 * metadata until the file is opened.
+			 * @param metadata The metadata of the audio file.
+			 * @see AudioMetadataIndex::find(const char* )
+			 * @since snapshot20180330
+			 */
+			AudioInfo(const AudioMetadata& );
+
 			/**
 			 * Destructs an AudioInfo object.
 			 * @since snapshot20180330
 			 */
 			~AudioInfo();
 
+			/**
+			 * Checks if the audio file is open.
+			 * @return <em>true</em> if the audio file is open. <em>false</em> if it wasn't opened yet
+			 * or it couldn't be opened.
+			 * @since snapshot20180330
+			 */
+			bool isOpen() const;
+
 			/**
 			 * Gets the sample rate of the audio file.
 			 * @return The sample rate of the audio file.
@@ -296,11 +407,398 @@ namespace AuroraFW {
 			 * @since snapshot20180330
 			 */
 			void setGenre(const char* genre);
-		
+
+			/**
+			 * Sets the size of the read-ahead/write-behind buffer used for the audio file.
+			 * Bigger buffers turn many small reads and writes into a few large system calls,
+			 * which pays off the most on network filesystems. If the file isn't open yet,
+			 * the size is applied when a stream opens it. Streams use the file from their own
+			 * thread once playing or recording, so this should be called before that.
+			 * @param size The buffer size in bytes, or 0 to read and write the file unbuffered.
+			 * @see getIOBufferSize()
+			 * @since snapshot20180330
+			 */
+			void setIOBufferSize(const int );
+
+			/**
+			 * Gets the size of the read-ahead/write-behind buffer used for the audio file.
+			 * @return The buffer size in bytes, or -1 if the file isn't open and no size was set.
+			 * @see setIOBufferSize(const int )
+			 * @since snapshot20180330
+			 */
+			int getIOBufferSize() const;
+
+			/**
+			 * Gets the number of system calls and bytes moved for the audio file since it was opened.
+			 * @return The i/o counters, all zero if the file isn't open.
+			 * @since snapshot20180330
+			 */
+			SF_IO_STATS getIOStats() const;
+
+			/**
+			 * Sets how many buffer sized blocks of the audio file are read in the background,
+			 * ahead of what is being decoded, so that storage latency doesn't stall a stream.
+			 * Like the buffer size, it is applied when a stream opens the file if it isn't open yet.
+			 * @param blocks The number of blocks to read ahead, from 0 (disabled) up to 64.
+			 * @see getIOReadAhead()
+			 * @see setIOBufferSize(const int )
+			 * @since snapshot20180330
+			 */
+			void setIOReadAhead(const int );
+
+			/**
+			 * Gets how many blocks of the audio file are read in the background.
+			 * @return The number of blocks, or -1 if the file isn't open and nothing was set.
+			 * @see setIOReadAhead(const int )
+			 * @since snapshot20180330
+			 */
+			int getIOReadAhead() const;
+
+			/**
+			 * Reads frames from the audio file into one array per channel.
+			 * Files storing each channel separately are read straight into the arrays,
+			 * the others are deinterleaved a few thousand samples at a time.
+			 * @param planes One array per channel, each with room for the given number of frames.
+			 * @param frames The number of frames to read, without counting in the number of channels.
+			 * @return The number of frames actually read. The rest of the arrays is filled with silence.
+			 * @see writePlanar(const float* const* , sf_count_t )
+			 * @since snapshot20180330
+			 */
+			sf_count_t readPlanar(float* const* , sf_count_t );
+
+			/**
+			 * Writes frames held in one array per channel to the audio file.
+			 * @param planes One array per channel, each holding the given number of frames.
+			 * @param frames The number of frames to write, without counting in the number of channels.
+			 * @return The number of frames actually written.
+			 * @see readPlanar(float* const* , sf_count_t )
+			 * @since snapshot20180330
+			 */
+			sf_count_t writePlanar(const float* const* , sf_count_t );
+
 		private:
+			void _applyIOSettings();
+			const char* _getString(int ) const;
+			bool _openMemory(const std::shared_ptr<const AudioMemoryFile>& );
+
+			static sf_count_t _memoryGetFileLength(void* );
+			static sf_count_t _memorySeek(sf_count_t , int , void* );
+			static sf_count_t _memoryRead(void* , sf_count_t , void* );
+			static sf_count_t _memoryWrite(const void* , sf_count_t , void* );
+			static sf_count_t _memoryTell(void* );
+
 			SF_INFO* _sndInfo;
 			SNDFILE* _sndFile;
+			int _ioBufferSize;
+			int _ioReadAhead;
+
+			// Set when the file is opened from memory, the read cursor is just an offset
+			std::shared_ptr<const AudioMemoryFile> _memory;
+			sf_count_t _memoryPosition = 0;
+
+			// Set when constructed from an index entry, holds the strings while no file is open
+			std::shared_ptr<const AudioMetadata> _metadata;
 		};
+
+		/**
+		 * A class representing the audio data of an uncompressed file mapped in memory.
+		 * A class that allows buffered streams to play PCM and float files straight from
+		 * the file's pages, converting samples on demand. Streams that open the same
+		 * file share the same mapping.
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioMappedFile {
+		public:
+			/**
+			 * Maps the audio data of the given file, or reuses an existing mapping of it.
+			 * A mapping is only reused while the file keeps the modification time and size
+			 * it had when it was mapped, and its audio data the same position and format.
+			 * @param path The path of the audio file.
+			 * @param sndFile The <em>libsndfile</em> file object of the opened file.
+			 * @param sndInfo The <em>libsndfile</em> info object of the opened file.
+			 * @return A shared AudioMappedFile. <em>nullptr</em> if the file isn't uncompressed
+			 * PCM/float or couldn't be mapped.
+			 * @since snapshot20180330
+			 */
+			static std::shared_ptr<AudioMappedFile> open(const char* , SNDFILE* , const SF_INFO* );
+
+			/**
+			 * Reads the audio data of a file held in memory in place.
+			 * @param memory The memory the file was opened from.
+			 * @param sndFile The <em>libsndfile</em> file object of the opened file.
+			 * @param sndInfo The <em>libsndfile</em> info object of the opened file.
+			 * @return A new AudioMappedFile sharing the memory. <em>nullptr</em> if the file isn't
+			 * uncompressed PCM/float.
+			 * @since snapshot20180330
+			 */
+			static std::shared_ptr<AudioMappedFile> open(const std::shared_ptr<const AudioMemoryFile>& , SNDFILE* , const SF_INFO* );
+
+			/**
+			 * Destructs an AudioMappedFile, unmapping the file once nothing else shares its memory.
+			 * @since snapshot20180330
+			 */
+			~AudioMappedFile();
+
+			AudioMappedFile(const AudioMappedFile& ) = delete;
+			AudioMappedFile& operator=(const AudioMappedFile& ) = delete;
+
+			/**
+			 * Reads frames from the mapping, converting them to interleaved floats.
+			 * @param output Where to store the converted frames.
+			 * @param frame The first frame to read.
+			 * @param frames The number of frames to read, without counting in the number of channels.
+			 * @return The number of frames actually read.
+			 * @since snapshot20180330
+			 */
+			size_t read(float* , sf_count_t , size_t ) const;
+
+			/**
+			 * Gets the number of frames in the mapping.
+			 * @return The number of frames, without counting in the number of channels.
+			 * @since snapshot20180330
+			 */
+			sf_count_t getFrames() const;
+
+			/**
+			 * Gets the number of bytes of audio data in the mapping.
+			 * @return The size of the mapped samples, in their stored format.
+			 * @since snapshot20180330
+			 */
+			sf_count_t getSize() const;
+
+			/**
+			 * Checks if the mapped samples are already 32-bit floats in the CPU's byte order,
+			 * so they are copied without any conversion.
+			 * @return <em>true</em> if no conversion is needed. <em>false</em> otherwise.
+			 * @since snapshot20180330
+			 */
+			bool isNativeFloat() const;
+
+		private:
+			AudioMappedFile() {}
+
+			struct Key {
+				std::string path;
+				long long modificationTime;
+				long long fileSize;
+
+				bool operator<(const Key& ) const;
+			};
+
+			static std::shared_ptr<AudioMappedFile> _create(SNDFILE* , const SF_INFO* , SF_RAW_DATA_INFO& );
+			bool _use(const std::shared_ptr<const AudioMemoryFile>& , sf_count_t , sf_count_t );
+			bool _hasLayoutOf(const AudioMappedFile& ) const;
+
+			std::shared_ptr<const AudioMemoryFile> _memory;
+			const unsigned char* _data = nullptr;
+
+			sf_count_t _frames = 0;
+			sf_count_t _offset = 0;
+			sf_count_t _length = 0;
+			int _channels = 0;
+			int _codec = 0;
+			int _byteWidth = 0;
+			bool _endswap = false;
+			bool _littleEndian = true;
+
+			static std::mutex _filesMutex;
+			static std::map<Key, std::weak_ptr<AudioMappedFile>> _files;
+		};
+
+		/**
+		 * A lock-free single-producer/single-consumer ring buffer. A class used to pass
+		 * audio data between a worker thread and a real-time callback without locking.
+		 * Only one thread may write to it and only one thread may read from it.
+		 * @since snapshot20180330
+		 */
+		template<typename T>
+		class AudioRingBuffer {
+		public:
+			/**
+			 * Constructs a ring buffer able to hold, at least, the given number of elements.
+			 * @param capacity The minimum capacity. It's rounded up to the next power of two.
+			 * @since snapshot20180330
+			 */
+			AudioRingBuffer(size_t );
+
+			/**
+			 * Destructs a ring buffer.
+			 * @since snapshot20180330
+			 */
+			~AudioRingBuffer();
+
+			AudioRingBuffer(const AudioRingBuffer& ) = delete;
+			AudioRingBuffer& operator=(const AudioRingBuffer& ) = delete;
+
+			/**
+			 * Writes up to the given number of elements into the ring buffer.
+			 * @param data The elements to write.
+			 * @param count The number of elements to write.
+			 * @return The number of elements actually written.
+			 * @note Must only be called from the producer thread.
+			 * @since snapshot20180330
+			 */
+			size_t write(const T* , size_t );
+
+			/**
+			 * Reads up to the given number of elements from the ring buffer.
+			 * @param data Where to store the read elements.
+			 * @param count The number of elements to read.
+			 * @return The number of elements actually read.
+			 * @note Must only be called from the consumer thread.
+			 * @since snapshot20180330
+			 */
+			size_t read(T* , size_t );
+
+			/**
+			 * Gets the number of elements ready to be read.
+			 * @return The number of elements ready to be read.
+			 * @see getWriteAvailable()
+			 * @since snapshot20180330
+			 */
+			size_t getReadAvailable() const;
+
+			/**
+			 * Gets the number of elements that can be written without overwriting unread data.
+			 * @return The number of free elements.
+			 * @see getReadAvailable()
+			 * @since snapshot20180330
+			 */
+			size_t getWriteAvailable() const;
+
+			/**
+			 * Gets the total capacity of the ring buffer.
+			 * @return The number of elements the ring buffer can hold.
+			 * @since snapshot20180330
+			 */
+			size_t getCapacity() const;
+
+			/**
+			 * Discards all the unread data.
+			 * @warning This is not thread-safe, neither the producer nor the consumer can be active while clearing.
+			 * @since snapshot20180330
+			 */
+			void clear();
+
+		private:
+			T* _data;
+			size_t _capacity;
+			size_t _mask;
+
+			// Both indexes grow forever and are masked on access, the padding
+			// keeps them on separate cache lines
+			std::atomic<size_t> _writeIndex;
+			char _padding[64 - sizeof(std::atomic<size_t>)];
+			std::atomic<size_t> _readIndex;
+		};
+
+		// Inline definitions
+		inline const unsigned char* AudioMemoryFile::getData() const
+		{
+			return _data;
+		}
+
+		inline sf_count_t AudioMemoryFile::getSize() const
+		{
+			return _size;
+		}
+
+		inline bool AudioInfo::isOpen() const
+		{
+			return _sndFile != nullptr;
+		}
+
+		inline sf_count_t AudioMappedFile::getFrames() const
+		{
+			return _frames;
+		}
+
+		inline sf_count_t AudioMappedFile::getSize() const
+		{
+			return _frames * _channels * _byteWidth;
+		}
+
+		template<typename T>
+		AudioRingBuffer<T>::AudioRingBuffer(size_t capacity)
+			: _capacity(1), _writeIndex(0), _readIndex(0)
+		{
+			while(_capacity < capacity)
+				_capacity <<= 1;
+
+			_mask = _capacity - 1;
+			_data = AFW_NEW T[_capacity];
+		}
+
+		template<typename T>
+		AudioRingBuffer<T>::~AudioRingBuffer()
+		{
+			delete[] _data;
+		}
+
+		template<typename T>
+		size_t AudioRingBuffer<T>::write(const T* data, size_t count)
+		{
+			const size_t writeIndex = _writeIndex.load(std::memory_order_relaxed);
+			const size_t readIndex = _readIndex.load(std::memory_order_acquire);
+
+			const size_t available = _capacity - (writeIndex - readIndex);
+			if(count > available)
+				count = available;
+
+			// Copies in two parts in case the data wraps around the end
+			const size_t start = writeIndex & _mask;
+			const size_t firstPart = count < _capacity - start ? count : _capacity - start;
+			std::memcpy(_data + start, data, firstPart * sizeof(T));
+			std::memcpy(_data, data + firstPart, (count - firstPart) * sizeof(T));
+
+			_writeIndex.store(writeIndex + count, std::memory_order_release);
+			return count;
+		}
+
+		template<typename T>
+		size_t AudioRingBuffer<T>::read(T* data, size_t count)
+		{
+			const size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+			const size_t writeIndex = _writeIndex.load(std::memory_order_acquire);
+
+			const size_t available = writeIndex - readIndex;
+			if(count > available)
+				count = available;
+
+			const size_t start = readIndex & _mask;
+			const size_t firstPart = count < _capacity - start ? count : _capacity - start;
+			std::memcpy(data, _data + start, firstPart * sizeof(T));
+			std::memcpy(data + firstPart, _data, (count - firstPart) * sizeof(T));
+
+			_readIndex.store(readIndex + count, std::memory_order_release);
+			return count;
+		}
+
+		template<typename T>
+		size_t AudioRingBuffer<T>::getReadAvailable() const
+		{
+			return _writeIndex.load(std::memory_order_acquire)
+			- _readIndex.load(std::memory_order_acquire);
+		}
+
+		template<typename T>
+		size_t AudioRingBuffer<T>::getWriteAvailable() const
+		{
+			return _capacity - getReadAvailable();
+		}
+
+		template<typename T>
+		size_t AudioRingBuffer<T>::getCapacity() const
+		{
+			return _capacity;
+		}
+
+		template<typename T>
+		void AudioRingBuffer<T>::clear()
+		{
+			_readIndex.store(_writeIndex.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+		}
 	}
 }
 
@@ -0,0 +1,154 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+/**
+ * @file AuroraFW/Audio/AudioWorkerPool.h
+ * AudioWorkerPool header. This contains the
+ * worker threads and task queue shared by the
+ * AudioLoader and the AudioTranscoder.
+ * @since snapshot20180330
+ */
+
+#ifndef AURORAFW_AUDIO_AUDIOWORKERPOOL_H
+#define AURORAFW_AUDIO_AUDIOWORKERPOOL_H
+
+// AuroraFW
+#include <AuroraFW/Global.h>
+#if(AFW_TARGET_PRAGMA_ONCE_SUPPORT)
+	#pragma once
+#endif
+
+// STD
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		/**
+		 * A class representing a pool of worker threads.
+		 * A class that runs queued tasks on a fixed set of threads, kept for the lifetime
+		 * of the pool. Tasks run in the order they were queued.
+		 * @see AudioLoader
+		 * @see AudioTranscoder
+		 * @since snapshot20180330
+		 */
+		class AFW_API AudioWorkerPool {
+		public:
+			/**
+			 * A task run by a worker. It gets the index of the worker running it, from 0 to
+			 * getNumWorkers() - 1, and the milliseconds it waited in the queue.
+			 * Tasks must not throw.
+			 * @since snapshot20180330
+			 */
+			typedef std::function<void(unsigned int, double)> Task;
+
+			/**
+			 * Constructs an AudioWorkerPool and starts its workers.
+			 * @param workers The number of worker threads. 0 uses the number of hardware
+			 * threads less <em>reserved</em>, with a minimum of one.
+			 * @param reserved The hardware threads left to the rest of the program when
+			 * <em>workers</em> is 0. (default = 0)
+			 * @since snapshot20180330
+			 */
+			AudioWorkerPool(unsigned int , unsigned int = 0);
+
+			/**
+			 * Destructs an AudioWorkerPool, waiting for the tasks in progress.
+			 * Tasks still queued are destroyed without running.
+			 * @since snapshot20180330
+			 */
+			~AudioWorkerPool();
+
+			AudioWorkerPool(const AudioWorkerPool& ) = delete;
+			AudioWorkerPool& operator=(const AudioWorkerPool& ) = delete;
+
+			/**
+			 * Queues a task.
+			 * @param task The task to run.
+			 * @since snapshot20180330
+			 */
+			void push(Task );
+
+			/**
+			 * Queues a batch of tasks under a single lock, so the workers don't wake up
+			 * once per task.
+			 * @param tasks The tasks to run, in order. It's left empty.
+			 * @since snapshot20180330
+			 */
+			void push(std::vector<Task>& );
+
+			/**
+			 * Blocks until every queued task has run.
+			 * @since snapshot20180330
+			 */
+			void wait();
+
+			/**
+			 * Gets the number of tasks that haven't run yet.
+			 * @return The number of queued and running tasks.
+			 * @since snapshot20180330
+			 */
+			size_t getNumPending() const;
+
+			/**
+			 * Gets the number of worker threads.
+			 * @return The number of workers.
+			 * @since snapshot20180330
+			 */
+			unsigned int getNumWorkers() const;
+
+			/**
+			 * Gets the milliseconds between two points in time.
+			 * @param begin The earlier point.
+			 * @param end The later point.
+			 * @return The milliseconds from <em>begin</em> to <em>end</em>.
+			 * @since snapshot20180330
+			 */
+			static double millisecondsBetween(std::chrono::steady_clock::time_point ,
+				std::chrono::steady_clock::time_point );
+
+		private:
+			struct Job {
+				Task task;
+				std::chrono::steady_clock::time_point queuedAt;
+			};
+
+			void _workerLoop(unsigned int );
+
+			std::vector<std::thread> _workers;
+			mutable std::mutex _mutex;
+			std::condition_variable _condition;
+			std::condition_variable _idle;
+			std::deque<Job> _jobs;
+			size_t _active = 0;
+			bool _running = true;
+		};
+
+		inline unsigned int AudioWorkerPool::getNumWorkers() const
+		{
+			return static_cast<unsigned int>(_workers.size());
+		}
+	}
+}
+
+#endif // AURORAFW_AUDIO_AUDIOWORKERPOOL_H
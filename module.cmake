@@ -41,3 +41,13 @@ endif()
 target_link_libraries(aurorafw-audio aurorafw-core aurorafw-cli ${PortAudio_LIBRARIES} ${sndfile_LIBRARIES})
 
 set_target_properties(aurorafw-audio PROPERTIES OUTPUT_NAME aurorafw-audio)
+
+option(AURORAFW_MODULE_AUDIO_BENCH "Build the audio module benchmarks" OFF)
+if(AURORAFW_MODULE_AUDIO_BENCH)
+	file(GLOB AURORAFW_MODULE_AUDIO_BENCH_SOURCE ${AURORAFW_MODULE_AUDIO_DIR}/bench/*.cpp)
+	foreach(AURORAFW_MODULE_AUDIO_BENCH_FILE ${AURORAFW_MODULE_AUDIO_BENCH_SOURCE})
+		get_filename_component(AURORAFW_MODULE_AUDIO_BENCH_NAME ${AURORAFW_MODULE_AUDIO_BENCH_FILE} NAME_WE)
+		add_executable(aurorafw-audio-bench-${AURORAFW_MODULE_AUDIO_BENCH_NAME} ${AURORAFW_MODULE_AUDIO_BENCH_FILE})
+		target_link_libraries(aurorafw-audio-bench-${AURORAFW_MODULE_AUDIO_BENCH_NAME} aurorafw-audio ${sndfile_LIBRARIES})
+	endforeach()
+endif()
@@ -17,6 +17,13 @@
 ****************************************************************************/
 
 #include <AuroraFW/Audio/AudioBackend.h>
+#include <AuroraFW/Audio/AudioCache.h>
+#include <AuroraFW/Audio/AudioLoader.h>
+#include <AuroraFW/Audio/AudioMixer.h>
+#include <AuroraFW/Audio/AudioOutput.h>
+
+// STD
+#include <cmath>
 
 namespace AuroraFW {
 	namespace AudioManager {
@@ -48,6 +55,69 @@ namespace AuroraFW {
 			return "The AudioBackend was not initialized yet!";
 		}
 
+		// Exponential fallout table, holds 2^-x from 0 to exponentialTableRange,
+		// so updating many sources doesn't call pow for each one of them
+		static const int exponentialTableSize = 512;
+		static const float exponentialTableRange = 16.0f;
+
+		struct ExponentialTable {
+			ExponentialTable()
+			{
+				for(int i = 0; i <= exponentialTableSize; i++)
+					values[i] = std::pow(2.0f, -i * exponentialTableRange / exponentialTableSize);
+			}
+
+			float values[exponentialTableSize + 1];
+		};
+
+		static const ExponentialTable exponentialTable;
+
+		static inline float exponentialFallout(float x)
+		{
+			// Beyond the table's range the sound is already inaudible
+			if(x >= exponentialTableRange)
+				return 0;
+
+			const float position = x * (exponentialTableSize / exponentialTableRange);
+			const int index = static_cast<int>(position);
+			const float fraction = position - index;
+			return exponentialTable.values[index] + fraction
+			* (exponentialTable.values[index + 1] - exponentialTable.values[index]);
+		}
+
+		static inline float calculateStrength(float distance, float medDistance,
+			float maxDistance, AudioFallout fallout)
+		{
+			// The medium distance can't go past the maximum one
+			if(medDistance > maxDistance)
+				medDistance = maxDistance;
+
+			if(distance >= maxDistance)
+				return 0;
+
+			// Without a medium distance there's nothing to fall off over,
+			// the source plays at full strength until the maximum distance
+			if(medDistance <= 0)
+				return 1;
+
+			switch(fallout) {
+				case AudioFallout::Linear:
+					// Goes from 1 to 0.5 until the medium distance,
+					// and from there to 0 until the maximum distance
+					if(distance <= medDistance)
+						return 1 - 0.5f * distance / medDistance;
+					return 0.5f - 0.5f * (distance - medDistance) / (maxDistance - medDistance);
+				case AudioFallout::Exponential: {
+					// Halves the strength every medium distance, shifted and rescaled
+					// so it reaches 0 at the maximum distance instead of cutting off there
+					const float cutoff = exponentialFallout(maxDistance / medDistance);
+					return (exponentialFallout(distance / medDistance) - cutoff) / (1 - cutoff);
+				}
+			}
+
+			return 1;
+		}
+
 		// AudioListener
 		AudioListener* AudioListener::_instance = nullptr;
 
@@ -59,6 +129,7 @@ namespace AuroraFW {
 		void AudioListener::_stop()
 		{
 			delete _instance;
+			_instance = nullptr;
 		}
 
 		AudioListener& AudioListener::getInstance()
@@ -68,6 +139,102 @@ namespace AuroraFW {
 			return *_instance;
 		}
 
+		void AudioListener::update()
+		{
+			_updateSources(0, _sources.size());
+		}
+
+		size_t AudioListener::getNumSources() const
+		{
+			return _sources.size();
+		}
+
+		size_t AudioListener::_addSource(AudioSource* source, const Math::Vector3D& position,
+			float medDistance, float maxDistance, AudioFallout fallout)
+		{
+			_sources.push_back(source);
+			_sourceX.push_back(position.x);
+			_sourceY.push_back(position.y);
+			_sourceZ.push_back(position.z);
+			_sourceMedDistance.push_back(medDistance);
+			_sourceMaxDistance.push_back(maxDistance);
+			_sourceFallout.push_back(fallout);
+			_sourceDistance.push_back(0);
+			_sourcePan.push_back(0);
+			_sourceStrength.push_back(1);
+
+			return _sources.size() - 1;
+		}
+
+		void AudioListener::_removeSource(size_t index)
+		{
+			// Moves the last source to the removed one's place
+			const size_t last = _sources.size() - 1;
+			if(index != last) {
+				_sources[index] = _sources[last];
+				_sourceX[index] = _sourceX[last];
+				_sourceY[index] = _sourceY[last];
+				_sourceZ[index] = _sourceZ[last];
+				_sourceMedDistance[index] = _sourceMedDistance[last];
+				_sourceMaxDistance[index] = _sourceMaxDistance[last];
+				_sourceFallout[index] = _sourceFallout[last];
+				_sourceDistance[index] = _sourceDistance[last];
+				_sourcePan[index] = _sourcePan[last];
+				_sourceStrength[index] = _sourceStrength[last];
+
+				_sources[index]->_index = index;
+			}
+
+			_sources.pop_back();
+			_sourceX.pop_back();
+			_sourceY.pop_back();
+			_sourceZ.pop_back();
+			_sourceMedDistance.pop_back();
+			_sourceMaxDistance.pop_back();
+			_sourceFallout.pop_back();
+			_sourceDistance.pop_back();
+			_sourcePan.pop_back();
+			_sourceStrength.pop_back();
+		}
+
+		void AudioListener::_updateSources(size_t begin, size_t end)
+		{
+			// The panning is the projection of the direction to the source
+			// on the listener's right vector
+			Math::Vector3D right(direction.y * up.z - direction.z * up.y,
+			direction.z * up.x - direction.x * up.z,
+			direction.x * up.y - direction.y * up.x);
+			right.normalize();
+
+			const float listenerX = position.x, listenerY = position.y, listenerZ = position.z;
+			const float rightX = right.x, rightY = right.y, rightZ = right.z;
+
+			const float* x = _sourceX.data();
+			const float* y = _sourceY.data();
+			const float* z = _sourceZ.data();
+			float* distances = _sourceDistance.data();
+			float* pans = _sourcePan.data();
+			for(size_t i = begin; i < end; i++) {
+				const float dx = x[i] - listenerX;
+				const float dy = y[i] - listenerY;
+				const float dz = z[i] - listenerZ;
+				const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+				const float projection = rightX * dx + rightY * dy + rightZ * dz;
+
+				distances[i] = distance;
+				pans[i] = distance > 0 ? projection / distance : 0;
+			}
+
+			float* strengths = _sourceStrength.data();
+			for(size_t i = begin; i < end; i++) {
+				strengths[i] = calculateStrength(distances[i], _sourceMedDistance[i],
+				_sourceMaxDistance[i], _sourceFallout[i]);
+			}
+
+			for(size_t i = begin; i < end; i++)
+				_sources[i]->_publishGains(pans[i], strengths[i]);
+		}
+
 		// AudioDevice
 		AudioDevice::AudioDevice()
 			: _deviceInfo(Pa_GetDeviceInfo(Pa_GetDefaultOutputDevice())) {}
@@ -151,6 +318,8 @@ namespace AuroraFW {
 			_numOutputDevices = _calcNumOutputDevices();
 			_numInputDevices = _calcNumInputDevices();
 
+			_sampleCache = new AudioSampleCache();
+
 			// Prints verbose
 			AuroraFW::DebugManager::Log("AudioBackend initialized. Num. of "
 			"available audio devices: ", _numDevices, " (",
@@ -225,9 +394,18 @@ namespace AuroraFW {
 		{
 			// Safe guard in case someone terminates it when it's already deleted
 			if(_instance != nullptr) {
+				// The workers use the sample cache, so they are stopped first
+				delete _instance->_loader;
+
+				// The mixer's stream must be closed before PortAudio goes away
+				_instance->stopMixer();
+
 				// Stops PortAudio
 				catchPAProblem(Pa_Terminate());
 
+				// Streams still alive keep their own references to the samples
+				delete _instance->_sampleCache;
+
 				// Deletes the instance (in case it will be reused again)
 				delete _instance;
 				_instance = nullptr;
@@ -292,5 +470,40 @@ namespace AuroraFW {
 		{
 			#pragma message ("TODO: Need to be implemented")
 		}
+
+		void AudioBackend::startMixer(int channels)
+		{
+			if(_mixer == nullptr) {
+				_mixer = AFW_NEW AudioMixer(channels);
+			} else {
+				CLI::Log(CLI::Warning, "The AudioMixer was already started. "
+				"This method shouldn't be called twice!");
+			}
+		}
+
+		void AudioBackend::stopMixer()
+		{
+			if(_mixer != nullptr) {
+				delete _mixer;
+				_mixer = nullptr;
+			}
+		}
+
+		AudioMixer* AudioBackend::getMixer()
+		{
+			return _mixer;
+		}
+
+		AudioSampleCache& AudioBackend::getSampleCache()
+		{
+			return *_sampleCache;
+		}
+
+		AudioLoader& AudioBackend::getLoader()
+		{
+			if(_loader == nullptr)
+				_loader = new AudioLoader();
+			return *_loader;
+		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,209 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+#include <AuroraFW/Audio/AudioCache.h>
+#include <AuroraFW/Core/DebugManager.h>
+
+#include <sys/stat.h>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		// AudioSampleBuffer
+		AudioSampleBuffer::AudioSampleBuffer(sf_count_t frames, int channels)
+			: _samples(AFW_NEW float[frames * channels]()), _frames(frames), _channels(channels)
+		{}
+
+		AudioSampleBuffer::~AudioSampleBuffer()
+		{
+			delete[] _samples;
+		}
+
+		// AudioSampleCache
+		bool AudioSampleCache::Key::operator<(const Key& other) const
+		{
+			if(path != other.path)
+				return path < other.path;
+			if(modificationTime != other.modificationTime)
+				return modificationTime < other.modificationTime;
+			return fileSize < other.fileSize;
+		}
+
+		AudioSampleCache::AudioSampleCache(size_t budget)
+			: _budget(budget)
+		{}
+
+		std::shared_ptr<const AudioSampleBuffer> AudioSampleCache::load(const char* path, SNDFILE* sndFile, const SF_INFO* sndInfo, bool* cacheHit)
+		{
+			if(cacheHit != nullptr)
+				*cacheHit = true;
+
+			// Files that can't be stat'ed, or don't come from a path, are decoded without being cached
+			Key key = {path != nullptr ? path : "", 0, 0};
+			struct stat fileStat;
+			const bool cacheable = path != nullptr && stat(path, &fileStat) == 0;
+			if(cacheable) {
+				key.modificationTime = fileStat.st_mtime;
+				key.fileSize = fileStat.st_size;
+
+				std::lock_guard<std::mutex> lock(_mutex);
+				std::map<Key, Entry>::iterator it = _entries.find(key);
+				if(it != _entries.end()) {
+					std::shared_ptr<const AudioSampleBuffer> buffer = it->second.buffer;
+					if(buffer != nullptr) {
+						_lru.splice(_lru.begin(), _lru, it->second.lruPosition);
+						_hits.fetch_add(1, std::memory_order_relaxed);
+						return buffer;
+					}
+
+					// Evicted already, but some stream is still playing it
+					buffer = it->second.weakBuffer.lock();
+					if(buffer != nullptr) {
+						it->second.buffer = buffer;
+						_cache(it);
+						_evict();
+						_hits.fetch_add(1, std::memory_order_relaxed);
+						return buffer;
+					}
+				}
+			}
+
+			_misses.fetch_add(1, std::memory_order_relaxed);
+			if(cacheHit != nullptr)
+				*cacheHit = false;
+
+			// Decodes without holding the lock, so other files can be served meanwhile
+			AuroraFW::DebugManager::Log("Buffering the audio..."
+			"(Total frames: ", sndInfo->frames * sndInfo->channels, ")");
+			AudioSampleBuffer* decoded = AFW_NEW AudioSampleBuffer(sndInfo->frames, sndInfo->channels);
+			// Codecs with independent blocks (ALAC) can split a full load across all cores
+			sf_command(sndFile, SFC_SET_DECODER_THREADS, AFW_NULLPTR, 0);
+			sf_readf_float(sndFile, decoded->_samples, sndInfo->frames);
+			std::shared_ptr<const AudioSampleBuffer> buffer(decoded);
+			AuroraFW::DebugManager::Log("Buffering complete.");
+
+			if(!cacheable)
+				return buffer;
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_prune(key);
+
+			std::pair<std::map<Key, Entry>::iterator, bool> result
+				= _entries.insert(std::make_pair(key, Entry()));
+			Entry& entry = result.first->second;
+
+			// Another stream may have decoded the same file meanwhile
+			std::shared_ptr<const AudioSampleBuffer> existing = entry.weakBuffer.lock();
+			if(existing != nullptr) {
+				if(entry.buffer != nullptr) {
+					_lru.splice(_lru.begin(), _lru, entry.lruPosition);
+				} else {
+					entry.buffer = existing;
+					_cache(result.first);
+					_evict();
+				}
+				return existing;
+			}
+
+			entry.buffer = buffer;
+			entry.weakBuffer = buffer;
+			_cache(result.first);
+			_evict();
+
+			return buffer;
+		}
+
+		void AudioSampleCache::setBudget(size_t budget)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_budget = budget;
+			_evict();
+		}
+
+		size_t AudioSampleCache::getBudget() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _budget;
+		}
+
+		size_t AudioSampleCache::getSize() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _size;
+		}
+
+		void AudioSampleCache::clear()
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for(std::map<Key, Entry>::iterator it = _entries.begin(); it != _entries.end();) {
+				if(it->second.buffer != nullptr) {
+					_uncache(it);
+					_evictions.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				if(it->second.weakBuffer.expired())
+					it = _entries.erase(it);
+				else
+					++it;
+			}
+		}
+
+		void AudioSampleCache::_cache(std::map<Key, Entry>::iterator it)
+		{
+			_lru.push_front(it->first);
+			it->second.lruPosition = _lru.begin();
+			_size += it->second.buffer->getSize();
+		}
+
+		void AudioSampleCache::_uncache(std::map<Key, Entry>::iterator it)
+		{
+			_size -= it->second.buffer->getSize();
+			_lru.erase(it->second.lruPosition);
+			it->second.buffer.reset();
+		}
+
+		void AudioSampleCache::_evict()
+		{
+			while(_size > _budget && !_lru.empty()) {
+				std::map<Key, Entry>::iterator it = _entries.find(_lru.back());
+				_uncache(it);
+				_evictions.fetch_add(1, std::memory_order_relaxed);
+
+				if(it->second.weakBuffer.expired())
+					_entries.erase(it);
+			}
+		}
+
+		void AudioSampleCache::_prune(const Key& key)
+		{
+			// Drops older versions of the file, and files no one plays anymore
+			for(std::map<Key, Entry>::iterator it = _entries.begin(); it != _entries.end();) {
+				if(it->second.buffer != nullptr && it->first.path == key.path
+					&& (it->first.modificationTime != key.modificationTime
+					|| it->first.fileSize != key.fileSize)) {
+					_uncache(it);
+					_evictions.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				if(it->second.buffer == nullptr && it->second.weakBuffer.expired())
+					it = _entries.erase(it);
+				else
+					++it;
+			}
+		}
+	}
+}
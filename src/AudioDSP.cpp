@@ -0,0 +1,519 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+#include <AuroraFW/Audio/AudioDSP.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define AFW_AUDIO_DSP_SSE2
+	#include <emmintrin.h>
+	#if defined(__GNUC__)
+		#define AFW_AUDIO_DSP_AVX2
+		#include <immintrin.h>
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define AFW_AUDIO_DSP_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace AuroraFW {
+	namespace AudioManager {
+		// The vectorized kernels repeat the per-channel gains over a whole
+		// number of vectors, so buffers with more channels than this go
+		// through the scalar kernels
+		static const int maxPatternChannels = 32;
+
+		typedef void (*ApplyGainsKernel)(float* , size_t , int , const float* );
+		typedef void (*MixGainsKernel)(float* , const float* , size_t , int , const float* );
+		typedef void (*ApplyGainRampKernel)(float* , size_t , int , const float* , const float* );
+		typedef void (*MixGainRampKernel)(float* , const float* , size_t , int , const float* ,
+			const float* );
+
+		static void fillGainPattern(float* pattern, int channels, int width, const float* gains)
+		{
+			for(int i = 0; i < channels * width; i++)
+				pattern[i] = gains[i % channels];
+		}
+
+		// Fills the gains of the first period of a ramp, and how much
+		// they grow from one period to the next
+		static void fillRampPattern(float* pattern, float* increment, int channels, int width,
+			const float* steps, const float* startGains)
+		{
+			for(int i = 0; i < channels * width; i++) {
+				pattern[i] = startGains[i % channels] + steps[i % channels] * (i / channels);
+				increment[i] = steps[i % channels] * width;
+			}
+		}
+
+		static void fillRampSteps(float* steps, int channels, size_t frames,
+			const float* startGains, const float* endGains)
+		{
+			for(int c = 0; c < channels; c++)
+				steps[c] = (endGains[c] - startGains[c]) / frames;
+		}
+
+		// Scalar
+		static void applyGainsScalar(float* buffer, size_t frames, int channels, const float* gains)
+		{
+			for(size_t f = 0; f < frames; f++) {
+				for(int c = 0; c < channels; c++)
+					*buffer++ *= gains[c];
+			}
+		}
+
+		static void mixGainsScalar(float* output, const float* input, size_t frames, int channels,
+			const float* gains)
+		{
+			for(size_t f = 0; f < frames; f++) {
+				for(int c = 0; c < channels; c++)
+					*output++ += *input++ * gains[c];
+			}
+		}
+
+		// Continues a ramp from the given frame, used for the frames
+		// that don't fill a whole period
+		static void applyGainRampScalarFrom(float* buffer, size_t start, size_t frames, int channels,
+			const float* startGains, const float* steps)
+		{
+			for(size_t f = start; f < frames; f++) {
+				for(int c = 0; c < channels; c++)
+					*buffer++ *= startGains[c] + steps[c] * f;
+			}
+		}
+
+		static void mixGainRampScalarFrom(float* output, const float* input, size_t start,
+			size_t frames, int channels, const float* startGains, const float* steps)
+		{
+			for(size_t f = start; f < frames; f++) {
+				for(int c = 0; c < channels; c++)
+					*output++ += *input++ * (startGains[c] + steps[c] * f);
+			}
+		}
+
+		static void applyGainRampScalar(float* buffer, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels) {
+				for(size_t f = 0; f < frames; f++) {
+					for(int c = 0; c < channels; c++)
+						*buffer++ *= startGains[c] + (endGains[c] - startGains[c]) * f / frames;
+				}
+				return;
+			}
+
+			float steps[maxPatternChannels];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			applyGainRampScalarFrom(buffer, 0, frames, channels, startGains, steps);
+		}
+
+		static void mixGainRampScalar(float* output, const float* input, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels) {
+				for(size_t f = 0; f < frames; f++) {
+					for(int c = 0; c < channels; c++)
+						*output++ += *input++ * (startGains[c]
+						+ (endGains[c] - startGains[c]) * f / frames);
+				}
+				return;
+			}
+
+			float steps[maxPatternChannels];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			mixGainRampScalarFrom(output, input, 0, frames, channels, startGains, steps);
+		}
+
+#if defined(AFW_AUDIO_DSP_SSE2)
+		// SSE2
+		static void applyGainsSSE2(float* buffer, size_t frames, int channels, const float* gains)
+		{
+			if(channels > maxPatternChannels)
+				return applyGainsScalar(buffer, frames, channels, gains);
+
+			// A period holds 4 frames, which is a whole number of vectors
+			float pattern[maxPatternChannels * 4];
+			fillGainPattern(pattern, channels, 4, gains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					__m128 x = _mm_loadu_ps(buffer + i + v);
+					_mm_storeu_ps(buffer + i + v, _mm_mul_ps(x, _mm_loadu_ps(pattern + v)));
+				}
+			}
+
+			applyGainsScalar(buffer + i, (samples - i) / channels, channels, gains);
+		}
+
+		static void mixGainsSSE2(float* output, const float* input, size_t frames, int channels,
+			const float* gains)
+		{
+			if(channels > maxPatternChannels)
+				return mixGainsScalar(output, input, frames, channels, gains);
+
+			float pattern[maxPatternChannels * 4];
+			fillGainPattern(pattern, channels, 4, gains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					__m128 x = _mm_mul_ps(_mm_loadu_ps(input + i + v), _mm_loadu_ps(pattern + v));
+					_mm_storeu_ps(output + i + v, _mm_add_ps(_mm_loadu_ps(output + i + v), x));
+				}
+			}
+
+			mixGainsScalar(output + i, input + i, (samples - i) / channels, channels, gains);
+		}
+
+		static void applyGainRampSSE2(float* buffer, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels)
+				return applyGainRampScalar(buffer, frames, channels, startGains, endGains);
+
+			float steps[maxPatternChannels];
+			float pattern[maxPatternChannels * 4];
+			float increment[maxPatternChannels * 4];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			fillRampPattern(pattern, increment, channels, 4, steps, startGains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					__m128 g = _mm_loadu_ps(pattern + v);
+					_mm_storeu_ps(buffer + i + v, _mm_mul_ps(_mm_loadu_ps(buffer + i + v), g));
+					_mm_storeu_ps(pattern + v, _mm_add_ps(g, _mm_loadu_ps(increment + v)));
+				}
+			}
+
+			applyGainRampScalarFrom(buffer + i, i / channels, frames, channels, startGains, steps);
+		}
+
+		static void mixGainRampSSE2(float* output, const float* input, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels)
+				return mixGainRampScalar(output, input, frames, channels, startGains, endGains);
+
+			float steps[maxPatternChannels];
+			float pattern[maxPatternChannels * 4];
+			float increment[maxPatternChannels * 4];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			fillRampPattern(pattern, increment, channels, 4, steps, startGains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					__m128 g = _mm_loadu_ps(pattern + v);
+					_mm_storeu_ps(output + i + v, _mm_add_ps(_mm_loadu_ps(output + i + v),
+					_mm_mul_ps(_mm_loadu_ps(input + i + v), g)));
+					_mm_storeu_ps(pattern + v, _mm_add_ps(g, _mm_loadu_ps(increment + v)));
+				}
+			}
+
+			mixGainRampScalarFrom(output + i, input + i, i / channels, frames, channels,
+			startGains, steps);
+		}
+#endif
+
+#if defined(AFW_AUDIO_DSP_AVX2)
+		// AVX2
+		__attribute__((target("avx2")))
+		static void applyGainsAVX2(float* buffer, size_t frames, int channels, const float* gains)
+		{
+			if(channels > maxPatternChannels)
+				return applyGainsScalar(buffer, frames, channels, gains);
+
+			float pattern[maxPatternChannels * 8];
+			fillGainPattern(pattern, channels, 8, gains);
+
+			const size_t period = channels * 8;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 8) {
+					__m256 x = _mm256_loadu_ps(buffer + i + v);
+					_mm256_storeu_ps(buffer + i + v, _mm256_mul_ps(x, _mm256_loadu_ps(pattern + v)));
+				}
+			}
+
+			applyGainsScalar(buffer + i, (samples - i) / channels, channels, gains);
+		}
+
+		__attribute__((target("avx2")))
+		static void mixGainsAVX2(float* output, const float* input, size_t frames, int channels,
+			const float* gains)
+		{
+			if(channels > maxPatternChannels)
+				return mixGainsScalar(output, input, frames, channels, gains);
+
+			float pattern[maxPatternChannels * 8];
+			fillGainPattern(pattern, channels, 8, gains);
+
+			const size_t period = channels * 8;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 8) {
+					__m256 x = _mm256_mul_ps(_mm256_loadu_ps(input + i + v),
+					_mm256_loadu_ps(pattern + v));
+					_mm256_storeu_ps(output + i + v,
+					_mm256_add_ps(_mm256_loadu_ps(output + i + v), x));
+				}
+			}
+
+			mixGainsScalar(output + i, input + i, (samples - i) / channels, channels, gains);
+		}
+
+		__attribute__((target("avx2")))
+		static void applyGainRampAVX2(float* buffer, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels)
+				return applyGainRampScalar(buffer, frames, channels, startGains, endGains);
+
+			float steps[maxPatternChannels];
+			float pattern[maxPatternChannels * 8];
+			float increment[maxPatternChannels * 8];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			fillRampPattern(pattern, increment, channels, 8, steps, startGains);
+
+			const size_t period = channels * 8;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 8) {
+					__m256 g = _mm256_loadu_ps(pattern + v);
+					_mm256_storeu_ps(buffer + i + v, _mm256_mul_ps(_mm256_loadu_ps(buffer + i + v), g));
+					_mm256_storeu_ps(pattern + v, _mm256_add_ps(g, _mm256_loadu_ps(increment + v)));
+				}
+			}
+
+			applyGainRampScalarFrom(buffer + i, i / channels, frames, channels, startGains, steps);
+		}
+
+		__attribute__((target("avx2")))
+		static void mixGainRampAVX2(float* output, const float* input, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels)
+				return mixGainRampScalar(output, input, frames, channels, startGains, endGains);
+
+			float steps[maxPatternChannels];
+			float pattern[maxPatternChannels * 8];
+			float increment[maxPatternChannels * 8];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			fillRampPattern(pattern, increment, channels, 8, steps, startGains);
+
+			const size_t period = channels * 8;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 8) {
+					__m256 g = _mm256_loadu_ps(pattern + v);
+					_mm256_storeu_ps(output + i + v, _mm256_add_ps(_mm256_loadu_ps(output + i + v),
+					_mm256_mul_ps(_mm256_loadu_ps(input + i + v), g)));
+					_mm256_storeu_ps(pattern + v, _mm256_add_ps(g, _mm256_loadu_ps(increment + v)));
+				}
+			}
+
+			mixGainRampScalarFrom(output + i, input + i, i / channels, frames, channels,
+			startGains, steps);
+		}
+#endif
+
+#if defined(AFW_AUDIO_DSP_NEON)
+		// NEON
+		static void applyGainsNEON(float* buffer, size_t frames, int channels, const float* gains)
+		{
+			if(channels > maxPatternChannels)
+				return applyGainsScalar(buffer, frames, channels, gains);
+
+			float pattern[maxPatternChannels * 4];
+			fillGainPattern(pattern, channels, 4, gains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					float32x4_t x = vld1q_f32(buffer + i + v);
+					vst1q_f32(buffer + i + v, vmulq_f32(x, vld1q_f32(pattern + v)));
+				}
+			}
+
+			applyGainsScalar(buffer + i, (samples - i) / channels, channels, gains);
+		}
+
+		static void mixGainsNEON(float* output, const float* input, size_t frames, int channels,
+			const float* gains)
+		{
+			if(channels > maxPatternChannels)
+				return mixGainsScalar(output, input, frames, channels, gains);
+
+			float pattern[maxPatternChannels * 4];
+			fillGainPattern(pattern, channels, 4, gains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					vst1q_f32(output + i + v, vmlaq_f32(vld1q_f32(output + i + v),
+					vld1q_f32(input + i + v), vld1q_f32(pattern + v)));
+				}
+			}
+
+			mixGainsScalar(output + i, input + i, (samples - i) / channels, channels, gains);
+		}
+
+		static void applyGainRampNEON(float* buffer, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels)
+				return applyGainRampScalar(buffer, frames, channels, startGains, endGains);
+
+			float steps[maxPatternChannels];
+			float pattern[maxPatternChannels * 4];
+			float increment[maxPatternChannels * 4];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			fillRampPattern(pattern, increment, channels, 4, steps, startGains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					float32x4_t g = vld1q_f32(pattern + v);
+					vst1q_f32(buffer + i + v, vmulq_f32(vld1q_f32(buffer + i + v), g));
+					vst1q_f32(pattern + v, vaddq_f32(g, vld1q_f32(increment + v)));
+				}
+			}
+
+			applyGainRampScalarFrom(buffer + i, i / channels, frames, channels, startGains, steps);
+		}
+
+		static void mixGainRampNEON(float* output, const float* input, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(channels > maxPatternChannels)
+				return mixGainRampScalar(output, input, frames, channels, startGains, endGains);
+
+			float steps[maxPatternChannels];
+			float pattern[maxPatternChannels * 4];
+			float increment[maxPatternChannels * 4];
+			fillRampSteps(steps, channels, frames, startGains, endGains);
+			fillRampPattern(pattern, increment, channels, 4, steps, startGains);
+
+			const size_t period = channels * 4;
+			const size_t samples = frames * channels;
+			size_t i = 0;
+			for(; i + period <= samples; i += period) {
+				for(size_t v = 0; v < period; v += 4) {
+					float32x4_t g = vld1q_f32(pattern + v);
+					vst1q_f32(output + i + v, vaddq_f32(vld1q_f32(output + i + v),
+					vmulq_f32(vld1q_f32(input + i + v), g)));
+					vst1q_f32(pattern + v, vaddq_f32(g, vld1q_f32(increment + v)));
+				}
+			}
+
+			mixGainRampScalarFrom(output + i, input + i, i / channels, frames, channels,
+			startGains, steps);
+		}
+#endif
+
+		// Runtime dispatch
+		struct DSPKernels {
+			DSPKernels()
+				: applyGains(applyGainsScalar), mixGains(mixGainsScalar),
+				applyGainRamp(applyGainRampScalar), mixGainRamp(mixGainRampScalar), name("Scalar")
+			{
+#if defined(AFW_AUDIO_DSP_AVX2)
+				__builtin_cpu_init();
+				if(__builtin_cpu_supports("avx2")) {
+					applyGains = applyGainsAVX2;
+					mixGains = mixGainsAVX2;
+					applyGainRamp = applyGainRampAVX2;
+					mixGainRamp = mixGainRampAVX2;
+					name = "AVX2";
+					return;
+				}
+#endif
+#if defined(AFW_AUDIO_DSP_SSE2)
+				applyGains = applyGainsSSE2;
+				mixGains = mixGainsSSE2;
+				applyGainRamp = applyGainRampSSE2;
+				mixGainRamp = mixGainRampSSE2;
+				name = "SSE2";
+#elif defined(AFW_AUDIO_DSP_NEON)
+				applyGains = applyGainsNEON;
+				mixGains = mixGainsNEON;
+				applyGainRamp = applyGainRampNEON;
+				mixGainRamp = mixGainRampNEON;
+				name = "NEON";
+#endif
+			}
+
+			ApplyGainsKernel applyGains;
+			MixGainsKernel mixGains;
+			ApplyGainRampKernel applyGainRamp;
+			MixGainRampKernel mixGainRamp;
+			const char* name;
+		};
+
+		static const DSPKernels dspKernels;
+
+		void applyGains(float* buffer, size_t frames, int channels, const float* gains)
+		{
+			dspKernels.applyGains(buffer, frames, channels, gains);
+		}
+
+		void mixGains(float* output, const float* input, size_t frames, int channels,
+			const float* gains)
+		{
+			dspKernels.mixGains(output, input, frames, channels, gains);
+		}
+
+		void applyGainRamp(float* buffer, size_t frames, int channels, const float* startGains,
+			const float* endGains)
+		{
+			if(frames > 0)
+				dspKernels.applyGainRamp(buffer, frames, channels, startGains, endGains);
+		}
+
+		void mixGainRamp(float* output, const float* input, size_t frames, int channels,
+			const float* startGains, const float* endGains)
+		{
+			if(frames > 0)
+				dspKernels.mixGainRamp(output, input, frames, channels, startGains, endGains);
+		}
+
+		const char* getDSPInstructionSet()
+		{
+			return dspKernels.name;
+		}
+	}
+}
@@ -18,6 +18,10 @@
 
 #include <AuroraFW/Audio/AudioInput.h>
 
+// STD
+#include <algorithm>
+#include <chrono>
+
 namespace AuroraFW {
 	namespace AudioManager {
 		// audioInputCallback
@@ -29,6 +33,25 @@ namespace AuroraFW {
 			AudioIStream* stream = (AudioIStream*)userData;
 			AudioInfo* info = stream->info;
 
+			// Streaming to disk: only whole frames are pushed, whatever
+			// doesn't fit is dropped and reported as an overrun
+			if(stream->_ringBuffer != nullptr) {
+				const int channels = info->getChannels();
+				size_t frames = std::min(framesPerBuffer,
+				stream->_ringBuffer->getWriteAvailable() / channels);
+				if(input != nullptr)
+					stream->_ringBuffer->write(input, frames * channels);
+
+				if(frames < framesPerBuffer) {
+					stream->_overruns.fetch_add(1, std::memory_order_relaxed);
+					stream->_droppedFrames.fetch_add(framesPerBuffer - frames,
+					std::memory_order_relaxed);
+				}
+
+				stream->_streamPosFrame += frames;
+				return paContinue;
+			}
+
 			for(size_t f = 0; f < framesPerBuffer; f++) {
 				for(uint8_t c = 0; c < info->getChannels(); c++) {
 					stream->buffer[stream->_streamPosFrame * info->getChannels()
@@ -48,12 +71,20 @@ namespace AuroraFW {
 		}
 
 		// AudioIStream
-		AudioIStream::AudioIStream(const char* path, AudioInfo* info, int bufferSize)
+		AudioIStream::AudioIStream(const char* path, AudioInfo* info, int bufferSize,
+			size_t streamBufferFrames)
 			: path(path), info(info), bufferSize(bufferSize)
 		{
-			buffer = AFW_NEW float[bufferSize * info->getChannels()];
+			if(bufferSize > 0) {
+				buffer = AFW_NEW float[bufferSize * info->getChannels()];
+			} else {
+				buffer = nullptr;
+				_ringBuffer = AFW_NEW AudioRingBuffer<float>(streamBufferFrames
+				* info->getChannels());
+			}
 
 			info->_sndFile = sf_open(path, SFM_WRITE, info->_sndInfo);
+			info->_applyIOSettings();
 
 			catchPAProblem(Pa_OpenDefaultStream(&_paStream, info->getChannels(), 0, paFloat32,
 				info->getSampleRate(), paFramesPerBufferUnspecified,
@@ -62,6 +93,14 @@ namespace AuroraFW {
 
 		AudioIStream::~AudioIStream()
 		{
+			// The callback must be done with the buffers before they go away
+			Pa_CloseStream(_paStream);
+
+			// Writes whatever is left before the file is closed
+			_stopWriter();
+			if(_ringBuffer != AFW_NULLPTR)
+				delete _ringBuffer;
+
 			if(buffer != AFW_NULLPTR)
 				delete[] buffer;
 
@@ -71,12 +110,17 @@ namespace AuroraFW {
 
 		void AudioIStream::record()
 		{
+			if(_ringBuffer != nullptr)
+				_startWriter();
+
 			catchPAProblem(Pa_StartStream(_paStream));
 		}
 
 		void AudioIStream::pause()
 		{
 			catchPAProblem(Pa_StopStream(_paStream));
+
+			_stopWriter();
 		}
 
 		void AudioIStream::stop()
@@ -84,6 +128,8 @@ namespace AuroraFW {
 			_streamPosFrame = 0;
 
 			catchPAProblem(Pa_StopStream(_paStream));
+
+			_stopWriter();
 		}
 
 		bool AudioIStream::isRecording()
@@ -103,7 +149,9 @@ namespace AuroraFW {
 
 		bool AudioIStream::isBufferFull()
 		{
-			#pragma message ("TODO: Need to be implemented")
+			if(_ringBuffer != nullptr)
+				return _ringBuffer->getWriteAvailable() < static_cast<size_t>(info->getChannels());
+			return _streamPosFrame >= static_cast<unsigned int>(bufferSize);
 		}
 
 		void AudioIStream::clearBuffer()
@@ -118,9 +166,87 @@ namespace AuroraFW {
 
 		bool AudioIStream::save()
 		{
+			if(_ringBuffer != nullptr) {
+				// Restarting the writer drains the ring buffer before syncing
+				const bool writing = _writerThread.joinable();
+				_stopWriter();
+				sf_write_sync(info->_sndFile);
+				if(writing)
+					_startWriter();
+
+				return !_writeFailed.load(std::memory_order_relaxed);
+			}
+
 			if(sf_writef_float(info->_sndFile, buffer, bufferSize) == -1)
 				return false;
 			return true;
 		}
+
+		void AudioIStream::_startWriter()
+		{
+			if(_writerThread.joinable())
+				return;
+
+			_writerRunning = true;
+			_writerThread = std::thread(&AudioIStream::_writerLoop, this);
+		}
+
+		void AudioIStream::_stopWriter()
+		{
+			if(!_writerThread.joinable())
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock(_writerMutex);
+				_writerRunning = false;
+			}
+			_writerCondition.notify_one();
+			_writerThread.join();
+		}
+
+		void AudioIStream::_writerLoop()
+		{
+			const int channels = info->getChannels();
+			const size_t ringFrames = _ringBuffer->getCapacity() / channels;
+			const size_t chunkFrames = ringFrames / 4 > 0 ? ringFrames / 4 : 1;
+			float* chunk = AFW_NEW float[chunkFrames * channels];
+
+			// Wakes up about every quarter of the ring buffer
+			const std::chrono::microseconds drainInterval(info->getSampleRate() > 0
+			? chunkFrames * 1000000 / info->getSampleRate() : 10000);
+
+			std::unique_lock<std::mutex> lock(_writerMutex);
+			while(true) {
+				const bool running = _writerRunning;
+
+				// Writes whole chunks while recording, and everything left once stopped.
+				// The disk is written without holding the lock, so stopping the writer
+				// doesn't wait for it longer than needed
+				lock.unlock();
+				const size_t minFrames = running ? chunkFrames : 1;
+				size_t availableFrames = _ringBuffer->getReadAvailable() / channels;
+				while(availableFrames >= minFrames) {
+					const size_t frames = std::min(availableFrames, chunkFrames);
+					_ringBuffer->read(chunk, frames * channels);
+
+					sf_count_t writtenFrames = sf_writef_float(info->_sndFile, chunk, frames);
+					if(writtenFrames > 0)
+						_writtenFrames.fetch_add(writtenFrames, std::memory_order_relaxed);
+					if(writtenFrames != static_cast<sf_count_t>(frames)
+						&& !_writeFailed.exchange(true, std::memory_order_relaxed))
+						CLI::Log(CLI::Error, "Couldn't write the recording to ", path, ": ",
+						sf_strerror(info->_sndFile));
+
+					availableFrames = _ringBuffer->getReadAvailable() / channels;
+				}
+				lock.lock();
+
+				if(!running)
+					break;
+				_writerCondition.wait_for(lock, drainInterval);
+			}
+
+			delete[] chunk;
+		}
 	}
 }
\ No newline at end of file
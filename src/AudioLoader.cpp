@@ -0,0 +1,144 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+#include <AuroraFW/Audio/AudioLoader.h>
+#include <AuroraFW/Audio/AudioBackend.h>
+#include <AuroraFW/Audio/AudioOutput.h>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		AudioLoader::AudioLoader(unsigned int workers)
+			: _workers(workers, 1)
+		{}
+
+		AudioLoader::~AudioLoader()
+		{}
+
+		std::shared_future<AudioLoadResult> AudioLoader::load(const char* path)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			std::map<std::string, std::shared_future<AudioLoadResult>>::iterator it = _pending.find(path);
+			if(it != _pending.end())
+				return it->second;
+
+			// Shared, as a task has to be copyable
+			std::shared_ptr<std::promise<AudioLoadResult>> promise = std::make_shared<std::promise<AudioLoadResult>>();
+			std::shared_future<AudioLoadResult> future = promise->get_future().share();
+			_pending[path] = future;
+
+			const std::string file = path;
+			_workers.push([this, file, promise](unsigned int , double queueTime) {
+				_run(file, queueTime, *promise);
+			});
+
+			return future;
+		}
+
+		bool AudioLoader::getLoadMetrics(const char* path, AudioLoadMetrics& metrics) const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::map<std::string, AudioLoadMetrics>::const_iterator it = _metrics.find(path);
+			if(it == _metrics.end())
+				return false;
+
+			metrics = it->second;
+			return true;
+		}
+
+		std::vector<AudioLoadMetrics> AudioLoader::getAllLoadMetrics() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::vector<AudioLoadMetrics> allMetrics;
+			allMetrics.reserve(_metrics.size());
+			for(const std::pair<const std::string, AudioLoadMetrics>& metrics : _metrics)
+				allMetrics.push_back(metrics.second);
+
+			return allMetrics;
+		}
+
+		size_t AudioLoader::getNumPending() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _pending.size();
+		}
+
+		void AudioLoader::_run(const std::string& path, double queueTime, std::promise<AudioLoadResult>& promise)
+		{
+			try {
+				AudioLoadResult result = _load(path, queueTime);
+
+				AuroraFW::DebugManager::Log("Loaded ", path, " in ",
+				result.metrics.queueTime + result.metrics.openTime + result.metrics.decodeTime,
+				"ms (queued: ", result.metrics.queueTime, "ms, open: ", result.metrics.openTime,
+				"ms, ", result.metrics.mapped ? "map: " : "decode: ", result.metrics.decodeTime,
+				"ms, ", result.metrics.size, " bytes", result.metrics.cacheHit ? ", cached)" : ")");
+
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					_metrics[path] = result.metrics;
+					_pending.erase(path);
+				}
+
+				promise.set_value(result);
+			} catch(...) {
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					_pending.erase(path);
+				}
+
+				promise.set_exception(std::current_exception());
+			}
+		}
+
+		AudioLoadResult AudioLoader::_load(const std::string& path, double queueTime)
+		{
+			AudioLoadResult result;
+			result.metrics.path = path;
+			result.metrics.queueTime = queueTime;
+
+			const std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+
+			SF_INFO sndInfo;
+			sndInfo.format = 0;
+			// Closed on every path out, including a throw from the mapping or the cache
+			std::unique_ptr<SNDFILE, int (*)(SNDFILE*)> sndFile(sf_open(path.c_str(), SFM_READ, &sndInfo), sf_close);
+			if(sndFile == nullptr)
+				throw AudioFileNotFound(path.c_str());
+
+			const std::chrono::steady_clock::time_point openedAt = std::chrono::steady_clock::now();
+			result.metrics.openTime = AudioWorkerPool::millisecondsBetween(startedAt, openedAt);
+
+			// Same order as the buffered AudioOStream: mapped if possible, decoded otherwise
+			result.mappedFile = AudioMappedFile::open(path.c_str(), sndFile.get(), &sndInfo);
+			if(result.mappedFile != nullptr) {
+				result.metrics.mapped = true;
+				result.metrics.size = result.mappedFile->getSize();
+			} else {
+				result.sampleBuffer = AudioBackend::getInstance().getSampleCache()
+				.load(path.c_str(), sndFile.get(), &sndInfo, &result.metrics.cacheHit);
+				result.metrics.size = result.sampleBuffer->getSize();
+			}
+
+			catchSNDFILEProblem(sf_close(sndFile.release()));
+			result.metrics.decodeTime = AudioWorkerPool::millisecondsBetween(openedAt, std::chrono::steady_clock::now());
+
+			return result;
+		}
+	}
+}
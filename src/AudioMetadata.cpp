@@ -0,0 +1,422 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+#include <AuroraFW/Audio/AudioMetadata.h>
+#include <AuroraFW/Audio/AudioUtils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <dirent.h>
+#endif
+
+namespace AuroraFW {
+	namespace AudioManager {
+	#if defined(_WIN32)
+		static const char pathSeparator = '\\';
+	#else
+		static const char pathSeparator = '/';
+	#endif
+
+		// Index files hold a header, one fixed size entry per file sorted by path and then
+		// a pool with every distinct string, nul terminated. They are written in the byte
+		// order of the machine, files from another one are rejected and rebuilt.
+		static const char indexMagic[8] = {'A', 'F', 'W', 'A', 'I', 'D', 'X', '\0'};
+		static const uint32_t indexVersion = 2;
+		static const uint32_t indexByteOrder = 0x01020304;
+		static const uint32_t indexNoString = UINT32_MAX;
+
+		struct IndexHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t byteOrder;
+			uint32_t entrySize;
+			uint32_t entryCount;
+			uint64_t poolSize;
+		};
+
+		struct IndexEntry {
+			int64_t modificationTime;
+			int64_t modificationNanoseconds;
+			int64_t fileSize;
+			int64_t frames;
+			int32_t sampleRate;
+			int32_t channels;
+			int32_t format;
+			int32_t sections;
+			int32_t seekable;
+			uint32_t path;
+			uint32_t strings[SF_STR_LAST - SF_STR_FIRST + 1];
+		};
+
+		// Appends a separator, so every path found in the directory starts with the prefix
+		static std::string directoryPrefix(const std::string& directory)
+		{
+			std::string prefix = directory;
+			if(!prefix.empty() && prefix.back() != '/' && prefix.back() != pathSeparator)
+				prefix += pathSeparator;
+
+			return prefix;
+		}
+
+		// Collects the paths of the regular files in a directory
+		static void listDirectory(const std::string& directory, bool recursive, std::vector<std::string>& paths)
+		{
+			const std::string prefix = directoryPrefix(directory);
+
+		#if defined(_WIN32)
+			WIN32_FIND_DATAA findData;
+			HANDLE find = FindFirstFileA((prefix + '*').c_str(), &findData);
+			if(find == INVALID_HANDLE_VALUE)
+				return;
+
+			do {
+				if(std::strcmp(findData.cFileName, ".") == 0 || std::strcmp(findData.cFileName, "..") == 0)
+					continue;
+
+				const std::string path = prefix + findData.cFileName;
+				if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+					// Junctions aren't followed, so a loop can't recurse forever
+					if(recursive && !(findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+						listDirectory(path, recursive, paths);
+				} else {
+					paths.push_back(path);
+				}
+			} while(FindNextFileA(find, &findData));
+
+			FindClose(find);
+		#else
+			DIR* dir = opendir(directory.c_str());
+			if(dir == AFW_NULLPTR)
+				return;
+
+			while(struct dirent* entry = readdir(dir)) {
+				if(std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0)
+					continue;
+
+				const std::string path = prefix + entry->d_name;
+				unsigned char type = DT_UNKNOWN;
+			#if defined(_DIRENT_HAVE_D_TYPE) || defined(__APPLE__) || defined(__FreeBSD__)
+				type = entry->d_type;
+			#endif
+				if(type == DT_UNKNOWN || type == DT_LNK) {
+					// Symbolic links to directories aren't followed, so a loop can't recurse forever
+					struct stat fileStat;
+					if(lstat(path.c_str(), &fileStat) != 0)
+						continue;
+
+					if(S_ISLNK(fileStat.st_mode))
+						type = stat(path.c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode) ? DT_REG : DT_UNKNOWN;
+					else if(S_ISDIR(fileStat.st_mode))
+						type = DT_DIR;
+					else if(S_ISREG(fileStat.st_mode))
+						type = DT_REG;
+				}
+
+				if(type == DT_DIR) {
+					if(recursive)
+						listDirectory(path, recursive, paths);
+				} else if(type == DT_REG) {
+					paths.push_back(path);
+				}
+			}
+
+			closedir(dir);
+		#endif
+		}
+
+		// The sub-second part of a file's modification time, where the platform keeps it
+		static long modificationNanoseconds(const struct stat& fileStat)
+		{
+		#if defined(_WIN32)
+			return 0;
+		#elif defined(__APPLE__)
+			return fileStat.st_mtimespec.tv_nsec;
+		#else
+			return fileStat.st_mtim.tv_nsec;
+		#endif
+		}
+
+		// Fills the metadata of a file that was already stat'ed
+		static bool probeFile(const char* path, const struct stat& fileStat, AudioMetadata& metadata)
+		{
+			SF_PROBE_INFO probeInfo;
+			if(sf_probe(path, &probeInfo) != 0)
+				return false;
+
+			metadata.path = path;
+			metadata.info = probeInfo.info;
+			for(int str = 0; str <= SF_STR_LAST - SF_STR_FIRST; str++) {
+				if(probeInfo.str_offset[str] >= 0)
+					metadata.strings[str] = probeInfo.str_data + probeInfo.str_offset[str];
+				else
+					metadata.strings[str].clear();
+			}
+			metadata.modificationTime = fileStat.st_mtime;
+			metadata.modificationNanoseconds = modificationNanoseconds(fileStat);
+			metadata.fileSize = fileStat.st_size;
+
+			return true;
+		}
+
+		// AudioMetadata
+		const char* AudioMetadata::getString(int type) const
+		{
+			if(type < SF_STR_FIRST || type > SF_STR_LAST || strings[type - SF_STR_FIRST].empty())
+				return AFW_NULLPTR;
+
+			return strings[type - SF_STR_FIRST].c_str();
+		}
+
+		bool AudioMetadata::probe(const char* path, AudioMetadata& metadata)
+		{
+			struct stat fileStat;
+			if(stat(path, &fileStat) != 0)
+				return false;
+
+			return probeFile(path, fileStat, metadata);
+		}
+
+		// AudioMetadataIndex
+		size_t AudioMetadataIndex::scan(const char* directory, bool recursive, unsigned int workers)
+		{
+			std::vector<std::string> paths;
+			listDirectory(directory, recursive, paths);
+
+			if(workers == 0) {
+				const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+				workers = hardwareThreads > 0 ? hardwareThreads : 1;
+			}
+			if(workers > paths.size())
+				workers = paths.size() > 0 ? static_cast<unsigned int>(paths.size()) : 1;
+
+			enum FileState : char { NotAudio, Unchanged, Probed };
+
+			// Each file is probed into its own slot, so the workers never share anything
+			// but the counter handing out the files. The entries are only read until they join.
+			std::vector<AudioMetadata> found(paths.size());
+			std::vector<char> states(paths.size(), NotAudio);
+			std::atomic<size_t> next(0);
+			const auto probeFiles = [&]() {
+				size_t file;
+				while((file = next.fetch_add(1, std::memory_order_relaxed)) < paths.size()) {
+					struct stat fileStat;
+					if(stat(paths[file].c_str(), &fileStat) != 0)
+						continue;
+
+					std::map<std::string, AudioMetadata>::const_iterator it = _entries.find(paths[file]);
+					if(it != _entries.end() && it->second.modificationTime == fileStat.st_mtime
+						&& it->second.modificationNanoseconds == modificationNanoseconds(fileStat)
+						&& it->second.fileSize == fileStat.st_size)
+						states[file] = Unchanged;
+					else if(probeFile(paths[file].c_str(), fileStat, found[file]))
+						states[file] = Probed;
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for(unsigned int i = 1; i < workers; i++)
+				threads.push_back(std::thread(probeFiles));
+			probeFiles();
+			for(std::thread& thread : threads)
+				thread.join();
+
+			size_t count = 0;
+			for(size_t file = 0; file < paths.size(); file++) {
+				if(states[file] == Probed) {
+					_entries[paths[file]] = std::move(found[file]);
+					count++;
+				} else if(states[file] == NotAudio) {
+					_entries.erase(paths[file]);
+				}
+			}
+
+			// Drops the files that were in the directory last time but aren't anymore
+			std::sort(paths.begin(), paths.end());
+			const std::string prefix = directoryPrefix(directory);
+			std::map<std::string, AudioMetadata>::iterator it = _entries.lower_bound(prefix);
+			while(it != _entries.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+				const bool inSubdirectory = it->first.find_first_of("/\\", prefix.size()) != std::string::npos;
+				if((recursive || !inSubdirectory) && !std::binary_search(paths.begin(), paths.end(), it->first))
+					it = _entries.erase(it);
+				else
+					++it;
+			}
+
+			return count;
+		}
+
+		const AudioMetadata* AudioMetadataIndex::find(const char* path) const
+		{
+			std::map<std::string, AudioMetadata>::const_iterator it = _entries.find(path);
+			return it != _entries.end() ? &it->second : AFW_NULLPTR;
+		}
+
+		bool AudioMetadataIndex::load(const char* path)
+		{
+			std::shared_ptr<AudioMemoryFile> file = AudioMemoryFile::map(path);
+			if(file == AFW_NULLPTR || file->getSize() < static_cast<sf_count_t>(sizeof(IndexHeader)))
+				return false;
+
+			IndexHeader header;
+			std::memcpy(&header, file->getData(), sizeof(header));
+			if(std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0 || header.version != indexVersion
+				|| header.byteOrder != indexByteOrder || header.entrySize != sizeof(IndexEntry))
+				return false;
+
+			// The sizes come from the file, so they're checked against what's left of
+			// it one at a time instead of summed, which a crafted pool size could wrap
+			const uint64_t available = static_cast<uint64_t>(file->getSize()) - sizeof(IndexHeader);
+			if(header.entryCount > available / sizeof(IndexEntry))
+				return false;
+
+			const uint64_t entriesSize = static_cast<uint64_t>(header.entryCount) * sizeof(IndexEntry);
+			if(header.poolSize != available - entriesSize)
+				return false;
+
+			// With the pool ending in a nul every offset inside it is a terminated string
+			const unsigned char* entries = file->getData() + sizeof(IndexHeader);
+			const char* pool = reinterpret_cast<const char*>(entries + entriesSize);
+			if(header.poolSize > 0 && pool[header.poolSize - 1] != '\0')
+				return false;
+
+			std::map<std::string, AudioMetadata> loaded;
+			for(uint32_t i = 0; i < header.entryCount; i++) {
+				IndexEntry entry;
+				std::memcpy(&entry, entries + i * sizeof(IndexEntry), sizeof(entry));
+				if(entry.path >= header.poolSize)
+					return false;
+
+				AudioMetadata metadata;
+				metadata.path = pool + entry.path;
+				metadata.info.frames = entry.frames;
+				metadata.info.samplerate = entry.sampleRate;
+				metadata.info.channels = entry.channels;
+				metadata.info.format = entry.format;
+				metadata.info.sections = entry.sections;
+				metadata.info.seekable = entry.seekable;
+				metadata.modificationTime = entry.modificationTime;
+				metadata.modificationNanoseconds = static_cast<long>(entry.modificationNanoseconds);
+				metadata.fileSize = entry.fileSize;
+				for(int str = 0; str <= SF_STR_LAST - SF_STR_FIRST; str++) {
+					if(entry.strings[str] == indexNoString)
+						continue;
+					if(entry.strings[str] >= header.poolSize)
+						return false;
+
+					metadata.strings[str] = pool + entry.strings[str];
+				}
+
+				// Saved sorted, so every entry goes at the end of the map
+				std::string key = metadata.path;
+				loaded.emplace_hint(loaded.end(), std::move(key), std::move(metadata));
+			}
+
+			_entries.swap(loaded);
+
+			return true;
+		}
+
+		bool AudioMetadataIndex::save(const char* path) const
+		{
+			std::vector<IndexEntry> entries;
+			entries.reserve(_entries.size());
+			std::string pool;
+			std::unordered_map<std::string, uint32_t> pooled;
+
+			// Artists, albums and the like repeat a lot, so each distinct string is stored once
+			const auto addString = [&](const std::string& string) -> uint32_t {
+				std::unordered_map<std::string, uint32_t>::const_iterator it = pooled.find(string);
+				if(it != pooled.end())
+					return it->second;
+
+				const uint32_t offset = static_cast<uint32_t>(pool.size());
+				pool.append(string.c_str(), string.size() + 1);
+				pooled.emplace(string, offset);
+				return offset;
+			};
+
+			for(const std::pair<const std::string, AudioMetadata>& it : _entries) {
+				const AudioMetadata& metadata = it.second;
+				IndexEntry entry;
+				std::memset(&entry, 0, sizeof(entry));
+				entry.modificationTime = metadata.modificationTime;
+				entry.modificationNanoseconds = metadata.modificationNanoseconds;
+				entry.fileSize = metadata.fileSize;
+				entry.frames = metadata.info.frames;
+				entry.sampleRate = metadata.info.samplerate;
+				entry.channels = metadata.info.channels;
+				entry.format = metadata.info.format;
+				entry.sections = metadata.info.sections;
+				entry.seekable = metadata.info.seekable;
+				entry.path = addString(it.first);
+				for(int str = 0; str <= SF_STR_LAST - SF_STR_FIRST; str++)
+					entry.strings[str] = metadata.strings[str].empty() ? indexNoString : addString(metadata.strings[str]);
+
+				if(pool.size() >= indexNoString)
+					return false;
+
+				entries.push_back(entry);
+			}
+
+			IndexHeader header;
+			std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+			header.version = indexVersion;
+			header.byteOrder = indexByteOrder;
+			header.entrySize = sizeof(IndexEntry);
+			header.entryCount = static_cast<uint32_t>(entries.size());
+			header.poolSize = pool.size();
+
+			// Written next to the old file and renamed over it once complete
+			const std::string temporaryPath = std::string(path) + ".tmp";
+			std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+			if(file == AFW_NULLPTR)
+				return false;
+
+			bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+			if(written && !entries.empty())
+				written = std::fwrite(entries.data(), sizeof(IndexEntry), entries.size(), file) == entries.size();
+			if(written && !pool.empty())
+				written = std::fwrite(pool.data(), 1, pool.size(), file) == pool.size();
+			written = std::fclose(file) == 0 && written;
+
+		#if defined(_WIN32)
+			if(written)
+				written = MoveFileExA(temporaryPath.c_str(), path, MOVEFILE_REPLACE_EXISTING) != 0;
+		#else
+			if(written)
+				written = std::rename(temporaryPath.c_str(), path) == 0;
+		#endif
+			if(!written)
+				std::remove(temporaryPath.c_str());
+
+			return written;
+		}
+	}
+}
@@ -0,0 +1,255 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+#include <AuroraFW/Audio/AudioMixer.h>
+#include <AuroraFW/Audio/AudioOutput.h>
+#include <AuroraFW/Audio/AudioDSP.h>
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		// Number of samples read from a voice at a time, the maximum number
+		// of commands waiting to be processed and the maximum number of voices
+		static const size_t mixerScratchSize = 4096;
+		static const size_t mixerCommandsSize = 256;
+		static const size_t mixerVoicesSize = 256;
+
+		// audioMixerCallback
+		int audioMixerCallback(const void* inputBuffer, void* outputBuffer,
+						size_t framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo,
+						PaStreamCallbackFlags statusFlags, void* userData)
+		{
+			float* output = (float*)outputBuffer;
+			AudioMixer* mixer = (AudioMixer*)userData;
+			const size_t samples = framesPerBuffer * mixer->_channels;
+
+			// Applies every voice addition/removal requested since the last callback
+			mixer->_processCommands();
+
+			std::fill(output, output + samples, 0.0f);
+			for(AudioMixer::Voice& voice : mixer->_voices) {
+				if(voice.playing)
+					mixer->_mixVoice(voice, output, framesPerBuffer);
+			}
+
+			// The global volume is applied once, on the final mix
+			const float globalVolume = AudioBackend::getInstance().globalVolume;
+			if(globalVolume != 1.0f) {
+				for(size_t i = 0; i < samples; i++)
+					output[i] *= globalVolume;
+			}
+
+			return paContinue;
+		}
+
+		// AudioMixer
+		AudioMixer::AudioMixer(int channels)
+			: _channels(channels), _commands(mixerCommandsSize)
+		{
+			// The callback can't allocate, so the voices never grow past this
+			_voices.reserve(mixerVoicesSize);
+			_scratch = AFW_NEW float[mixerScratchSize];
+			_chunkGains = AFW_NEW float[_channels * 2];
+
+			AudioDevice device;
+			_sampleRate = device.getDefaultSampleRate();
+
+			// Opens and starts the only output stream, it keeps running
+			// (outputting silence) even when no voice is playing
+			catchPAProblem(Pa_OpenDefaultStream(&_paStream, 0, _channels,
+			paFloat32, _sampleRate, paFramesPerBufferUnspecified,
+			audioMixerCallback, this));
+			catchPAProblem(Pa_StartStream(_paStream));
+
+			AuroraFW::DebugManager::Log("AudioMixer started with ", _channels,
+			" channels at ", _sampleRate, "Hz.");
+		}
+
+		AudioMixer::~AudioMixer()
+		{
+			Pa_StopStream(_paStream);
+			Pa_CloseStream(_paStream);
+
+			// The callback isn't running anymore, so the remaining
+			// commands and voices can be handled here
+			_processCommands();
+			for(Voice& voice : _voices) {
+				voice.stream->_mixer = nullptr;
+				voice.stream->_mixerPlaying.store(false, std::memory_order_relaxed);
+			}
+
+			if(!_voices.empty())
+				CLI::Log(CLI::Warning, "The AudioMixer was stopped with ", _voices.size(),
+				" voices still registered. They were stopped, and will open their own output"
+				" streams if they're played again.");
+
+			delete[] _scratch;
+			delete[] _chunkGains;
+		}
+
+		bool AudioMixer::addVoice(AudioOStream* voice)
+		{
+			// Voices are counted here, as the ones still in the command
+			// queue aren't in the callback's vector yet
+			{
+				std::lock_guard<std::mutex> lock(_commandsMutex);
+				if(_voicesCount == mixerVoicesSize) {
+					CLI::Log(CLI::Warning, "The AudioMixer already has ", mixerVoicesSize,
+					" voices. No more voices can be added!");
+					return false;
+				}
+				_voicesCount++;
+			}
+
+			_sendCommand(CommandType::Add, voice, false);
+			return true;
+		}
+
+		void AudioMixer::removeVoice(AudioOStream* voice)
+		{
+			_sendCommand(CommandType::Remove, voice, true);
+
+			std::lock_guard<std::mutex> lock(_commandsMutex);
+			if(_voicesCount > 0)
+				_voicesCount--;
+		}
+
+		float AudioMixer::getCpuLoad()
+		{
+			return Pa_GetStreamCpuLoad(_paStream);
+		}
+
+		void AudioMixer::_sendCommand(CommandType type, AudioOStream* voice, bool wait)
+		{
+			// Many threads may send commands, but the queue only
+			// supports a single producer
+			std::unique_lock<std::mutex> lock(_commandsMutex);
+			const Command command = { type, voice };
+			while(_commands.write(&command, 1) == 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+			const size_t sent = ++_commandsSent;
+			lock.unlock();
+
+			// Waits for the callback to get to this command
+			if(wait) {
+				while(_commandsProcessed.load(std::memory_order_acquire) < sent)
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		void AudioMixer::_processCommands()
+		{
+			Command command;
+			while(_commands.read(&command, 1) == 1) {
+				switch(command.type) {
+					case CommandType::Add:
+						// addVoice() keeps the count within the reserved capacity
+						if(_voices.size() < _voices.capacity())
+							_voices.push_back({ command.voice, false });
+						break;
+					case CommandType::Remove:
+						for(size_t i = 0; i < _voices.size(); i++) {
+							if(_voices[i].stream == command.voice) {
+								_voices[i] = _voices.back();
+								_voices.pop_back();
+								break;
+							}
+						}
+						break;
+					case CommandType::Play:
+					case CommandType::Stop:
+						for(Voice& voice : _voices) {
+							if(voice.stream == command.voice)
+								voice.playing = command.type == CommandType::Play;
+						}
+						break;
+				}
+
+				_commandsProcessed.fetch_add(1, std::memory_order_release);
+			}
+		}
+
+		void AudioMixer::_mixVoice(Voice& voice, float* output, size_t framesPerBuffer)
+		{
+			AudioOStream* stream = voice.stream;
+			const int voiceChannels = stream->audioInfo.getChannels();
+
+			// Gains are calculated for the mixer's channels, not the voice's, and
+			// ramped from the last callback's ones along the whole buffer
+			float* gains = stream->_gains;
+			float* lastGains = stream->_lastGains;
+			stream->_calculateGains(gains, _channels, false);
+			if(!stream->_rampGains)
+				std::copy(gains, gains + _channels, lastGains);
+
+			// Gains of the current chunk
+			float* startGains = _chunkGains;
+			float* endGains = _chunkGains + _channels;
+
+			const size_t chunkFrames = mixerScratchSize / voiceChannels;
+			size_t mixedFrames = 0;
+			while(mixedFrames < framesPerBuffer) {
+				const size_t framesNow = std::min(chunkFrames, framesPerBuffer - mixedFrames);
+				bool reachedEnd;
+				const size_t readFrames = stream->_readFrames(_scratch, framesNow, reachedEnd);
+
+				for(int c = 0; c < _channels; c++) {
+					const float step = (gains[c] - lastGains[c]) / framesPerBuffer;
+					startGains[c] = lastGains[c] + step * mixedFrames;
+					endGains[c] = lastGains[c] + step * (mixedFrames + framesNow);
+				}
+
+				// Mono voices are spread to every channel, otherwise
+				// the channels the mixer doesn't have are dropped
+				float* mix = output + mixedFrames * _channels;
+				if(voiceChannels == _channels) {
+					mixGainRamp(mix, _scratch, readFrames, _channels, startGains, endGains);
+				} else {
+					for(size_t f = 0; f < readFrames; f++) {
+						const float* frame = _scratch + f * voiceChannels;
+						for(int c = 0; c < _channels; c++) {
+							const float gain = startGains[c]
+							+ (endGains[c] - startGains[c]) * f / framesNow;
+							if(voiceChannels == 1)
+								mix[c] += frame[0] * gain;
+							else if(c < voiceChannels)
+								mix[c] += frame[c] * gain;
+						}
+						mix += _channels;
+					}
+				}
+
+				mixedFrames += framesNow;
+
+				if(reachedEnd && stream->audioPlayMode == AudioPlayMode::Once) {
+					voice.playing = false;
+					stream->_mixerPlaying.store(false, std::memory_order_release);
+					break;
+				}
+			}
+
+			std::copy(gains, gains + _channels, lastGains);
+			stream->_rampGains = true;
+		}
+	}
+}
@@ -17,6 +17,13 @@
 ****************************************************************************/
 
 #include <AuroraFW/Audio/AudioOutput.h>
+#include <AuroraFW/Audio/AudioDSP.h>
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
 
 namespace AuroraFW {
 	namespace AudioManager {
@@ -36,78 +43,31 @@ namespace AuroraFW {
 						size_t framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo,
 						PaStreamCallbackFlags statusFlags, void* userData)
 		{
-			#pragma message("TODO: Cleanup this method as much as possible")
 			// Gets the output buffer (it's of type paFloat32), and
 			// the audioStream and audioInfo
 			float* output = (float*)outputBuffer;
 			AudioOStream* audioStream = (AudioOStream*)userData;
-			AudioInfo* audioInfo = &(audioStream->audioInfo);
+			const int channels = audioStream->audioInfo.getChannels();
 
 			// Reads the audio
-			size_t readFrames = 0, offset = 0, framesToRead = framesPerBuffer;
-			do {
-				int readFramesNow;
-				if(audioStream->_buffer != nullptr) {	// Buffered
-					readFramesNow = (framesToRead + audioStream->_streamPosFrame)
-					> audioInfo->getFrames()
-					? audioInfo->getFrames() - audioStream->_streamPosFrame
-					: framesToRead;
-
-					for(size_t f = 0; f < readFramesNow; f++) {
-						for(uint8_t c = 0; c < audioInfo->getChannels(); c++) {
-							output[(offset * audioInfo->getChannels())
-							+ f * audioInfo->getChannels() + c]
-							= audioStream->_buffer[audioStream->_streamPosFrame
-							* audioInfo->getChannels() + (f * audioInfo->getChannels()
-							+ c)];
-						}
-					}
-				} else {	// Streaming
-					readFramesNow = sf_readf_float(audioInfo->_sndFile, output
-					+ (offset * audioInfo->getChannels()), framesToRead);
-				}
-
-				audioStream->_streamPosFrame += readFramesNow;
-				framesToRead -= readFramesNow;
-				readFrames += readFramesNow;
-
-				if(framesToRead > 0 && audioStream->audioPlayMode
-					== AudioPlayMode::Loop) {
-					audioStream->_streamPosFrame = 0;
-					audioStream->_loops++;
-					offset += readFramesNow;
-					if(audioStream->_buffer == nullptr)	// Streaming
-						sf_seek(audioInfo->_sndFile, 0, SF_SEEK_SET);
-				}
-			} while(framesToRead > 0 && audioStream->audioPlayMode
-					!= AudioPlayMode::Once);
-			// Adjusts the volume of each frame
-			for(size_t i = 0; i < readFrames; i++) {
-				// Applies the volume to all channels the sound might have
-				for(uint8_t channels = 0; channels < audioInfo->getChannels();
-					channels++) {
-					float frame = *output;
-
-					// In case there's 3D audio, calculates 3D audio
-					if(audioStream->_audioSource != nullptr) {
-						AudioSource* source = audioStream->_audioSource;
-						const float panning = source->getPanning();
-						if(channels == 0)
-							frame *= (-0.5f * panning + 0.5f);
-						else if(channels == 1)
-							frame *= (0.5f * panning + 0.5f);
-					}
-
-					frame *= audioStream->volume
-					* AudioBackend::getInstance().globalVolume;
-
-					*output++ = frame;
-				}
-			}
+			bool reachedEnd;
+			size_t readFrames = audioStream->_readFrames(output, framesPerBuffer, reachedEnd);
+
+			// Adjusts the volume of each frame, the gains are only calculated
+			// once per buffer and ramped from the previous buffer's ones
+			float* gains = audioStream->_gains;
+			float* lastGains = audioStream->_lastGains;
+			audioStream->_calculateGains(gains, channels, true);
+			if(audioStream->_rampGains)
+				applyGainRamp(output, readFrames, channels, lastGains, gains);
+			else
+				applyGains(output, readFrames, channels, gains);
+
+			std::copy(gains, gains + channels, lastGains);
+			audioStream->_rampGains = true;
 
 			// If the read frames didn't fill the buffer to read, it reached EOF
-			if(readFrames < framesPerBuffer && audioStream->audioPlayMode
-				== AudioPlayMode::Once)
+			if(reachedEnd && audioStream->audioPlayMode == AudioPlayMode::Once)
 				return paComplete;
 
 			return paContinue;
@@ -141,117 +101,107 @@ namespace AuroraFW {
 
 		// AudioSource
 		AudioSource::AudioSource()
-			: _position(Math::Vector3D())
-		{
-			calculateValues();
-		}
+			: AudioSource(Math::Vector3D())
+		{}
 
 		AudioSource::AudioSource(const Math::Vector3D vec)
-			: _position(vec)
 		{
+			_index = AudioListener::getInstance()._addSource(this, vec, 10, 100, falloutType);
 			calculateValues();
 		}
 
 		AudioSource::AudioSource(const float x, const float y, const float z)
-			: _position(Math::Vector3D(x, y, z))
+			: AudioSource(Math::Vector3D(x, y, z))
+		{}
+
+		AudioSource::AudioSource(const AudioSource& audioSource)
+			: falloutType(audioSource.falloutType)
 		{
+			AudioListener& listener = AudioListener::getInstance();
+			const size_t index = audioSource._index;
+			_index = listener._addSource(this, Math::Vector3D(listener._sourceX[index],
+			listener._sourceY[index], listener._sourceZ[index]),
+			listener._sourceMedDistance[index], listener._sourceMaxDistance[index], falloutType);
 			calculateValues();
 		}
 
-		AudioSource::AudioSource(const AudioSource& audioSource)
-			: falloutType(audioSource.falloutType),
-			_position(audioSource._position),
-			_medDistance(audioSource._medDistance),
-			_maxDistance(audioSource._maxDistance)
+		AudioSource::~AudioSource()
 		{
-			calculateValues();
+			// The listener may have been terminated already
+			if(AudioListener::_instance != nullptr)
+				AudioListener::_instance->_removeSource(_index);
 		}
 
 		void AudioSource::setPosition(Math::Vector3D position)
 		{
-			_position = position;
-			_calculatePan();
+			AudioListener& listener = AudioListener::getInstance();
+			listener._sourceX[_index] = position.x;
+			listener._sourceY[_index] = position.y;
+			listener._sourceZ[_index] = position.z;
+			calculateValues();
 		}
 
 		void AudioSource::setMedDistance(float medDistance)
 		{
-			_medDistance = medDistance;
-			_calculateStrength();
+			AudioListener::getInstance()._sourceMedDistance[_index] = medDistance;
+			calculateValues();
 		}
 
 		void AudioSource::setMaxDistance(float maxDistance)
 		{
-			_maxDistance = maxDistance;
-			_calculateStrength();
+			AudioListener::getInstance()._sourceMaxDistance[_index] = maxDistance;
+			calculateValues();
 		}
 
 		float AudioSource::getPanning()
 		{
-			return _pan;
+			return AudioListener::getInstance()._sourcePan[_index];
 		}
 
 		float AudioSource::getStrength()
 		{
-			return _strength;
+			return AudioListener::getInstance()._sourceStrength[_index];
 		}
 
 		Math::Vector3D AudioSource::getPosition()
 		{
-			return _position;
+			AudioListener& listener = AudioListener::getInstance();
+			return Math::Vector3D(listener._sourceX[_index], listener._sourceY[_index],
+			listener._sourceZ[_index]);
 		}
 
 		float AudioSource::getMedDistance()
 		{
-			return _medDistance;
+			return AudioListener::getInstance()._sourceMedDistance[_index];
 		}
 
 		float AudioSource::getMaxDistance()
 		{
-			return _maxDistance;
+			return AudioListener::getInstance()._sourceMaxDistance[_index];
 		}
 
 		void AudioSource::calculateValues()
 		{
-			_calculatePan();
-			_calculateStrength();
+			AudioListener& listener = AudioListener::getInstance();
+			listener._sourceFallout[_index] = falloutType;
+			listener._updateSources(_index, _index + 1);
 		}
 
-		void AudioSource::_calculatePan()
+		void AudioSource::_publishGains(float pan, float strength)
 		{
-			Math::Vector3D listenerPos = AudioListener::getInstance().position;
-			Math::Vector3D listenerDir = AudioListener::getInstance().direction;
-
-			#pragma message("TODO: Values are hardcoded (see info on code)")
-			// TODO: Right now it's hardcoded because the camera, under normal
-			// circunstances, doesn't \"tilt\". Make less dirty later
-			Math::Vector3D listenerUp = Math::Vector3D(0, 1, 0);
-
-			#pragma message("FIXME: Not using matrixes (see info on code)")
-			// FIXME: The method to obtain the perpendicular to both dir and
-			// lookUp didn't use matrixes , because I am inexperienced on it.
-			// This is where I got the formula:
-			// https://math.stackexchange.com/questions/501949/determining-a-perpendicular-vector-to-two-given-vectors
-			// however, this is dirty and should be cleaned up.)
-			float x = listenerDir.y * listenerUp.z - listenerDir.z * listenerUp.y;
-			float y = listenerDir.z * listenerUp.x - listenerDir.x * listenerUp.z;
-			float z = listenerDir.x * listenerUp.y - listenerDir.y * listenerUp.x;
-
-			Math::Vector3D cross = Math::Vector3D(x, y, z);
-			cross.normalize();
-
-			// Makes a copy of position, since it needs to be manipulated
-			// to calculate the panning
-			Math::Vector3D sourcePos = _position;
-			sourcePos -= listenerPos;
-
-			_pan = cross.dot(sourcePos.normalized());
+			const float values[2] = { pan, strength };
+			uint64_t gains;
+			std::memcpy(&gains, values, sizeof(gains));
+			_gains.store(gains, std::memory_order_release);
 		}
 
-		void AudioSource::_calculateStrength()
+		void AudioSource::_loadGains(float& pan, float& strength) const
 		{
-			#pragma message ("TODO: Need to be implemented")
-			float distance = Math::abs(_position.distanceToPoint
-			(AudioListener::getInstance().position));
+			const uint64_t gains = _gains.load(std::memory_order_acquire);
+			float values[2];
+			std::memcpy(values, &gains, sizeof(values));
+			pan = values[0];
+			strength = values[1];
 		}
 
 		// AudioOStream
@@ -266,23 +216,79 @@ namespace AuroraFW {
 				device.getDefaultSampleRate(), 256, debugCallback, NULL));
 		}
 
-		AudioOStream::AudioOStream(const char* path, AudioSource* audioSource, bool buffered)
+		AudioOStream::AudioOStream(const char* path, AudioSource* audioSource, bool buffered,
+			size_t streamBufferFrames)
 			: audioInfo(), _audioSource(audioSource)
 		{
 			audioInfo._sndFile = sf_open(path, SFM_READ, audioInfo._sndInfo);
 
+			// If the soundFile is null, it means there was no audio file
+			if(audioInfo._sndFile == nullptr)
+				throw AudioFileNotFound(path);
+
 			// If the audio should be buffered, do so
 			if(buffered) {
-				AuroraFW::DebugManager::Log("Buffering the audio..."
-				"(Total frames: ", audioInfo.getFrames() * audioInfo.getChannels(), ")");
-				_buffer = AFW_NEW float[audioInfo.getFrames() * audioInfo.getChannels()];
-				sf_readf_float(audioInfo._sndFile, _buffer, audioInfo.getFrames());
-				AuroraFW::DebugManager::Log("Buffering complete.");
+				// Uncompressed files are read straight from their mapped pages
+				_mappedFile = AudioMappedFile::open(path, audioInfo._sndFile, audioInfo._sndInfo);
+				if(_mappedFile == nullptr) {
+					// Everything else is decoded once and shared by every stream playing it
+					_sampleBuffer = AudioBackend::getInstance().getSampleCache()
+					.load(path, audioInfo._sndFile, audioInfo._sndInfo);
+					_buffer = _sampleBuffer->getSamples();
+				}
+			} else {
+				_ringBuffer = AFW_NEW AudioRingBuffer<float>(streamBufferFrames
+				* audioInfo.getChannels());
+
+				// Keeps the next blocks of the file coming in while the loader decodes
+				audioInfo.setIOReadAhead(4);
 			}
 
-			// If the soundFile is null, it means there was no audio file
-			if(audioInfo._sndFile == nullptr)
-				throw AudioFileNotFound(path);
+			_openOutput();
+		}
+
+		AudioOStream::AudioOStream(const std::shared_ptr<const AudioMemoryFile>& memory, AudioSource* audioSource,
+			bool buffered, size_t streamBufferFrames)
+			: audioInfo(), _audioSource(audioSource)
+		{
+			// If the soundFile is null, the memory doesn't hold any audio file
+			if(!audioInfo._openMemory(memory))
+				throw AudioFileNotFound("<memory>");
+
+			if(buffered) {
+				// Uncompressed data is read in place, everything else is decoded once
+				_mappedFile = AudioMappedFile::open(memory, audioInfo._sndFile, audioInfo._sndInfo);
+				if(_mappedFile == nullptr) {
+					_sampleBuffer = AudioBackend::getInstance().getSampleCache()
+					.load(nullptr, audioInfo._sndFile, audioInfo._sndInfo);
+					_buffer = _sampleBuffer->getSamples();
+				}
+			} else {
+				_ringBuffer = AFW_NEW AudioRingBuffer<float>(streamBufferFrames
+				* audioInfo.getChannels());
+			}
+
+			_openOutput();
+		}
+
+		void AudioOStream::_openOutput()
+		{
+			// If there's a mixer, becomes one of its voices
+			_mixer = AudioBackend::getInstance().getMixer();
+			if(_mixer != nullptr) {
+				_gains = AFW_NEW float[_mixer->getChannels()];
+				_lastGains = AFW_NEW float[_mixer->getChannels()];
+				if(_mixer->addVoice(this))
+					return;
+
+				// The mixer is full, so falls back to a stream of its own
+				_mixer = nullptr;
+				delete[] _gains;
+				delete[] _lastGains;
+			}
+
+			_gains = AFW_NEW float[audioInfo.getChannels()];
+			_lastGains = AFW_NEW float[audioInfo.getChannels()];
 
 			AudioDevice device;
 
@@ -292,11 +298,34 @@ namespace AuroraFW {
 			paFramesPerBufferUnspecified, audioOutputCallback, this));
 		}
 
+		AudioOStream::AudioOStream(const char* path, const std::shared_future<AudioLoadResult>& load,
+			AudioSource* audioSource, size_t streamBufferFrames)
+			: AudioOStream(path, audioSource, false, streamBufferFrames)
+		{
+			_pendingLoad = load;
+			_adoptLoad();
+		}
+
 		AudioOStream::~AudioOStream()
 		{
-			// Deletes the buffer
-			if(_buffer != AFW_NULLPTR)
-				delete[] _buffer;
+			// Makes sure neither the mixer nor an output stream of its
+			// own reads from this stream anymore
+			if(_mixer != nullptr)
+				_mixer->removeVoice(this);
+			else if(_paStream != nullptr)
+				Pa_CloseStream(_paStream);
+
+			// Stops the decoder before its ring buffer goes away
+			_stopDecoder();
+			if(_ringBuffer != AFW_NULLPTR)
+				delete _ringBuffer;
+
+			// Deletes the buffers
+			if(_gains != AFW_NULLPTR)
+				delete[] _gains;
+
+			if(_lastGains != AFW_NULLPTR)
+				delete[] _lastGains;
 
 			// Deletes audioSource
 			if(_audioSource != AFW_NULLPTR)
@@ -305,24 +334,52 @@ namespace AuroraFW {
 
 		void AudioOStream::play()
 		{
-			sf_seek(audioInfo._sndFile, _streamPosFrame, SF_SEEK_SET);
-			catchPAProblem(Pa_StartStream(_paStream));
+			if(_ringBuffer != nullptr)
+				_startDecoder();
+
+			// There's nothing to ramp from on the first buffer
+			_rampGains = false;
+
+			// The mixer this stream was a voice of has been stopped, so it
+			// opens an output of its own (or joins a mixer started since)
+			if(_mixer == nullptr && _paStream == nullptr) {
+				delete[] _gains;
+				delete[] _lastGains;
+				_openOutput();
+			}
+
+			if(_mixer != nullptr) {
+				_mixerPlaying.store(true, std::memory_order_relaxed);
+				_mixer->_sendCommand(AudioMixer::CommandType::Play, this, false);
+			} else {
+				catchPAProblem(Pa_StartStream(_paStream));
+			}
 		}
 
 		void AudioOStream::pause()
 		{
-			catchPAProblem(Pa_StopStream(_paStream));
+			if(_mixer != nullptr) {
+				_mixer->_sendCommand(AudioMixer::CommandType::Stop, this, true);
+				_mixerPlaying.store(false, std::memory_order_relaxed);
+			} else if(_paStream != nullptr) {
+				catchPAProblem(Pa_StopStream(_paStream));
+			}
+
+			_stopDecoder();
 		}
 
 		void AudioOStream::stop()
 		{
+			pause();
 			_streamPosFrame = 0;
-			
-			catchPAProblem(Pa_StopStream(_paStream));
 		}
 
 		bool AudioOStream::isPlaying()
 		{
+			if(_mixer != nullptr)
+				return _mixerPlaying.load(std::memory_order_acquire);
+			if(_paStream == nullptr)
+				return false;
 			return Pa_IsStreamActive(_paStream);
 		}
 
@@ -333,6 +390,10 @@ namespace AuroraFW {
 
 		bool AudioOStream::isStopped()
 		{
+			if(_mixer != nullptr)
+				return !_mixerPlaying.load(std::memory_order_acquire);
+			if(_paStream == nullptr)
+				return true;
 			return Pa_IsStreamStopped(_paStream);
 		}
 
@@ -359,7 +420,289 @@ namespace AuroraFW {
 
 		float AudioOStream::getCpuLoad()
 		{
+			if(_mixer != nullptr)
+				return _mixer->getCpuLoad();
+			if(_paStream == nullptr)
+				return 0;
 			return Pa_GetStreamCpuLoad(_paStream);
 		}
+
+		size_t AudioOStream::readPlanar(float* const* planes, size_t frames)
+		{
+			const int channels = audioInfo.getChannels();
+			const sf_count_t totalFrames = audioInfo.getFrames();
+			const bool buffered = _ringBuffer == nullptr || _loadReady.load(std::memory_order_acquire);
+			std::vector<float*> outPlanes(channels);
+			std::vector<float> chunk;
+			size_t readFrames = 0;
+
+			// The callback moves the read position while playing, and the decoder
+			// thread seeks the same file until the stream is paused or stopped
+			const bool inUse = isPlaying() || (!buffered && _decoderThread.joinable());
+
+			while(!inUse && readFrames < frames && totalFrames > 0) {
+				if(_streamPosFrame >= totalFrames) {
+					if(audioPlayMode != AudioPlayMode::Loop)
+						break;
+					_streamPosFrame = 0;
+					_loops++;
+				}
+
+				size_t readFramesNow = static_cast<size_t>(std::min<sf_count_t>(frames - readFrames,
+				totalFrames - _streamPosFrame));
+
+				if(!buffered) {
+					// The decoder thread isn't running while the stream doesn't play,
+					// and seeks the file again when it starts
+					for(int c = 0; c < channels; c++)
+						outPlanes[c] = planes[c] + readFrames;
+
+					sf_seek(audioInfo._sndFile, _streamPosFrame, SF_SEEK_SET);
+					sf_count_t fileFrames = audioInfo.readPlanar(outPlanes.data(), readFramesNow);
+					if(fileFrames <= 0)
+						break;
+					readFramesNow = static_cast<size_t>(fileFrames);
+				} else {
+					// Buffered samples are interleaved, the mapped ones are converted first
+					const float* input;
+					if(_mappedFile != nullptr) {
+						readFramesNow = std::min<size_t>(readFramesNow, 4096);
+						chunk.resize(readFramesNow * channels);
+						size_t mappedFrames = _mappedFile->read(chunk.data(), _streamPosFrame, readFramesNow);
+						std::fill(chunk.begin() + mappedFrames * channels, chunk.end(), 0.0f);
+						input = chunk.data();
+					} else {
+						input = _buffer + _streamPosFrame * channels;
+					}
+
+					for(int c = 0; c < channels; c++) {
+						float* output = planes[c] + readFrames;
+						for(size_t i = 0; i < readFramesNow; i++)
+							output[i] = input[i * channels + c];
+					}
+				}
+
+				_streamPosFrame += readFramesNow;
+				readFrames += readFramesNow;
+			}
+
+			for(int c = 0; c < channels; c++)
+				std::fill(planes[c] + readFrames, planes[c] + frames, 0.0f);
+
+			return readFrames;
+		}
+
+		size_t AudioOStream::_readFrames(float* output, size_t framesPerBuffer, bool& reachedEnd)
+		{
+			size_t readFrames = 0, offset = 0, framesToRead = framesPerBuffer;
+			reachedEnd = false;
+			if(_ringBuffer == nullptr || _loadReady.load(std::memory_order_acquire)) {	// Buffered
+				do {
+					const sf_count_t framesLeft = std::max<sf_count_t>(audioInfo.getFrames()
+					- _streamPosFrame, 0);
+					const size_t readFramesNow = (sf_count_t)framesToRead > framesLeft
+					? (size_t)framesLeft
+					: framesToRead;
+
+					float* out = output + offset * audioInfo.getChannels();
+					if(_mappedFile != nullptr) {
+						// The header may promise more frames than the file holds
+						size_t mappedFrames = _mappedFile->read(out, _streamPosFrame, readFramesNow);
+						std::fill(out + mappedFrames * audioInfo.getChannels(),
+						out + readFramesNow * audioInfo.getChannels(), 0.0f);
+					} else {
+						std::copy(_buffer + _streamPosFrame * audioInfo.getChannels(),
+						_buffer + (_streamPosFrame + readFramesNow) * audioInfo.getChannels(), out);
+					}
+
+					_streamPosFrame += readFramesNow;
+					framesToRead -= readFramesNow;
+					readFrames += readFramesNow;
+
+					if(framesToRead > 0 && audioPlayMode == AudioPlayMode::Loop) {
+						_streamPosFrame = 0;
+						_loops++;
+						offset += readFramesNow;
+					}
+				} while(framesToRead > 0 && audioPlayMode != AudioPlayMode::Once);
+
+				reachedEnd = readFrames < framesPerBuffer;
+			} else {	// Streaming
+				// The EOF flag must be read before the ring buffer, otherwise the
+				// decoder could push its last frames between both reads
+				const int channels = audioInfo.getChannels();
+				const bool decoderEOF = _decoderEOF.load(std::memory_order_acquire);
+				readFrames = _ringBuffer->read(output, framesPerBuffer * channels) / channels;
+
+				// The decoder already rewinds the file, this only keeps track of it
+				_streamPosFrame += readFrames;
+				if(audioPlayMode == AudioPlayMode::Loop && audioInfo.getFrames() > 0) {
+					while(_streamPosFrame >= audioInfo.getFrames()) {
+						_streamPosFrame -= audioInfo.getFrames();
+						_loops++;
+					}
+				}
+
+				if(readFrames < framesPerBuffer) {
+					std::fill(output + readFrames * channels,
+					output + framesPerBuffer * channels, 0.0f);
+
+					if(decoderEOF)
+						reachedEnd = true;
+					else
+						_underruns.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			return readFrames;
+		}
+
+		void AudioOStream::_calculateGains(float* gains, int channels, bool withGlobalVolume)
+		{
+			float gain = volume;
+			if(withGlobalVolume)
+				gain *= AudioBackend::getInstance().globalVolume;
+
+			// In case there's 3D audio, adds the source's panning
+			float panning = pan;
+			if(_audioSource != nullptr) {
+				float sourcePan, sourceStrength;
+				_audioSource->_loadGains(sourcePan, sourceStrength);
+				gain *= sourceStrength;
+				panning += sourcePan;
+			}
+			panning = std::max(-1.0f, std::min(1.0f, panning));
+
+			// Panning only affects the first two (left and right) channels
+			for(int c = 0; c < channels; c++) {
+				if(c == 0)
+					gains[c] = gain * (-0.5f * panning + 0.5f);
+				else if(c == 1)
+					gains[c] = gain * (0.5f * panning + 0.5f);
+				else
+					gains[c] = gain;
+			}
+		}
+
+		void AudioOStream::_startDecoder()
+		{
+			// Whatever the ring buffer still has is ahead of the current
+			// position, so it's thrown away and decoded again from there
+			_stopDecoder();
+			if(_adoptLoad())
+				return;
+
+			_ringBuffer->clear();
+			sf_seek(audioInfo._sndFile, _streamPosFrame, SF_SEEK_SET);
+			_decoderEOF.store(false, std::memory_order_relaxed);
+
+			// Fills half of the ring buffer here, before play() starts the
+			// output, so its first callbacks don't run dry. The decoder thread
+			// keeps it filled from then on
+			const int channels = audioInfo.getChannels();
+			const size_t ringFrames = _ringBuffer->getCapacity() / channels;
+			const size_t chunkFrames = ringFrames / 4 > 0 ? ringFrames / 4 : 1;
+			float* chunk = AFW_NEW float[chunkFrames * channels];
+			while(_ringBuffer->getReadAvailable() / channels < ringFrames / 2) {
+				if(!_decodeChunk(chunk, chunkFrames))
+					break;
+			}
+			delete[] chunk;
+
+			_decoderRunning = true;
+			_decoderThread = std::thread(&AudioOStream::_decoderLoop, this);
+		}
+
+		void AudioOStream::_stopDecoder()
+		{
+			if(!_decoderThread.joinable())
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock(_decoderMutex);
+				_decoderRunning = false;
+			}
+			_decoderCondition.notify_one();
+			_decoderThread.join();
+		}
+
+		void AudioOStream::_decoderLoop()
+		{
+			const int channels = audioInfo.getChannels();
+			const size_t ringFrames = _ringBuffer->getCapacity() / channels;
+			const size_t chunkFrames = ringFrames / 4 > 0 ? ringFrames / 4 : 1;
+			float* chunk = AFW_NEW float[chunkFrames * channels];
+
+			// Sleeps for about a quarter of the ring buffer between refills
+			const std::chrono::microseconds refillInterval(audioInfo.getSampleRate() > 0
+			? chunkFrames * 1000000 / audioInfo.getSampleRate() : 10000);
+
+			std::unique_lock<std::mutex> lock(_decoderMutex);
+			while(_decoderRunning) {
+				// Once the background load completes, the callback reads from it instead
+				if(_adoptLoad())
+					break;
+
+				size_t freeFrames = _ringBuffer->getWriteAvailable() / channels;
+				if(_decoderEOF.load(std::memory_order_relaxed) || freeFrames < chunkFrames) {
+					_decoderCondition.wait_for(lock, refillInterval);
+					continue;
+				}
+
+				// The disk is read without holding the lock, so stopping
+				// the decoder doesn't wait for it longer than needed
+				lock.unlock();
+				while(freeFrames >= chunkFrames && _decodeChunk(chunk, chunkFrames))
+					freeFrames = _ringBuffer->getWriteAvailable() / channels;
+				lock.lock();
+			}
+
+			delete[] chunk;
+		}
+
+		bool AudioOStream::_decodeChunk(float* chunk, size_t chunkFrames)
+		{
+			const int channels = audioInfo.getChannels();
+			sf_count_t readFrames = sf_readf_float(audioInfo._sndFile, chunk, chunkFrames);
+			if(readFrames > 0)
+				_ringBuffer->write(chunk, readFrames * channels);
+
+			if(readFrames < static_cast<sf_count_t>(chunkFrames)) {
+				if(audioPlayMode == AudioPlayMode::Loop && audioInfo.getFrames() > 0) {
+					sf_seek(audioInfo._sndFile, 0, SF_SEEK_SET);
+				} else {
+					_decoderEOF.store(true, std::memory_order_release);
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool AudioOStream::_adoptLoad()
+		{
+			if(_loadReady.load(std::memory_order_relaxed))
+				return true;
+
+			if(!_pendingLoad.valid()
+				|| _pendingLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				return false;
+
+			try {
+				const AudioLoadResult& result = _pendingLoad.get();
+				_mappedFile = result.mappedFile;
+				_sampleBuffer = result.sampleBuffer;
+				if(_sampleBuffer != nullptr)
+					_buffer = _sampleBuffer->getSamples();
+
+				// The callback only looks at the buffers after seeing the flag
+				_loadReady.store(true, std::memory_order_release);
+			} catch(const std::exception& e) {
+				CLI::Log(CLI::Warning, "Background load failed, the stream keeps streaming from disk: ", e.what());
+			}
+
+			_pendingLoad = std::shared_future<AudioLoadResult>();
+			return _loadReady.load(std::memory_order_relaxed);
+		}
 	}
 }
@@ -0,0 +1,160 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+#include <AuroraFW/Audio/AudioTranscoder.h>
+#include <AuroraFW/Audio/AudioBackend.h>
+#include <AuroraFW/Audio/AudioOutput.h>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		// Frames converted per read/write call
+		static const sf_count_t transcodeChunkFrames = 4096;
+
+		// Integer sources are copied as ints, which is lossless between integer formats.
+		// Floating point sources go through doubles so values above full scale survive.
+		static inline bool isFloatFormat(int format)
+		{
+			switch(format & SF_FORMAT_SUBMASK) {
+				case SF_FORMAT_FLOAT:
+				case SF_FORMAT_DOUBLE:
+				case SF_FORMAT_VORBIS:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		AudioTranscoder::AudioTranscoder(unsigned int workers)
+			: _workers(workers)
+		{
+			_buffers.resize(_workers.getNumWorkers());
+		}
+
+		AudioTranscoder::~AudioTranscoder()
+		{}
+
+		std::shared_future<AudioTranscodeResult> AudioTranscoder::transcode(const char* source,
+			const char* destination, int format)
+		{
+			std::shared_future<AudioTranscodeResult> future;
+			_workers.push(_task(source, destination, format, future));
+
+			return future;
+		}
+
+		std::vector<std::shared_future<AudioTranscodeResult>> AudioTranscoder::transcode(
+			const std::vector<std::pair<std::string, std::string>>& files, int format)
+		{
+			std::vector<std::shared_future<AudioTranscodeResult>> futures(files.size());
+			std::vector<AudioWorkerPool::Task> tasks;
+			tasks.reserve(files.size());
+			for(size_t i = 0; i < files.size(); i++)
+				tasks.push_back(_task(files[i].first, files[i].second, format, futures[i]));
+
+			_workers.push(tasks);
+
+			return futures;
+		}
+
+		void AudioTranscoder::wait()
+		{
+			_workers.wait();
+		}
+
+		size_t AudioTranscoder::getNumPending() const
+		{
+			return _workers.getNumPending();
+		}
+
+		AudioWorkerPool::Task AudioTranscoder::_task(const std::string& source, const std::string& destination,
+			int format, std::shared_future<AudioTranscodeResult>& future)
+		{
+			// Shared, as a task has to be copyable
+			std::shared_ptr<std::promise<AudioTranscodeResult>> promise = std::make_shared<std::promise<AudioTranscodeResult>>();
+			future = promise->get_future().share();
+
+			return [this, source, destination, format, promise](unsigned int worker, double queueTime) {
+				try {
+					promise->set_value(_transcode(source, destination, format, queueTime, _buffers[worker]));
+				} catch(...) {
+					promise->set_exception(std::current_exception());
+				}
+			};
+		}
+
+		AudioTranscodeResult AudioTranscoder::_transcode(const std::string& source, const std::string& destination,
+			int format, double queueTime, Buffers& buffers)
+		{
+			AudioTranscodeResult result;
+			result.source = source;
+			result.destination = destination;
+			result.queueTime = queueTime;
+
+			const std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+
+			SF_INFO sourceInfo;
+			sourceInfo.format = 0;
+			SNDFILE* sourceFile = sf_open(source.c_str(), SFM_READ, &sourceInfo);
+			if(sourceFile == AFW_NULLPTR)
+				throw AudioFileNotFound(source.c_str());
+
+			SF_INFO destinationInfo;
+			destinationInfo.samplerate = sourceInfo.samplerate;
+			destinationInfo.channels = sourceInfo.channels;
+			destinationInfo.format = format;
+			SNDFILE* destinationFile = sf_open(destination.c_str(), SFM_WRITE, &destinationInfo);
+			if(destinationFile == AFW_NULLPTR) {
+				const int error = sf_error(AFW_NULLPTR);
+				sf_close(sourceFile);
+				throw SNDFILEErrorException(error);
+			}
+
+			for(int str = SF_STR_FIRST; str <= SF_STR_LAST; str++) {
+				const char* string = sf_get_string(sourceFile, str);
+				if(string != AFW_NULLPTR)
+					sf_set_string(destinationFile, str, string);
+			}
+
+			const size_t chunkSamples = transcodeChunkFrames * sourceInfo.channels;
+			sf_count_t frames;
+			if(isFloatFormat(sourceInfo.format)) {
+				// Integer destinations clip instead of wrapping around
+				sf_command(destinationFile, SFC_SET_CLIPPING, AFW_NULLPTR, SF_TRUE);
+
+				if(buffers.samplesDouble.size() < chunkSamples)
+					buffers.samplesDouble.resize(chunkSamples);
+				while((frames = sf_readf_double(sourceFile, buffers.samplesDouble.data(), transcodeChunkFrames)) > 0)
+					result.frames += sf_writef_double(destinationFile, buffers.samplesDouble.data(), frames);
+			} else {
+				if(buffers.samples.size() < chunkSamples)
+					buffers.samples.resize(chunkSamples);
+				while((frames = sf_readf_int(sourceFile, buffers.samples.data(), transcodeChunkFrames)) > 0)
+					result.frames += sf_writef_int(destinationFile, buffers.samples.data(), frames);
+			}
+
+			const int sourceError = sf_close(sourceFile);
+			const int destinationError = sf_close(destinationFile);
+			catchSNDFILEProblem(sourceError);
+			catchSNDFILEProblem(destinationError);
+
+			result.transcodeTime = AudioWorkerPool::millisecondsBetween(startedAt, std::chrono::steady_clock::now());
+
+			return result;
+		}
+	}
+}
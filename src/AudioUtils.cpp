@@ -19,13 +19,41 @@
 #include <AuroraFW/Audio/AudioUtils.h>
 #include <AuroraFW/Audio/AudioBackend.h>
 
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
 namespace AuroraFW {
 	namespace AudioManager {
 		// AudioInfo
 		AudioInfo::AudioInfo(SF_INFO* sndInfo, SNDFILE* sndFile)
-			: _sndInfo(sndInfo), _sndFile(sndFile)
+			: _sndInfo(sndInfo), _sndFile(sndFile), _ioBufferSize(-1), _ioReadAhead(-1)
 		{}
 
+		AudioInfo::AudioInfo(const void* data, sf_count_t size)
+			: AudioInfo()
+		{
+			_openMemory(std::make_shared<AudioMemoryFile>(data, size));
+		}
+
+		AudioInfo::AudioInfo(const std::shared_ptr<const AudioMemoryFile>& memory)
+			: AudioInfo()
+		{
+			_openMemory(memory);
+		}
+
+		AudioInfo::AudioInfo(const AudioMetadata& metadata)
+			: AudioInfo(new SF_INFO(metadata.info))
+		{
+			_metadata = std::make_shared<const AudioMetadata>(metadata);
+		}
+
 		AudioInfo::~AudioInfo()
 		{
 			// NOTE: _sndInfo is deleted internally by libSNDFile
@@ -77,61 +105,62 @@ namespace AuroraFW {
 
 		const char* AudioInfo::getTitle() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_TITLE);
-			return string ? string : "null";
+			return _getString(SF_STR_TITLE);
 		}
 
 		const char* AudioInfo::getCopyright() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_COPYRIGHT);
-			return string ? string : "null";
+			return _getString(SF_STR_COPYRIGHT);
 		}
 
 		const char* AudioInfo::getSoftware() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_SOFTWARE);
-			return string ? string : "null";
+			return _getString(SF_STR_SOFTWARE);
 		}
 
 		const char* AudioInfo::getArtist() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_ARTIST);
-			return string ? string : "null";
+			return _getString(SF_STR_ARTIST);
 		}
 
 		const char* AudioInfo::getComment() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_COMMENT);
-			return string ? string : "null";
+			return _getString(SF_STR_COMMENT);
 		}
 
 		const char* AudioInfo::getDate() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_DATE);
-			return string ? string : "null";
+			return _getString(SF_STR_DATE);
 		}
 
 		const char* AudioInfo::getAlbum() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_ALBUM);
-			return string ? string : "null";
+			return _getString(SF_STR_ALBUM);
 		}
 
 		const char* AudioInfo::getLicense() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_LICENSE);
-			return string ? string : "null";
+			return _getString(SF_STR_LICENSE);
 		}
 
 		const char* AudioInfo::getTrackNumber() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_TRACKNUMBER);
-			return string ? string : "null";
+			return _getString(SF_STR_TRACKNUMBER);
 		}
 
 		const char* AudioInfo::getGenre() const
 		{
-			const char* string = sf_get_string(_sndFile, SF_STR_GENRE);
+			return _getString(SF_STR_GENRE);
+		}
+
+		const char* AudioInfo::_getString(int type) const
+		{
+			const char* string = AFW_NULLPTR;
+			if(_sndFile != AFW_NULLPTR)
+				string = sf_get_string(_sndFile, type);
+			else if(_metadata != AFW_NULLPTR)
+				string = _metadata->getString(type);
+
 			return string ? string : "null";
 		}
 
@@ -184,5 +213,485 @@ namespace AuroraFW {
 		{
 			sf_set_string(_sndFile, SF_STR_GENRE, genre);
 		}
+
+		void AudioInfo::setIOBufferSize(const int size)
+		{
+			_ioBufferSize = size;
+			_applyIOSettings();
+		}
+
+		int AudioInfo::getIOBufferSize() const
+		{
+			if(_sndFile == AFW_NULLPTR)
+				return _ioBufferSize;
+
+			return sf_command(_sndFile, SFC_GET_IO_BUFFER_SIZE, AFW_NULLPTR, 0);
+		}
+
+		SF_IO_STATS AudioInfo::getIOStats() const
+		{
+			SF_IO_STATS stats = SF_IO_STATS();
+			if(_sndFile != AFW_NULLPTR)
+				sf_command(_sndFile, SFC_GET_IO_STATS, &stats, sizeof(stats));
+
+			return stats;
+		}
+
+		void AudioInfo::setIOReadAhead(const int blocks)
+		{
+			_ioReadAhead = blocks;
+			_applyIOSettings();
+		}
+
+		int AudioInfo::getIOReadAhead() const
+		{
+			if(_sndFile == AFW_NULLPTR)
+				return _ioReadAhead;
+
+			return sf_command(_sndFile, SFC_GET_IO_READAHEAD, AFW_NULLPTR, 0);
+		}
+
+		sf_count_t AudioInfo::readPlanar(float* const* planes, sf_count_t frames)
+		{
+			if(_sndFile == AFW_NULLPTR)
+				return 0;
+
+			return sf_readf_float_planar(_sndFile, planes, frames);
+		}
+
+		sf_count_t AudioInfo::writePlanar(const float* const* planes, sf_count_t frames)
+		{
+			if(_sndFile == AFW_NULLPTR)
+				return 0;
+
+			return sf_writef_float_planar(_sndFile, planes, frames);
+		}
+
+		void AudioInfo::_applyIOSettings()
+		{
+			if(_sndFile == AFW_NULLPTR)
+				return;
+
+			// Until something is set, libsndfile's defaults are kept
+			if(_ioBufferSize >= 0)
+				sf_command(_sndFile, SFC_SET_IO_BUFFER_SIZE, AFW_NULLPTR, _ioBufferSize);
+			if(_ioReadAhead >= 0)
+				sf_command(_sndFile, SFC_SET_IO_READAHEAD, AFW_NULLPTR, _ioReadAhead);
+		}
+
+		bool AudioInfo::_openMemory(const std::shared_ptr<const AudioMemoryFile>& memory)
+		{
+			static SF_VIRTUAL_IO virtualIO = {_memoryGetFileLength, _memorySeek, _memoryRead,
+				_memoryWrite, _memoryTell};
+
+			if(memory == AFW_NULLPTR)
+				return false;
+
+			_memory = memory;
+			_memoryPosition = 0;
+			_sndFile = sf_open_virtual(&virtualIO, SFM_READ, _sndInfo, this);
+			if(_sndFile == AFW_NULLPTR) {
+				_memory.reset();
+				return false;
+			}
+
+			return true;
+		}
+
+		sf_count_t AudioInfo::_memoryGetFileLength(void* userData)
+		{
+			return static_cast<AudioInfo*>(userData)->_memory->getSize();
+		}
+
+		sf_count_t AudioInfo::_memorySeek(sf_count_t offset, int whence, void* userData)
+		{
+			AudioInfo* info = static_cast<AudioInfo*>(userData);
+
+			switch(whence) {
+				case SEEK_CUR:
+					offset += info->_memoryPosition;
+					break;
+				case SEEK_END:
+					offset += info->_memory->getSize();
+					break;
+				default:
+					break;
+			}
+
+			// Like a file, the cursor may go past the end but not before the start
+			if(offset < 0)
+				return -1;
+
+			info->_memoryPosition = offset;
+			return offset;
+		}
+
+		sf_count_t AudioInfo::_memoryRead(void* ptr, sf_count_t count, void* userData)
+		{
+			AudioInfo* info = static_cast<AudioInfo*>(userData);
+			const sf_count_t available = info->_memory->getSize() - info->_memoryPosition;
+
+			if(count > available)
+				count = available;
+			if(count <= 0)
+				return 0;
+
+			std::memcpy(ptr, info->_memory->getData() + info->_memoryPosition, (size_t)count);
+			info->_memoryPosition += count;
+			return count;
+		}
+
+		sf_count_t AudioInfo::_memoryWrite(const void* , sf_count_t , void* )
+		{
+			// The memory is read-only
+			return 0;
+		}
+
+		sf_count_t AudioInfo::_memoryTell(void* userData)
+		{
+			return static_cast<AudioInfo*>(userData)->_memoryPosition;
+		}
+
+		// AudioMemoryFile
+		AudioMemoryFile::AudioMemoryFile(const void* data, sf_count_t size)
+			: _data(static_cast<const unsigned char*>(data)), _size(data != AFW_NULLPTR && size > 0 ? size : 0)
+		{}
+
+		std::shared_ptr<AudioMemoryFile> AudioMemoryFile::map(const char* path, sf_count_t offset, sf_count_t length)
+		{
+			if(path == AFW_NULLPTR || offset < 0)
+				return AFW_NULLPTR;
+
+		#if defined(_WIN32)
+			HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if(fileHandle == INVALID_HANDLE_VALUE)
+				return AFW_NULLPTR;
+
+			LARGE_INTEGER fileSize;
+			if(!GetFileSizeEx(fileHandle, &fileSize)) {
+				CloseHandle(fileHandle);
+				return AFW_NULLPTR;
+			}
+
+			SYSTEM_INFO systemInfo;
+			GetSystemInfo(&systemInfo);
+			const sf_count_t granularity = systemInfo.dwAllocationGranularity;
+			const sf_count_t size = fileSize.QuadPart;
+		#else
+			int fileDescriptor = ::open(path, O_RDONLY);
+			if(fileDescriptor < 0)
+				return AFW_NULLPTR;
+
+			struct stat fileStat;
+			if(fstat(fileDescriptor, &fileStat) != 0) {
+				close(fileDescriptor);
+				return AFW_NULLPTR;
+			}
+
+			const sf_count_t granularity = sysconf(_SC_PAGESIZE);
+			const sf_count_t size = fileStat.st_size;
+		#endif
+
+			// Don't map beyond the end of the file
+			if(offset >= size)
+				length = 0;
+			else if(length < 0 || offset + length > size)
+				length = size - offset;
+
+			std::shared_ptr<AudioMemoryFile> memoryFile;
+			if(length > 0) {
+				memoryFile = std::shared_ptr<AudioMemoryFile>(AFW_NEW AudioMemoryFile());
+
+				// Mappings must start on an allocation boundary
+				const sf_count_t mappingOffset = offset - offset % granularity;
+				memoryFile->_mappingSize = (size_t)(offset - mappingOffset + length);
+
+		#if defined(_WIN32)
+				HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+				if(mappingHandle != NULL) {
+					memoryFile->_mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, (DWORD)(mappingOffset >> 32),
+						(DWORD)(mappingOffset & 0xFFFFFFFF), memoryFile->_mappingSize);
+					if(memoryFile->_mapping != NULL) {
+						memoryFile->_fileHandle = fileHandle;
+						memoryFile->_mappingHandle = mappingHandle;
+					} else {
+						memoryFile->_mapping = nullptr;
+						CloseHandle(mappingHandle);
+					}
+				}
+		#else
+				memoryFile->_mapping = mmap(nullptr, memoryFile->_mappingSize, PROT_READ, MAP_SHARED, fileDescriptor, mappingOffset);
+				if(memoryFile->_mapping != MAP_FAILED) {
+					// Audio data is mostly read sequentially
+					madvise(memoryFile->_mapping, memoryFile->_mappingSize, MADV_SEQUENTIAL);
+				} else {
+					memoryFile->_mapping = nullptr;
+				}
+		#endif
+
+				if(memoryFile->_mapping != nullptr) {
+					memoryFile->_data = static_cast<const unsigned char*>(memoryFile->_mapping) + (offset - mappingOffset);
+					memoryFile->_size = length;
+				} else {
+					memoryFile.reset();
+				}
+			}
+
+		#if defined(_WIN32)
+			if(memoryFile == AFW_NULLPTR)
+				CloseHandle(fileHandle);
+		#else
+			// The mapping keeps its own reference to the file
+			close(fileDescriptor);
+		#endif
+
+			return memoryFile;
+		}
+
+		AudioMemoryFile::~AudioMemoryFile()
+		{
+		#if defined(_WIN32)
+			if(_mapping != nullptr)
+				UnmapViewOfFile(_mapping);
+			if(_mappingHandle != nullptr)
+				CloseHandle(_mappingHandle);
+			if(_fileHandle != nullptr)
+				CloseHandle(_fileHandle);
+		#else
+			if(_mapping != nullptr)
+				munmap(_mapping, _mappingSize);
+		#endif
+		}
+
+		// AudioMappedFile
+		std::mutex AudioMappedFile::_filesMutex;
+		std::map<AudioMappedFile::Key, std::weak_ptr<AudioMappedFile>> AudioMappedFile::_files;
+
+		bool AudioMappedFile::Key::operator<(const Key& other) const
+		{
+			if(path != other.path)
+				return path < other.path;
+			if(modificationTime != other.modificationTime)
+				return modificationTime < other.modificationTime;
+			return fileSize < other.fileSize;
+		}
+
+		static inline uint16_t byteswap16(uint16_t value)
+		{
+			return (uint16_t)((value << 8) | (value >> 8));
+		}
+
+		static inline uint32_t byteswap32(uint32_t value)
+		{
+			return (value << 24) | ((value << 8) & 0x00FF0000) | ((value >> 8) & 0x0000FF00) | (value >> 24);
+		}
+
+		static inline uint64_t byteswap64(uint64_t value)
+		{
+			return ((uint64_t)byteswap32((uint32_t)value) << 32) | byteswap32((uint32_t)(value >> 32));
+		}
+
+		std::shared_ptr<AudioMappedFile> AudioMappedFile::_create(SNDFILE* sndFile, const SF_INFO* sndInfo, SF_RAW_DATA_INFO& rawInfo)
+		{
+			if(sndFile == AFW_NULLPTR || sndInfo == AFW_NULLPTR || sndInfo->channels <= 0)
+				return AFW_NULLPTR;
+
+			// Only uncompressed files expose their raw data, everything else must be decoded
+			if(sf_command(sndFile, SFC_GET_RAW_DATA_INFO, &rawInfo, sizeof(rawInfo)) != SF_TRUE)
+				return AFW_NULLPTR;
+
+			std::shared_ptr<AudioMappedFile> mappedFile(AFW_NEW AudioMappedFile());
+			mappedFile->_channels = sndInfo->channels;
+			mappedFile->_codec = sndInfo->format & SF_FORMAT_SUBMASK;
+			mappedFile->_byteWidth = rawInfo.bytewidth;
+			mappedFile->_endswap = rawInfo.endswap != 0;
+			mappedFile->_offset = rawInfo.offset;
+			mappedFile->_length = rawInfo.length;
+
+			const uint16_t probe = 1;
+			const bool cpuLittleEndian = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+			mappedFile->_littleEndian = cpuLittleEndian != mappedFile->_endswap;
+
+			return mappedFile;
+		}
+
+		std::shared_ptr<AudioMappedFile> AudioMappedFile::open(const char* path, SNDFILE* sndFile, const SF_INFO* sndInfo)
+		{
+			if(path == AFW_NULLPTR)
+				return AFW_NULLPTR;
+
+			SF_RAW_DATA_INFO rawInfo;
+			std::shared_ptr<AudioMappedFile> mappedFile = _create(sndFile, sndInfo, rawInfo);
+			if(mappedFile == AFW_NULLPTR)
+				return AFW_NULLPTR;
+
+			// A file rewritten since it was mapped is mapped again, so the
+			// streams still playing the old mapping keep it to themselves
+			struct stat fileStat;
+			if(stat(path, &fileStat) != 0)
+				return AFW_NULLPTR;
+
+			const Key key = {path, (long long)fileStat.st_mtime, (long long)fileStat.st_size};
+
+			std::lock_guard<std::mutex> lock(_filesMutex);
+
+			// The data must also sit at the same place with the same format, in
+			// case the file was rewritten within the same second at the same size
+			std::map<Key, std::weak_ptr<AudioMappedFile>>::iterator found = _files.find(key);
+			if(found != _files.end()) {
+				std::shared_ptr<AudioMappedFile> sharedFile = found->second.lock();
+				if(sharedFile != AFW_NULLPTR && sharedFile->_hasLayoutOf(*mappedFile))
+					return sharedFile;
+			}
+
+			if(!mappedFile->_use(AudioMemoryFile::map(path, rawInfo.offset, rawInfo.length), 0, rawInfo.length))
+				return AFW_NULLPTR;
+
+			// Forget the files whose mappings were already released
+			for(auto it = _files.begin(); it != _files.end();) {
+				if(it->second.expired())
+					it = _files.erase(it);
+				else
+					++it;
+			}
+
+			_files[key] = mappedFile;
+			return mappedFile;
+		}
+
+		std::shared_ptr<AudioMappedFile> AudioMappedFile::open(const std::shared_ptr<const AudioMemoryFile>& memory,
+			SNDFILE* sndFile, const SF_INFO* sndInfo)
+		{
+			if(memory == AFW_NULLPTR)
+				return AFW_NULLPTR;
+
+			SF_RAW_DATA_INFO rawInfo;
+			std::shared_ptr<AudioMappedFile> mappedFile = _create(sndFile, sndInfo, rawInfo);
+			if(mappedFile == AFW_NULLPTR || !mappedFile->_use(memory, rawInfo.offset, rawInfo.length))
+				return AFW_NULLPTR;
+
+			return mappedFile;
+		}
+
+		bool AudioMappedFile::_use(const std::shared_ptr<const AudioMemoryFile>& memory, sf_count_t offset, sf_count_t length)
+		{
+			if(memory == AFW_NULLPTR)
+				return false;
+
+			// Don't trust the header beyond the end of the data
+			const sf_count_t size = memory->getSize();
+			if(offset >= size)
+				length = 0;
+			else if(offset + length > size)
+				length = size - offset;
+
+			_frames = length / ((sf_count_t)_byteWidth * _channels);
+			if(_frames <= 0)
+				return false;
+
+			_memory = memory;
+			_data = memory->getData() + offset;
+			return true;
+		}
+
+		bool AudioMappedFile::_hasLayoutOf(const AudioMappedFile& other) const
+		{
+			return _offset == other._offset && _length == other._length
+				&& _channels == other._channels && _codec == other._codec
+				&& _byteWidth == other._byteWidth && _endswap == other._endswap;
+		}
+
+		AudioMappedFile::~AudioMappedFile()
+		{}
+
+		bool AudioMappedFile::isNativeFloat() const
+		{
+			return _codec == SF_FORMAT_FLOAT && !_endswap;
+		}
+
+		size_t AudioMappedFile::read(float* output, sf_count_t frame, size_t frames) const
+		{
+			if(frame < 0 || frame >= _frames)
+				return 0;
+
+			if((sf_count_t)frames > _frames - frame)
+				frames = (size_t)(_frames - frame);
+
+			const size_t samples = frames * _channels;
+			const unsigned char* input = _data + frame * _channels * _byteWidth;
+
+			switch(_codec) {
+				case SF_FORMAT_PCM_S8:
+					for(size_t i = 0; i < samples; i++)
+						output[i] = (signed char)input[i] / 128.0f;
+					break;
+
+				case SF_FORMAT_PCM_U8:
+					for(size_t i = 0; i < samples; i++)
+						output[i] = ((int)input[i] - 128) / 128.0f;
+					break;
+
+				case SF_FORMAT_PCM_16:
+					for(size_t i = 0; i < samples; i++) {
+						uint16_t value;
+						std::memcpy(&value, input + i * 2, 2);
+						if(_endswap)
+							value = byteswap16(value);
+						output[i] = (int16_t)value / 32768.0f;
+					}
+					break;
+
+				case SF_FORMAT_PCM_24:
+					for(size_t i = 0; i < samples; i++) {
+						const unsigned char* sample = input + i * 3;
+						uint32_t value = _littleEndian
+							? ((uint32_t)sample[0] << 8) | ((uint32_t)sample[1] << 16) | ((uint32_t)sample[2] << 24)
+							: ((uint32_t)sample[2] << 8) | ((uint32_t)sample[1] << 16) | ((uint32_t)sample[0] << 24);
+						output[i] = (int32_t)value / 2147483648.0f;
+					}
+					break;
+
+				case SF_FORMAT_PCM_32:
+					for(size_t i = 0; i < samples; i++) {
+						uint32_t value;
+						std::memcpy(&value, input + i * 4, 4);
+						if(_endswap)
+							value = byteswap32(value);
+						output[i] = (int32_t)value / 2147483648.0f;
+					}
+					break;
+
+				case SF_FORMAT_FLOAT:
+					if(!_endswap) {
+						std::memcpy(output, input, samples * sizeof(float));
+						break;
+					}
+					for(size_t i = 0; i < samples; i++) {
+						uint32_t value;
+						std::memcpy(&value, input + i * 4, 4);
+						value = byteswap32(value);
+						std::memcpy(output + i, &value, 4);
+					}
+					break;
+
+				case SF_FORMAT_DOUBLE:
+					for(size_t i = 0; i < samples; i++) {
+						uint64_t value;
+						std::memcpy(&value, input + i * 8, 8);
+						if(_endswap)
+							value = byteswap64(value);
+						double sample;
+						std::memcpy(&sample, &value, 8);
+						output[i] = (float)sample;
+					}
+					break;
+
+				default:
+					std::memset(output, 0, samples * sizeof(float));
+					break;
+			}
+
+			return frames;
+		}
 	}
 }
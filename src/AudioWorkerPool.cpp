@@ -0,0 +1,117 @@
+/****************************************************************************
+** ┌─┐┬ ┬┬─┐┌─┐┬─┐┌─┐  ┌─┐┬─┐┌─┐┌┬┐┌─┐┬ ┬┌─┐┬─┐┬┌─
+** ├─┤│ │├┬┘│ │├┬┘├─┤  ├┤ ├┬┘├─┤│││├┤ ││││ │├┬┘├┴┐
+** ┴ ┴└─┘┴└─└─┘┴└─┴ ┴  └  ┴└─┴ ┴┴ ┴└─┘└┴┘└─┘┴└─┴ ┴
+** A Powerful General Purpose Framework
+** More information in: https://aurora-fw.github.io/
+**
+** Copyright (C) 2017 Aurora Framework, All rights reserved.
+**
+** This file is part of the Aurora Framework. This framework is free
+** software; you can redistribute it and/or modify it under the terms of
+** the GNU Lesser General Public License version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+****************************************************************************/
+
+#include <AuroraFW/Audio/AudioWorkerPool.h>
+
+namespace AuroraFW {
+	namespace AudioManager {
+		AudioWorkerPool::AudioWorkerPool(unsigned int workers, unsigned int reserved)
+		{
+			if(workers == 0) {
+				const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+				workers = hardwareThreads > reserved ? hardwareThreads - reserved : 1;
+			}
+
+			for(unsigned int i = 0; i < workers; i++)
+				_workers.push_back(std::thread(&AudioWorkerPool::_workerLoop, this, i));
+		}
+
+		AudioWorkerPool::~AudioWorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_running = false;
+			}
+			_condition.notify_all();
+
+			for(std::thread& worker : _workers)
+				worker.join();
+		}
+
+		void AudioWorkerPool::push(Task task)
+		{
+			Job job;
+			job.task = std::move(task);
+			job.queuedAt = std::chrono::steady_clock::now();
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_jobs.push_back(std::move(job));
+			}
+			_condition.notify_one();
+		}
+
+		void AudioWorkerPool::push(std::vector<Task>& tasks)
+		{
+			const std::chrono::steady_clock::time_point queuedAt = std::chrono::steady_clock::now();
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				for(Task& task : tasks) {
+					Job job;
+					job.task = std::move(task);
+					job.queuedAt = queuedAt;
+					_jobs.push_back(std::move(job));
+				}
+			}
+			_condition.notify_all();
+			tasks.clear();
+		}
+
+		void AudioWorkerPool::wait()
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_idle.wait(lock, [this]{ return _jobs.empty() && _active == 0; });
+		}
+
+		size_t AudioWorkerPool::getNumPending() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _jobs.size() + _active;
+		}
+
+		double AudioWorkerPool::millisecondsBetween(std::chrono::steady_clock::time_point begin,
+			std::chrono::steady_clock::time_point end)
+		{
+			return std::chrono::duration<double, std::milli>(end - begin).count();
+		}
+
+		void AudioWorkerPool::_workerLoop(unsigned int worker)
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			while(true) {
+				_condition.wait(lock, [this]{ return !_running || !_jobs.empty(); });
+				if(!_running)
+					break;
+
+				Job job = std::move(_jobs.front());
+				_jobs.pop_front();
+				_active++;
+
+				// Runs without holding the lock, so other workers can pick up tasks
+				lock.unlock();
+				job.task(worker, millisecondsBetween(job.queuedAt, std::chrono::steady_clock::now()));
+				job.task = nullptr;
+				lock.lock();
+
+				_active--;
+				if(_jobs.empty() && _active == 0)
+					_idle.notify_all();
+			}
+		}
+	}
+}
@@ -81,6 +81,13 @@ void set_ag_params (AGParamRecPtr params, uint32_t m, uint32_t p, uint32_t k, ui
 
 
 // note: implementing this with some kind of "count leading zeros" assembly is a big performance win
+#if __GNUC__
+static inline int32_t ALWAYS_INLINE lead (int32_t m)
+{
+	// __builtin_clz () is undefined for zero
+	return m == 0 ? 32 : __builtin_clz ((uint32_t) m) ;
+}
+#else
 static inline int32_t lead (int32_t m)
 {
 	long j ;
@@ -94,6 +101,7 @@ static inline int32_t lead (int32_t m)
 	}
 	return j ;
 }
+#endif
 
 #define arithmin(a, b) ((a) < (b) ? (a) : (b))
 
@@ -109,11 +117,19 @@ static inline int32_t ALWAYS_INLINE lg3a (int32_t x)
 
 static inline uint32_t ALWAYS_INLINE read32bit (uint8_t * buffer)
 {
-	// embedded CPUs typically can't read unaligned 32-bit words so just read the bytes
 	uint32_t		value ;
 
+#if __GNUC__
+	// a memcpy () of a word is a single (unaligned) load and the swap a single instruction
+	memcpy (&value, buffer, sizeof (value)) ;
+#if ! TARGET_RT_BIG_ENDIAN
+	value = __builtin_bswap32 (value) ;
+#endif
+#else
+	// embedded CPUs typically can't read unaligned 32-bit words so just read the bytes
 	value = ((uint32_t) buffer [0] << 24) | ((uint32_t) buffer [1] << 16) |
 				((uint32_t) buffer [2] << 8) | (uint32_t) buffer [3] ;
+#endif
 	return value ;
 
 }
@@ -268,7 +284,7 @@ int32_t dyn_decomp (AGParamRecPtr params, BitBuffer * bitstream, int32_t * pc, i
 	uint8_t 		*in ;
 	int32_t			*outPtr = pc ;
 	uint32_t 	bitPos, startPos, maxPos ;
-	uint32_t		j, m, k, n, c, mz ;
+	uint32_t		m, k, n, c, mz ;
 	int32_t			del, zmode ;
 	uint32_t 	mb ;
 	uint32_t	pb_local = params->pb ;
@@ -334,11 +350,9 @@ int32_t dyn_decomp (AGParamRecPtr params, BitBuffer * bitstream, int32_t * pc, i
 
 			RequireAction (c+n <= (uint32_t) numSamples, status = kALAC_ParamError ; goto Exit ;) ;
 
-			for (j = 0 ; j < n ; j++)
-			{
-				*outPtr++ = 0 ;
-				++c ;
-			}
+			memset (outPtr, 0, n * sizeof (*outPtr)) ;
+			outPtr += n ;
+			c += n ;
 
 			if (n >= 65535)
 				zmode = 0 ;
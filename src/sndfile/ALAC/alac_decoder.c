@@ -161,7 +161,7 @@ alac_decode (ALAC_DECODER *p, struct BitBuffer * bits, int32_t * sampleBuffer, u
 	uint8_t			partialFrame ;
 	uint32_t		extraBits ;
 	int32_t			val ;
-	uint32_t		i, j ;
+	uint32_t		i ;
 	int32_t			status ;
 	uint32_t		numChannels = p->mNumChannels ;
 
@@ -308,8 +308,7 @@ alac_decode (ALAC_DECODER *p, struct BitBuffer * bits, int32_t * sampleBuffer, u
 				{
 					case 16:
 						out32 = sampleBuffer + channelIndex ;
-						for (i = 0, j = 0 ; i < numSamples ; i++, j += numChannels)
-							out32 [j] = arith_shift_left (p->mMixBufferU [i], 16) ;
+						copyPredictorTo16 (p->mMixBufferU, out32, numChannels, numSamples) ;
 						break ;
 					case 20:
 						out32 = sampleBuffer + channelIndex ;
@@ -27,6 +27,8 @@
 	Copyright:	(c) 2004-2011 Apple, Inc.
 */
 
+#include <stddef.h>
+
 #include "matrixlib.h"
 #include "ALACAudioTypes.h"
 #include "shift.h"
@@ -57,6 +59,221 @@
     R = L - v ;
 */
 
+/*
+	Vectorised unmix and predictor copy.
+
+	Every output routine below ends up computing ((x << shift) | low) << post
+	on the unmixed (or copied) predictor value x, where low comes from the
+	shift buffer. The kernels do exactly that four (SSE4.1) or eight (AVX2)
+	samples at a time for interleaved stereo and for mono, which is what
+	nearly all files are. The multiply and shifts wrap the same way as the
+	scalar code so the output is bit for bit the same. They return how many
+	samples they did and the scalar loops finish the rest ; other channel
+	layouts and other CPUs go through the scalar loops only.
+*/
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+#define	MATRIX_X86_SIMD	1
+#else
+#define	MATRIX_X86_SIMD	0
+#endif
+
+#if MATRIX_X86_SIMD
+
+#include <immintrin.h>
+
+#define	MATRIX_TARGET_SSE41		__attribute__ ((target ("sse4.1")))
+#define	MATRIX_TARGET_AVX2		__attribute__ ((target ("avx2")))
+
+enum
+{	MATRIX_SIMD_NONE = 0,
+	MATRIX_SIMD_SSE41,
+	MATRIX_SIMD_AVX2
+} ;
+
+static inline int
+matrix_simd_level (void)
+{	if (__builtin_cpu_supports ("avx2"))
+		return MATRIX_SIMD_AVX2 ;
+	if (__builtin_cpu_supports ("sse4.1"))
+		return MATRIX_SIMD_SSE41 ;
+	return MATRIX_SIMD_NONE ;
+} /* matrix_simd_level */
+
+static MATRIX_TARGET_SSE41 int32_t
+unmix_stereo_sse41 (const int32_t * u, const int32_t * v, int32_t * out, int32_t numSamples,
+				int32_t mixbits, int32_t mixres, const uint16_t * shiftUV, int32_t shift, int32_t post)
+{
+	__m128i		res = _mm_set1_epi32 (mixres) ;
+	__m128i		mbits = _mm_cvtsi32_si128 (mixbits) ;
+	__m128i		sbits = _mm_cvtsi32_si128 (shift) ;
+	__m128i		pbits = _mm_cvtsi32_si128 (post) ;
+	int32_t		j ;
+
+	for (j = 0 ; j + 4 <= numSamples ; j += 4)
+	{
+		__m128i		l, r, lo, hi ;
+
+		l = _mm_loadu_si128 ((const __m128i *) (u + j)) ;
+		r = _mm_loadu_si128 ((const __m128i *) (v + j)) ;
+
+		if (mixres != 0)
+		{
+			l = _mm_sub_epi32 (_mm_add_epi32 (l, r), _mm_sra_epi32 (_mm_mullo_epi32 (res, r), mbits)) ;
+			r = _mm_sub_epi32 (l, r) ;
+		}
+
+		lo = _mm_unpacklo_epi32 (l, r) ;
+		hi = _mm_unpackhi_epi32 (l, r) ;
+
+		if (shiftUV != NULL)
+		{
+			__m128i		low = _mm_loadu_si128 ((const __m128i *) (shiftUV + 2 * j)) ;
+
+			lo = _mm_or_si128 (_mm_sll_epi32 (lo, sbits), _mm_cvtepu16_epi32 (low)) ;
+			hi = _mm_or_si128 (_mm_sll_epi32 (hi, sbits), _mm_cvtepu16_epi32 (_mm_srli_si128 (low, 8))) ;
+		}
+
+		_mm_storeu_si128 ((__m128i *) (out + 2 * j), _mm_sll_epi32 (lo, pbits)) ;
+		_mm_storeu_si128 ((__m128i *) (out + 2 * j + 4), _mm_sll_epi32 (hi, pbits)) ;
+	}
+
+	return j ;
+}
+
+static MATRIX_TARGET_AVX2 int32_t
+unmix_stereo_avx2 (const int32_t * u, const int32_t * v, int32_t * out, int32_t numSamples,
+				int32_t mixbits, int32_t mixres, const uint16_t * shiftUV, int32_t shift, int32_t post)
+{
+	__m256i		res = _mm256_set1_epi32 (mixres) ;
+	__m128i		mbits = _mm_cvtsi32_si128 (mixbits) ;
+	__m128i		sbits = _mm_cvtsi32_si128 (shift) ;
+	__m128i		pbits = _mm_cvtsi32_si128 (post) ;
+	int32_t		j ;
+
+	for (j = 0 ; j + 8 <= numSamples ; j += 8)
+	{
+		__m256i		l, r, lo, hi, first, second ;
+
+		l = _mm256_loadu_si256 ((const __m256i *) (u + j)) ;
+		r = _mm256_loadu_si256 ((const __m256i *) (v + j)) ;
+
+		if (mixres != 0)
+		{
+			l = _mm256_sub_epi32 (_mm256_add_epi32 (l, r), _mm256_sra_epi32 (_mm256_mullo_epi32 (res, r), mbits)) ;
+			r = _mm256_sub_epi32 (l, r) ;
+		}
+
+		// the unpacks work within each 128-bit lane so put the lanes back in order
+		lo = _mm256_unpacklo_epi32 (l, r) ;
+		hi = _mm256_unpackhi_epi32 (l, r) ;
+		first = _mm256_permute2x128_si256 (lo, hi, 0x20) ;
+		second = _mm256_permute2x128_si256 (lo, hi, 0x31) ;
+
+		if (shiftUV != NULL)
+		{
+			const __m128i *	low = (const __m128i *) (shiftUV + 2 * j) ;
+
+			first = _mm256_or_si256 (_mm256_sll_epi32 (first, sbits), _mm256_cvtepu16_epi32 (_mm_loadu_si128 (low))) ;
+			second = _mm256_or_si256 (_mm256_sll_epi32 (second, sbits), _mm256_cvtepu16_epi32 (_mm_loadu_si128 (low + 1))) ;
+		}
+
+		_mm256_storeu_si256 ((__m256i *) (out + 2 * j), _mm256_sll_epi32 (first, pbits)) ;
+		_mm256_storeu_si256 ((__m256i *) (out + 2 * j + 8), _mm256_sll_epi32 (second, pbits)) ;
+	}
+
+	return j ;
+}
+
+static MATRIX_TARGET_SSE41 int32_t
+copy_mono_sse41 (const int32_t * in, const uint16_t * shiftBuf, int32_t * out, int32_t numSamples, int32_t shift, int32_t post)
+{
+	__m128i		sbits = _mm_cvtsi32_si128 (shift) ;
+	__m128i		pbits = _mm_cvtsi32_si128 (post) ;
+	int32_t		j ;
+
+	for (j = 0 ; j + 4 <= numSamples ; j += 4)
+	{
+		__m128i		val = _mm_loadu_si128 ((const __m128i *) (in + j)) ;
+
+		if (shiftBuf != NULL)
+			val = _mm_or_si128 (_mm_sll_epi32 (val, sbits), _mm_cvtepu16_epi32 (_mm_loadl_epi64 ((const __m128i *) (shiftBuf + j)))) ;
+
+		_mm_storeu_si128 ((__m128i *) (out + j), _mm_sll_epi32 (val, pbits)) ;
+	}
+
+	return j ;
+}
+
+static MATRIX_TARGET_AVX2 int32_t
+copy_mono_avx2 (const int32_t * in, const uint16_t * shiftBuf, int32_t * out, int32_t numSamples, int32_t shift, int32_t post)
+{
+	__m128i		sbits = _mm_cvtsi32_si128 (shift) ;
+	__m128i		pbits = _mm_cvtsi32_si128 (post) ;
+	int32_t		j ;
+
+	for (j = 0 ; j + 8 <= numSamples ; j += 8)
+	{
+		__m256i		val = _mm256_loadu_si256 ((const __m256i *) (in + j)) ;
+
+		if (shiftBuf != NULL)
+			val = _mm256_or_si256 (_mm256_sll_epi32 (val, sbits), _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i *) (shiftBuf + j)))) ;
+
+		_mm256_storeu_si256 ((__m256i *) (out + j), _mm256_sll_epi32 (val, pbits)) ;
+	}
+
+	return j ;
+}
+
+#endif
+
+static inline int32_t
+unmix_stereo (const int32_t * u, const int32_t * v, int32_t * out, uint32_t stride, int32_t numSamples,
+				int32_t mixbits, int32_t mixres, const uint16_t * shiftUV, int32_t shift, int32_t post)
+{
+#if MATRIX_X86_SIMD
+	if (stride == 2)
+	{
+		switch (matrix_simd_level ())
+		{
+			case MATRIX_SIMD_AVX2 :
+				return unmix_stereo_avx2 (u, v, out, numSamples, mixbits, mixres, shiftUV, shift, post) ;
+			case MATRIX_SIMD_SSE41 :
+				return unmix_stereo_sse41 (u, v, out, numSamples, mixbits, mixres, shiftUV, shift, post) ;
+			default :
+				break ;
+		}
+	}
+#else
+	(void) u ; (void) v ; (void) out ; (void) stride ; (void) numSamples ;
+	(void) mixbits ; (void) mixres ; (void) shiftUV ; (void) shift ; (void) post ;
+#endif
+	return 0 ;
+}
+
+static inline int32_t
+copy_mono (const int32_t * in, const uint16_t * shiftBuf, int32_t * out, uint32_t stride, int32_t numSamples, int32_t shift, int32_t post)
+{
+#if MATRIX_X86_SIMD
+	if (stride == 1)
+	{
+		switch (matrix_simd_level ())
+		{
+			case MATRIX_SIMD_AVX2 :
+				return copy_mono_avx2 (in, shiftBuf, out, numSamples, shift, post) ;
+			case MATRIX_SIMD_SSE41 :
+				return copy_mono_sse41 (in, shiftBuf, out, numSamples, shift, post) ;
+			default :
+				break ;
+		}
+	}
+#else
+	(void) in ; (void) shiftBuf ; (void) out ; (void) stride ;
+	(void) numSamples ; (void) shift ; (void) post ;
+#endif
+	return 0 ;
+}
+
 // 16-bit routines
 
 void
@@ -64,10 +281,13 @@ unmix16 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 {
 	int32_t 	j ;
 
+	j = unmix_stereo (u, v, out, stride, numSamples, mixbits, mixres, NULL, 0, 16) ;
+	out += j * stride ;
+
 	if (mixres != 0)
 	{
 		/* matrixed stereo */
-		for (j = 0 ; j < numSamples ; j++)
+		for ( ; j < numSamples ; j++)
 		{
 			int32_t		l, r ;
 
@@ -82,7 +302,7 @@ unmix16 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 	else
 	{
 		/* Conventional separated stereo. */
-		for (j = 0 ; j < numSamples ; j++)
+		for ( ; j < numSamples ; j++)
 		{
 			out [0] = u [j] << 16 ;
 			out [1] = v [j] << 16 ;
@@ -99,10 +319,13 @@ unmix20 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 {
 	int32_t 	j ;
 
+	j = unmix_stereo (u, v, out, stride, numSamples, mixbits, mixres, NULL, 0, 12) ;
+	out += j * stride ;
+
 	if (mixres != 0)
 	{
 		/* matrixed stereo */
-		for (j = 0 ; j < numSamples ; j++)
+		for ( ; j < numSamples ; j++)
 		{
 			int32_t		l, r ;
 
@@ -117,7 +340,7 @@ unmix20 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 	else
 	{
 		/* Conventional separated stereo. */
-		for (j = 0 ; j < numSamples ; j++)
+		for ( ; j < numSamples ; j++)
 		{
 			out [0] = arith_shift_left (u [j], 12) ;
 			out [1] = arith_shift_left (v [j], 12) ;
@@ -137,12 +360,16 @@ unmix24 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 	int32_t		l, r ;
 	int32_t 		j, k ;
 
+	j = unmix_stereo (u, v, out, stride, numSamples, mixbits, mixres, bytesShifted != 0 ? shiftUV : NULL, shift, 8) ;
+	k = 2 * j ;
+	out += j * stride ;
+
 	if (mixres != 0)
 	{
 		/* matrixed stereo */
 		if (bytesShifted != 0)
 		{
-			for (j = 0, k = 0 ; j < numSamples ; j++, k += 2)
+			for ( ; j < numSamples ; j++, k += 2)
 			{
 				l = u [j] + v [j] - ((mixres * v [j]) >> mixbits) ;
 				r = l - v [j] ;
@@ -157,7 +384,7 @@ unmix24 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 		}
 		else
 		{
-			for (j = 0 ; j < numSamples ; j++)
+			for ( ; j < numSamples ; j++)
 			{
 				l = u [j] + v [j] - ((mixres * v [j]) >> mixbits) ;
 				r = l - v [j] ;
@@ -173,7 +400,7 @@ unmix24 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 		/* Conventional separated stereo. */
 		if (bytesShifted != 0)
 		{
-			for (j = 0, k = 0 ; j < numSamples ; j++, k += 2)
+			for ( ; j < numSamples ; j++, k += 2)
 			{
 				l = u [j] ;
 				r = v [j] ;
@@ -188,7 +415,7 @@ unmix24 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 		}
 		else
 		{
-			for (j = 0 ; j < numSamples ; j++)
+			for ( ; j < numSamples ; j++)
 			{
 				out [0] = u [j] << 8 ;
 				out [1] = v [j] << 8 ;
@@ -211,12 +438,16 @@ unmix32 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 	int32_t		l, r ;
 	int32_t 	j, k ;
 
+	j = unmix_stereo (u, v, out, stride, numSamples, mixbits, mixres, bytesShifted != 0 ? shiftUV : NULL, shift, 0) ;
+	k = 2 * j ;
+	out += j * stride ;
+
 	if (mixres != 0)
 	{
 		//Assert (bytesShifted != 0) ;
 
 		/* matrixed stereo with shift */
-		for (j = 0, k = 0 ; j < numSamples ; j++, k += 2)
+		for ( ; j < numSamples ; j++, k += 2)
 		{
 			int32_t		lt, rt ;
 
@@ -236,7 +467,7 @@ unmix32 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 		if (bytesShifted == 0)
 		{
 			/* interleaving w/o shift */
-			for (j = 0 ; j < numSamples ; j++)
+			for ( ; j < numSamples ; j++)
 			{
 				out [0] = u [j] ;
 				out [1] = v [j] ;
@@ -246,7 +477,7 @@ unmix32 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 		else
 		{
 			/* interleaving with shift */
-			for (j = 0, k = 0 ; j < numSamples ; j++, k += 2)
+			for ( ; j < numSamples ; j++, k += 2)
 			{
 				out [0] = (u [j] << shift) | (uint32_t) shiftUV [k + 0] ;
 				out [1] = (v [j] << shift) | (uint32_t) shiftUV [k + 1] ;
@@ -258,12 +489,30 @@ unmix32 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, int32_t
 
 // 20/24-bit <-> 32-bit helper routines (not really matrixing but convenient to put here)
 
+void
+copyPredictorTo16 (const int32_t * in, int32_t * out, uint32_t stride, int32_t numSamples)
+{
+	int32_t		j ;
+
+	j = copy_mono (in, NULL, out, stride, numSamples, 0, 16) ;
+	out += j * stride ;
+
+	for ( ; j < numSamples ; j++)
+	{
+		out [0] = arith_shift_left (in [j], 16) ;
+		out += stride ;
+	}
+}
+
 void
 copyPredictorTo24 (const int32_t * in, int32_t * out, uint32_t stride, int32_t numSamples)
 {
 	int32_t		j ;
 
-	for (j = 0 ; j < numSamples ; j++)
+	j = copy_mono (in, NULL, out, stride, numSamples, 0, 8) ;
+	out += j * stride ;
+
+	for ( ; j < numSamples ; j++)
 	{
 		out [0] = in [j] << 8 ;
 		out += stride ;
@@ -278,7 +527,10 @@ copyPredictorTo24Shift (const int32_t * in, uint16_t * shift, int32_t * out, uin
 
 	//Assert (bytesShifted != 0) ;
 
-	for (j = 0 ; j < numSamples ; j++)
+	j = copy_mono (in, shift, out, stride, numSamples, shiftVal, 8) ;
+	out += j * stride ;
+
+	for ( ; j < numSamples ; j++)
 	{
 		int32_t		val = in [j] ;
 
@@ -295,7 +547,10 @@ copyPredictorTo20 (const int32_t * in, int32_t * out, uint32_t stride, int32_t n
 
 	// 32-bit predictor values are right-aligned but 20-bit output values should be left-aligned
 	// in the 24-bit output buffer
-	for (j = 0 ; j < numSamples ; j++)
+	j = copy_mono (in, NULL, out, stride, numSamples, 0, 12) ;
+	out += j * stride ;
+
+	for ( ; j < numSamples ; j++)
 	{
 		out [0] = arith_shift_left (in [j], 12) ;
 		out += stride ;
@@ -308,7 +563,9 @@ copyPredictorTo32 (const int32_t * in, int32_t * out, uint32_t stride, int32_t n
 	int32_t			i, j ;
 
 	// this is only a subroutine to abstract the "iPod can only output 16-bit data" problem
-	for (i = 0, j = 0 ; i < numSamples ; i++, j += stride)
+	i = copy_mono (in, NULL, out, stride, numSamples, 0, 8) ;
+
+	for (j = i * stride ; i < numSamples ; i++, j += stride)
 		out [j] = arith_shift_left (in [i], 8) ;
 }
 
@@ -322,7 +579,10 @@ copyPredictorTo32Shift (const int32_t * in, uint16_t * shift, int32_t * out, uin
 	//Assert (bytesShifted != 0) ;
 
 	// this is only a subroutine to abstract the "iPod can only output 16-bit data" problem
-	for (j = 0 ; j < numSamples ; j++)
+	j = copy_mono (in, shift, out, stride, numSamples, shiftVal, 0) ;
+	op += j * stride ;
+
+	for ( ; j < numSamples ; j++)
 	{
 		op [0] = arith_shift_left (in [j], shiftVal) | (uint32_t) shift [j] ;
 		op += stride ;
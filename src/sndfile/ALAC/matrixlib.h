@@ -67,6 +67,7 @@ void	unmix32 (const int32_t * u, int32_t * v, int32_t * out, uint32_t stride, in
 void	copy20ToPredictor (const int32_t * in, uint32_t stride, int32_t * out, int32_t numSamples) ;
 void	copy24ToPredictor (const int32_t * in, uint32_t stride, int32_t * out, int32_t numSamples) ;
 
+void	copyPredictorTo16 (const int32_t * in, int32_t * out, uint32_t stride, int32_t numSamples) ;
 void	copyPredictorTo24 (const int32_t * in, int32_t * out, uint32_t stride, int32_t numSamples) ;
 void	copyPredictorTo24Shift (const int32_t * in, uint16_t * shift, int32_t * out, uint32_t stride, int32_t numSamples, int32_t bytesShifted) ;
 void	copyPredictorTo20 (const int32_t * in, int32_t * out, uint32_t stride, int32_t numSamples) ;
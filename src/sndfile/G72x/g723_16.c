@@ -72,6 +72,8 @@ static short _fitab [4] = { 0, 0xE00, 0xE00, 0 } ;
  */
 static short qtab_723_16 [1] = { 261 } ;
 
+const G72x_TABLES g723_16_tables = { _dqlntab, _witab, _fitab, 0, 0x3FFF } ;
+
 
 /*
  * g723_16_encoder ()
@@ -59,6 +59,8 @@ static short _fitab [8] = { 0, 0x200, 0x400, 0xE00, 0xE00, 0x400, 0x200, 0 } ;
 
 static short qtab_723_24 [3] = { 8, 218, 331 } ;
 
+const G72x_TABLES g723_24_tables = { _dqlntab, _witab, _fitab, 0, 0x3FFF } ;
+
 /*
  * g723_24_encoder ()
  *
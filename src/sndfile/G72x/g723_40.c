@@ -77,6 +77,8 @@ static short	_fitab [32] = { 0, 0, 0, 0, 0, 0x200, 0x200, 0x200,
 static short qtab_723_40 [15] = { -122, -16, 68, 139, 198, 250, 298, 339,
 				378, 413, 445, 475, 502, 528, 553 } ;
 
+const G72x_TABLES g723_40_tables = { _dqlntab, _witab, _fitab, 0, 0x7FFF } ;
+
 /*
  * g723_40_encoder ()
  *
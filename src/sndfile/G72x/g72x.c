@@ -40,12 +40,7 @@
 static G72x_STATE * g72x_state_new (void) ;
 static int unpack_bytes (int bits, int blocksize, const unsigned char * block, short * samples) ;
 static int pack_bytes (int bits, const short * samples, unsigned char * block) ;
-
-static
-short power2 [15] =
-{	1, 2, 4, 8, 0x10, 0x20, 0x40, 0x80,
-	0x100, 0x200, 0x400, 0x800, 0x1000, 0x2000, 0x4000
-} ;
+static void decode_block (G72x_STATE *pstate, short *codes, int count, float *fsamples, float normfact) ;
 
 /*
  * quan ()
@@ -66,21 +61,48 @@ int quan (int val, short *table, int size)
 	return i ;
 }
 
+/*
+ * quan_power2 ()
+ *
+ * Same result as quan (val, power2, 15) for the table of powers of two
+ * 1, 2, 4 ... 0x4000, i.e. the number of bits needed to hold val, limited
+ * to 15. This is the base 2 log used throughout the codec, so it is worked
+ * out from the position of the top set bit instead of a linear search.
+ */
+static inline int ALWAYS_INLINE
+quan_power2 (int val)
+{
+	if (val <= 0)
+		return 0 ;
+	if (val >= 0x4000)
+		return 15 ;
+#if __GNUC__
+	return (int) (8 * sizeof (unsigned int)) - __builtin_clz ((unsigned int) val) ;
+#else
+	{	int i = 1 ;
+
+		while (val >>= 1)
+			i++ ;
+		return i ;
+		}
+#endif
+}
+
 /*
  * fmult ()
  *
  * returns the integer product of the 14-bit integer "an" and
  * "floating point" representation (4-bit exponent, 6-bit mantessa) "srn".
  */
-static
-int fmult (int an, int srn)
+static inline int ALWAYS_INLINE
+fmult (int an, int srn)
 {
 	short		anmag, anexp, anmant ;
 	short		wanexp, wanmant ;
 	short		retval ;
 
 	anmag = (an > 0) ? an : ((-an) & 0x1FFF) ;
-	anexp = quan (anmag, power2, 15) - 6 ;
+	anexp = quan_power2 (anmag) - 6 ;
 	anmant = (anmag == 0) ? 32 :
 				(anexp >= 0) ? anmag >> anexp : anmag << -anexp ;
 	wanexp = anexp + ((srn >> 6) & 0xF) - 13 ;
@@ -241,16 +263,26 @@ struct g72x_state * g72x_writer_init (int codec, int *blocksize, int *samplesper
 }	/* g72x_writer_init */
 
 int g72x_decode_block (G72x_STATE *pstate, const unsigned char *block, short *samples)
-{	int	k, count ;
+{	int	count ;
 
 	count = unpack_bytes (pstate->codec_bits, pstate->blocksize, block, samples) ;
 
-	for (k = 0 ; k < count ; k++)
-		samples [k] = pstate->decoder (samples [k], pstate) ;
+	decode_block (pstate, samples, count, NULL, 0.0f) ;
 
 	return 0 ;
 }	/* g72x_decode_block */
 
+int g72x_decode_block_float (G72x_STATE *pstate, const unsigned char *block, float *samples, float normfact)
+{	short	codes [G72x_BLOCK_SIZE] ;
+	int		count ;
+
+	count = unpack_bytes (pstate->codec_bits, pstate->blocksize, block, codes) ;
+
+	decode_block (pstate, codes, count, samples, normfact) ;
+
+	return count ;
+}	/* g72x_decode_block_float */
+
 int g72x_encode_block (G72x_STATE *pstate, short *samples, unsigned char *block)
 {	int k, count ;
 
@@ -268,7 +300,8 @@ int g72x_encode_block (G72x_STATE *pstate, short *samples, unsigned char *block)
  * computes the estimated signal from 6-zero predictor.
  *
  */
-int predictor_zero (G72x_STATE *state_ptr)
+static inline int ALWAYS_INLINE
+inline_predictor_zero (G72x_STATE *state_ptr)
 {
 	int		i ;
 	int		sezi ;
@@ -284,7 +317,8 @@ int predictor_zero (G72x_STATE *state_ptr)
  * computes the estimated signal from 2-pole predictor.
  *
  */
-int predictor_pole (G72x_STATE *state_ptr)
+static inline int ALWAYS_INLINE
+inline_predictor_pole (G72x_STATE *state_ptr)
 {
 	return (fmult (state_ptr->a [1] >> 2, state_ptr->sr [1]) +
 			fmult (state_ptr->a [0] >> 2, state_ptr->sr [0])) ;
@@ -295,7 +329,8 @@ int predictor_pole (G72x_STATE *state_ptr)
  * computes the quantization step size of the adaptive quantizer.
  *
  */
-int step_size (G72x_STATE *state_ptr)
+static inline int ALWAYS_INLINE
+inline_step_size (G72x_STATE *state_ptr)
 {
 	int		y ;
 	int		dif ;
@@ -343,7 +378,7 @@ int quantize (
 	 * Compute base 2 log of 'd', and store in 'dl'.
 	 */
 	dqm = abs (d) ;
-	expon = quan (dqm >> 1, power2, 15) ;
+	expon = quan_power2 (dqm >> 1) ;
 	mant = ((dqm << 7) >> expon) & 0x7F ;	/* Fractional portion. */
 	dl = (expon << 7) + mant ;
 
@@ -374,8 +409,8 @@ int quantize (
  * codeword 'i' and quantization step size scale factor 'y'.
  * Multiplication is performed in log base 2 domain as addition.
  */
-int
-reconstruct (
+static inline int ALWAYS_INLINE
+inline_reconstruct (
 	int		sign,	/* 0 for non-negative value */
 	int		dqln,	/* G.72x codeword */
 	int		y)	/* Step size multiplier */
@@ -403,8 +438,8 @@ reconstruct (
  *
  * updates the state variables for each output code
  */
-void
-update (
+static inline void ALWAYS_INLINE
+inline_update (
 	int		code_size,	/* distinguish 723_40 with others */
 	int		y,		/* quantizer step size */
 	int		wi,		/* scale factor multiplier */
@@ -414,7 +449,7 @@ update (
 	int		dqsez,		/* difference from 2-pole predictor */
 	G72x_STATE *state_ptr)	/* coder state pointer */
 {
-	int		cnt ;
+	int		cnt, bshift ;
 	short		mag, expon ;	/* Adaptive predictor, FLOAT A */
 	short		a2p = 0 ;	/* LIMC */
 	short		a1ul ;		/* UPA1 */
@@ -524,12 +559,10 @@ update (
 			state_ptr->a [0] = a1ul ;
 
 		/* UPB : update predictor zeros b [6] */
+		bshift = (code_size == 5) ? 9 : 8 ;	/* 40Kbps G.723 : 9, others : 8 */
 		for (cnt = 0 ; cnt < 6 ; cnt++)
-		{	if (code_size == 5)		/* for 40Kbps G.723 */
-				state_ptr->b [cnt] -= state_ptr->b [cnt] >> 9 ;
-			else			/* for G.721 and 24Kbps G.723 */
-				state_ptr->b [cnt] -= state_ptr->b [cnt] >> 8 ;
-			if (dq & 0x7FFF)			/* XOR */
+		{	state_ptr->b [cnt] -= state_ptr->b [cnt] >> bshift ;
+			if (mag)			/* XOR */
 			{	if ((dq ^ state_ptr->dq [cnt]) >= 0)
 					state_ptr->b [cnt] += 128 ;
 				else
@@ -544,7 +577,7 @@ update (
 	if (mag == 0)
 		state_ptr->dq [0] = (dq >= 0) ? 0x20 : 0xFC20 ;
 	else
-	{	expon = quan (mag, power2, 15) ;
+	{	expon = quan_power2 (mag) ;
 		state_ptr->dq [0] = (dq >= 0) ?
 			(expon << 6) + ((mag << 6) >> expon) :
 			(expon << 6) + ((mag << 6) >> expon) - 0x400 ;
@@ -555,12 +588,12 @@ update (
 	if (sr == 0)
 		state_ptr->sr [0] = 0x20 ;
 	else if (sr > 0)
-	{	expon = quan (sr, power2, 15) ;
+	{	expon = quan_power2 (sr) ;
 		state_ptr->sr [0] = (expon << 6) + ((sr << 6) >> expon) ;
 		}
 	else if (sr > -32768)
 	{	mag = -sr ;
-		expon = quan (mag, power2, 15) ;
+		expon = quan_power2 (mag) ;
 		state_ptr->sr [0] = (expon << 6) + ((mag << 6) >> expon) - 0x400 ;
 		}
 	else
@@ -596,7 +629,124 @@ update (
 		state_ptr->ap += (-state_ptr->ap) >> 4 ;
 
 	return ;
-} /* update */
+} /* inline_update */
+
+/*
+ * The out of line versions of the above, as used by the per sample
+ * encoders and decoders in g721.c and g723_*.c.
+ */
+int
+predictor_zero (G72x_STATE *state_ptr)
+{	return inline_predictor_zero (state_ptr) ;
+}
+
+int
+predictor_pole (G72x_STATE *state_ptr)
+{	return inline_predictor_pole (state_ptr) ;
+}
+
+int
+step_size (G72x_STATE *state_ptr)
+{	return inline_step_size (state_ptr) ;
+}
+
+int
+reconstruct (int sign, int dqln, int y)
+{	return inline_reconstruct (sign, dqln, y) ;
+}
+
+void
+update (int code_size, int y, int wi, int fi, int dq, int sr, int dqsez, G72x_STATE *state_ptr)
+{	inline_update (code_size, y, wi, fi, dq, sr, dqsez, state_ptr) ;
+}
+
+/*
+ * decode_sample ()
+ *
+ * The body shared by g721_decoder () and the g723_*_decoder () functions,
+ * with the code word tables passed in. When inlined with a constant 'bits'
+ * the whole sample update compiles down to straight line code.
+ */
+static inline short ALWAYS_INLINE
+decode_sample (G72x_STATE *state_ptr, const G72x_TABLES *tables, int bits, int i)
+{
+	short		sezi, sei, sez, se ;	/* ACCUM */
+	short		y ;			/* MIX */
+	short		sr ;			/* ADDB */
+	short		dq ;
+	short		dqsez ;
+
+	sezi = inline_predictor_zero (state_ptr) ;
+	sez = sezi >> 1 ;
+	sei = sezi + inline_predictor_pole (state_ptr) ;
+	se = sei >> 1 ;			/* se = estimated signal */
+
+	y = inline_step_size (state_ptr) ;	/* adaptive quantizer step size */
+	dq = inline_reconstruct (i & (1 << (bits - 1)), tables->dqlntab [i], y) ;
+
+	sr = (dq < 0) ? (se - (dq & tables->dq_mask)) : (se + dq) ;	/* reconst. signal */
+
+	dqsez = sr - se + sez ;			/* pole prediction diff. */
+
+	inline_update (bits, y, arith_shift_left (tables->witab [i], tables->wi_shift),
+				tables->fitab [i], dq, sr, dqsez, state_ptr) ;
+
+	/* sr was of 14-bit dynamic range */
+	return arith_shift_left (sr, 2) ;
+}
+
+static inline void ALWAYS_INLINE
+decode_codes (G72x_STATE *pstate, const G72x_TABLES *tables, int bits, short *codes, int count, float *fsamples, float normfact)
+{	int		k ;
+
+	if (fsamples == NULL)
+	{	for (k = 0 ; k < count ; k++)
+			codes [k] = decode_sample (pstate, tables, bits, codes [k]) ;
+		return ;
+		} ;
+
+	for (k = 0 ; k < count ; k++)
+		fsamples [k] = normfact * decode_sample (pstate, tables, bits, codes [k]) ;
+}
+
+/*
+ * decode_block ()
+ *
+ * Decodes 'count' unpacked code words, either in place into 'codes' or,
+ * if 'fsamples' is not NULL, straight into scaled floats. Each codec gets
+ * its own copy of the decoding loop with its tables and code size fixed.
+ */
+static void
+decode_block (G72x_STATE *pstate, short *codes, int count, float *fsamples, float normfact)
+{	int		k ;
+
+	switch (pstate->codec_bits)
+	{	case G723_16_BITS_PER_SAMPLE :
+				decode_codes (pstate, &g723_16_tables, 2, codes, count, fsamples, normfact) ;
+				return ;
+
+		case G723_24_BITS_PER_SAMPLE :
+				decode_codes (pstate, &g723_24_tables, 3, codes, count, fsamples, normfact) ;
+				return ;
+
+		case G721_32_BITS_PER_SAMPLE :
+				decode_codes (pstate, &g721_tables, 4, codes, count, fsamples, normfact) ;
+				return ;
+
+		case G721_40_BITS_PER_SAMPLE :
+				decode_codes (pstate, &g723_40_tables, 5, codes, count, fsamples, normfact) ;
+				return ;
+
+		default :
+				break ;
+		} ;
+
+	for (k = 0 ; k < count ; k++)
+	{	codes [k] = pstate->decoder (codes [k], pstate) ;
+		if (fsamples != NULL)
+			fsamples [k] = normfact * codes [k] ;
+		} ;
+} /* decode_block */
 
 /*------------------------------------------------------------------------------
 */
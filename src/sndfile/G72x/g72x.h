@@ -80,6 +80,13 @@ int g72x_decode_block (struct g72x_state *pstate, const unsigned char *block, sh
 **	When it returns, the caller can read out data->samples samples.
 */
 
+int g72x_decode_block_float (struct g72x_state *pstate, const unsigned char *block, float *samples, float normfact) ;
+/*
+**	Same as g72x_decode_block () but writes each decoded sample multiplied by
+**	normfact straight to samples, which must hold G72x_BLOCK_SIZE floats.
+**	Returns the number of samples decoded.
+*/
+
 int g72x_encode_block (struct g72x_state *pstate, short *samples, unsigned char *block) ;
 /*
 **	The caller fills state->samples some integer multiple data->samples_per_block
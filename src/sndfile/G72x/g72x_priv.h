@@ -80,6 +80,26 @@ struct g72x_state
 
 typedef struct g72x_state G72x_STATE ;
 
+/*
+** The code word lookup tables of one codec, used by the block decoder to run
+** the decoding loop of every codec without going through state->decoder.
+** Only G.721 scales its witab entries ; for the others wi_shift is zero.
+** G.723 40kbps keeps one more bit of dq when reconstructing the signal.
+*/
+
+typedef struct
+{	const short	*dqlntab ;
+	const short	*witab ;
+	const short	*fitab ;
+	int			wi_shift ;
+	int			dq_mask ;
+} G72x_TABLES ;
+
+extern const G72x_TABLES g721_tables ;
+extern const G72x_TABLES g723_16_tables ;
+extern const G72x_TABLES g723_24_tables ;
+extern const G72x_TABLES g723_40_tables ;
+
 int	predictor_zero (G72x_STATE *state_ptr) ;
 
 int	predictor_pole (G72x_STATE *state_ptr) ;
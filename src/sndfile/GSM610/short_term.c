@@ -9,6 +9,10 @@
 
 #include "gsm610_priv.h"
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /*
  *  SHORT TERM ANALYSIS FILTERING SECTION
  */
@@ -248,6 +252,31 @@ static void Fast_Short_term_analysis_filtering (
 }
 #endif /* ! (defined (USE_FLOAT_MUL) && defined (FAST)) */
 
+/*
+ *  gsm_mult_r () with its one overflowing case, MIN_WORD * MIN_WORD,
+ *  saturated to MAX_WORD, as the MIN_WORD tests in the loops above do.
+ */
+static inline int16_t Mult_r_sat (int16_t a, int16_t b)
+{
+	int32_t		prod = GSM_MULT_R (a, b) ;
+
+	return prod > MAX_WORD ? MAX_WORD : prod ;
+}
+
+/*
+ *  GSM_SUB () on the serial path of the synthesis filter. SSE2 has a
+ *  saturating 16 bit subtract, one instruction instead of a subtract
+ *  and two compares.
+ */
+static inline int16_t Sub_sat (int16_t a, int16_t b)
+{
+#if defined (__SSE2__)
+	return _mm_cvtsi128_si32 (_mm_subs_epi16 (_mm_cvtsi32_si128 (a), _mm_cvtsi32_si128 (b))) ;
+#else
+	return GSM_SUB (a, b) ;
+#endif
+}
+
 static void Short_term_synthesis_filtering (
 	struct gsm_state * S,
 	register int16_t	* rrp,	/* [0..7]	IN	*/
@@ -256,35 +285,45 @@ static void Short_term_synthesis_filtering (
 	register int16_t	* sr	/* [0..k-1]	OUT	*/
 )
 {
-	register int16_t		* v = S->v ;
+	/*
+	 *  The lattice is a serial chain through sri, so the time goes in the
+	 *  latency of each stage rather than in arithmetic. The stages are
+	 *  written out with constant indices and v [] and rrp [] are copied to
+	 *  locals, so the whole state stays in registers for the block and the
+	 *  MIN_WORD tests become a branch free saturation. Same results as
+	 *
+	 *	for (i = 8 ; i-- ; )
+	 *	{	sri = GSM_SUB (sri, gsm_mult_r (rrp [i], v [i])) ;
+	 *		v [i+1] = GSM_ADD (v [i], gsm_mult_r (rrp [i], sri)) ;
+	 *	}
+	 */
+	int16_t		v [9], rp [8] ;
 	register int		i ;
-	register int16_t		sri, tmp1, tmp2 ;
+	register int16_t	sri ;
+
+	for (i = 0 ; i < 9 ; i++) v [i] = S->v [i] ;
+	for (i = 0 ; i < 8 ; i++) rp [i] = rrp [i] ;
+
+#define	SYNTHESIS_STAGE(i)												\
+	sri = Sub_sat (sri, Mult_r_sat (rp [i], v [i])) ;					\
+	v [i + 1] = GSM_ADD (v [i], Mult_r_sat (rp [i], sri))
 
 	while (k--)
 	{	sri = *wt++ ;
-		for (i = 8 ; i-- ; )
-		{	/* sri = GSM_SUB(sri, gsm_mult_r(rrp[i], v [i])) ;
-			 */
-			tmp1 = rrp [i] ;
-			tmp2 = v [i] ;
-			tmp2 = (tmp1 == MIN_WORD && tmp2 == MIN_WORD
-				? MAX_WORD
-				: 0x0FFFF & (((int32_t) tmp1 * (int32_t) tmp2
-							+ 16384) >> 15)) ;
-
-			sri = GSM_SUB (sri, tmp2) ;
-
-			/* v [i+1] = GSM_ADD (v [i], gsm_mult_r(rrp[i], sri)) ;
-			 */
-			tmp1 = (tmp1 == MIN_WORD && sri == MIN_WORD
-				? MAX_WORD
-				: 0x0FFFF & (((int32_t) tmp1 * (int32_t) sri
-							+ 16384) >> 15)) ;
-
-			v [i + 1] = GSM_ADD (v [i], tmp1) ;
-		}
+		SYNTHESIS_STAGE (7) ;
+		SYNTHESIS_STAGE (6) ;
+		SYNTHESIS_STAGE (5) ;
+		SYNTHESIS_STAGE (4) ;
+		SYNTHESIS_STAGE (3) ;
+		SYNTHESIS_STAGE (2) ;
+		SYNTHESIS_STAGE (1) ;
+		SYNTHESIS_STAGE (0) ;
 		*sr++ = v [0] = sri ;
 	}
+
+#undef	SYNTHESIS_STAGE
+
+	for (i = 0 ; i < 9 ; i++) S->v [i] = v [i] ;
 }
 
 
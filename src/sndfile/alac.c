@@ -24,6 +24,10 @@
 #include	<math.h>
 #include	<errno.h>
 
+#if HAVE_UNISTD_H
+#include	<unistd.h>
+#endif
+
 #include	"sndfile.h"
 #include	"sfendian.h"
 #include	"common.h"
@@ -34,6 +38,21 @@
 #define		ALAC_BYTE_BUFFER_SIZE	0x20000
 #define		ALAC_MAX_CHANNEL_COUNT	8	// Same as kALACMaxChannels in /ALACAudioTypes.h
 
+/*
+** Blocks only depend on their own packet, so large reads can decode a batch
+** of them on several threads at once. ALAC_BULK_BLOCKS is the number of
+** blocks each thread gets per batch.
+*/
+#if defined (_POSIX_THREADS) && (_POSIX_THREADS > 0)
+#define		ALAC_BULK_THREADS		1
+#include	<pthread.h>
+#else
+#define		ALAC_BULK_THREADS		0
+#endif
+
+#define		ALAC_MAX_DECODER_THREADS	64
+#define		ALAC_BULK_BLOCKS			8
+
 typedef struct
 {	uint32_t	current, count, allocated ;
 	uint32_t	packet_size [] ;
@@ -61,6 +80,10 @@ typedef struct
 	char enctmpname [512] ;
 	FILE *enctmp ;
 
+	/* Decoded samples being read, either buffer or a batch from the bulk decoder. */
+	int		*block ;
+	struct alac_bulk *bulk ;
+
 	uint8_t	byte_buffer [ALAC_MAX_CHANNEL_COUNT * ALAC_BYTE_BUFFER_SIZE] ;
 
 	int	buffer	[] ;
@@ -91,6 +114,10 @@ static int	alac_close		(SF_PRIVATE *psf) ;
 static int	alac_byterate	(SF_PRIVATE *psf) ;
 
 static int alac_decode_block (SF_PRIVATE *psf, ALAC_PRIVATE *plac) ;
+static int alac_decode_next (SF_PRIVATE *psf, ALAC_PRIVATE *plac, sf_count_t frames) ;
+static int alac_bulk_decode (SF_PRIVATE *psf, ALAC_PRIVATE *plac, sf_count_t frames) ;
+static void alac_bulk_close (ALAC_PRIVATE *plac) ;
+static int alac_bulk_open (SF_PRIVATE *psf, ALAC_PRIVATE *plac, int threads) ;
 static int alac_encode_block (ALAC_PRIVATE *plac) ;
 
 static uint32_t alac_kuki_read (SF_PRIVATE * psf, uint32_t kuki_offset, uint8_t * kuki, size_t kuki_maxlen) ;
@@ -213,6 +240,8 @@ alac_close	(SF_PRIVATE *psf)
 			} ;
 		} ;
 
+	alac_bulk_close (plac) ;
+
 	if (plac->pakt_info)
 		free (plac->pakt_info) ;
 	plac->pakt_info = NULL ;
@@ -427,6 +456,7 @@ alac_decode_block (SF_PRIVATE *psf, ALAC_PRIVATE *plac)
 
 	plac->input_data_pos += packet_size ;
 	plac->frames_this_block = 0 ;
+	plac->block = plac->buffer ;
 	alac_decode (pdec, &bit_buffer, plac->buffer, plac->frames_per_block, &plac->frames_this_block) ;
 
 	plac->partial_block_frames = 0 ;
@@ -434,6 +464,16 @@ alac_decode_block (SF_PRIVATE *psf, ALAC_PRIVATE *plac)
 	return 1 ;
 } /* alac_decode_block */
 
+static int
+alac_decode_next (SF_PRIVATE *psf, ALAC_PRIVATE *plac, sf_count_t frames)
+{
+	/* Only worth sharing out when the caller wants several blocks. */
+	if (plac->bulk != NULL && frames >= 2 * plac->frames_per_block && alac_bulk_decode (psf, plac, frames))
+		return 1 ;
+
+	return alac_decode_block (psf, plac) ;
+} /* alac_decode_next */
+
 
 static int
 alac_encode_block (ALAC_PRIVATE *plac)
@@ -452,6 +492,318 @@ alac_encode_block (ALAC_PRIVATE *plac)
 	return 1 ;
 } /* alac_encode_block */
 
+/*============================================================================================
+** Bulk decoder. Large reads gather a batch of up to threads * ALAC_BULK_BLOCKS blocks
+** from the pakt table, fetch all their packets with a single read and split the blocks
+** between the caller and a pool of worker threads, each with its own decoder state.
+** Every block is decoded straight into its own slot of the batch buffer, so the result
+** is identical to decoding the blocks one at a time.
+*/
+
+#if ALAC_BULK_THREADS
+
+struct alac_bulk ;
+
+typedef struct
+{	struct alac_bulk *bulk ;
+	int			index ;
+	pthread_t	thread ;
+} ALAC_BULK_WORKER ;
+
+struct alac_bulk
+{	ALAC_PRIVATE	*plac ;
+	int				threads, started ;
+	ALAC_BULK_WORKER *workers ;
+
+	pthread_mutex_t	mutex ;
+	pthread_cond_t	cond ;
+	int				running, pending ;
+	unsigned		generation ;
+
+	/* One decoder per thread, slice 0 runs on the caller's thread. */
+	ALAC_DECODER	*decoders ;
+
+	uint8_t			*data ;
+	size_t			datasize ;
+
+	/* Packet offsets into data (blocks + 1 of them) and decoded frames per block. */
+	uint32_t		*offset, *frames ;
+	uint32_t		blocks, max_blocks ;
+
+	int32_t			*pcm ;
+} ;
+
+static void
+alac_bulk_slice (struct alac_bulk *bulk, int index)
+{	ALAC_PRIVATE *plac = bulk->plac ;
+	BitBuffer	bit_buffer ;
+	uint32_t	k, first, last ;
+
+	first = (uint32_t) (((uint64_t) index * bulk->blocks) / bulk->threads) ;
+	last = (uint32_t) (((uint64_t) (index + 1) * bulk->blocks) / bulk->threads) ;
+
+	for (k = first ; k < last ; k++)
+	{	BitBufferInit (&bit_buffer, bulk->data + bulk->offset [k], bulk->offset [k + 1] - bulk->offset [k]) ;
+		bulk->frames [k] = 0 ;
+		alac_decode (&bulk->decoders [index], &bit_buffer, bulk->pcm + (size_t) k * plac->frames_per_block * plac->channels,
+						plac->frames_per_block, &bulk->frames [k]) ;
+		} ;
+} /* alac_bulk_slice */
+
+static void *
+alac_bulk_worker (void *data)
+{	ALAC_BULK_WORKER *worker = data ;
+	struct alac_bulk *bulk = worker->bulk ;
+	unsigned	seen ;
+
+	/* Workers are all started before the first batch is queued. */
+	seen = 0 ;
+
+	pthread_mutex_lock (&bulk->mutex) ;
+
+	for ( ; ; )
+	{	while (bulk->running && bulk->generation == seen)
+			pthread_cond_wait (&bulk->cond, &bulk->mutex) ;
+
+		if (! bulk->running)
+			break ;
+
+		seen = bulk->generation ;
+		pthread_mutex_unlock (&bulk->mutex) ;
+
+		alac_bulk_slice (bulk, worker->index) ;
+
+		pthread_mutex_lock (&bulk->mutex) ;
+		if (--bulk->pending == 0)
+			pthread_cond_broadcast (&bulk->cond) ;
+		} ;
+
+	pthread_mutex_unlock (&bulk->mutex) ;
+
+	return NULL ;
+} /* alac_bulk_worker */
+
+static void
+alac_bulk_close (ALAC_PRIVATE *plac)
+{	struct alac_bulk *bulk = plac->bulk ;
+	int k ;
+
+	if (bulk == NULL)
+		return ;
+
+	pthread_mutex_lock (&bulk->mutex) ;
+	bulk->running = 0 ;
+	pthread_cond_broadcast (&bulk->cond) ;
+	pthread_mutex_unlock (&bulk->mutex) ;
+
+	for (k = 1 ; k < bulk->started ; k++)
+		pthread_join (bulk->workers [k].thread, NULL) ;
+
+	pthread_cond_destroy (&bulk->cond) ;
+	pthread_mutex_destroy (&bulk->mutex) ;
+
+	if (plac->block == bulk->pcm)
+	{	plac->block = plac->buffer ;
+		plac->frames_this_block = plac->partial_block_frames = 0 ;
+		} ;
+
+	free (bulk->workers) ;
+	free (bulk->decoders) ;
+	free (bulk->data) ;
+	free (bulk->offset) ;
+	free (bulk->frames) ;
+	free (bulk->pcm) ;
+	free (bulk) ;
+
+	plac->bulk = NULL ;
+} /* alac_bulk_close */
+
+static int
+alac_bulk_open (SF_PRIVATE *psf, ALAC_PRIVATE *plac, int threads)
+{	struct alac_bulk *bulk ;
+	int k ;
+
+	if ((bulk = calloc (1, sizeof (struct alac_bulk))) == NULL)
+		return SFE_MALLOC_FAILED ;
+
+	bulk->plac = plac ;
+	bulk->threads = threads ;
+	bulk->running = 1 ;
+	bulk->max_blocks = threads * ALAC_BULK_BLOCKS ;
+
+	bulk->workers = calloc (threads, sizeof (ALAC_BULK_WORKER)) ;
+	bulk->decoders = malloc (threads * sizeof (ALAC_DECODER)) ;
+	bulk->offset = malloc ((bulk->max_blocks + 1) * sizeof (uint32_t)) ;
+	bulk->frames = malloc (bulk->max_blocks * sizeof (uint32_t)) ;
+	bulk->pcm = malloc ((size_t) bulk->max_blocks * plac->frames_per_block * plac->channels * sizeof (int32_t)) ;
+
+	if (bulk->workers == NULL || bulk->decoders == NULL || bulk->offset == NULL || bulk->frames == NULL || bulk->pcm == NULL)
+	{	free (bulk->workers) ;
+		free (bulk->decoders) ;
+		free (bulk->offset) ;
+		free (bulk->frames) ;
+		free (bulk->pcm) ;
+		free (bulk) ;
+		return SFE_MALLOC_FAILED ;
+		} ;
+
+	/* The decoder only keeps its configuration between blocks, so copies of it are independent. */
+	for (k = 0 ; k < threads ; k++)
+		bulk->decoders [k] = plac->decoder ;
+
+	pthread_mutex_init (&bulk->mutex, NULL) ;
+	pthread_cond_init (&bulk->cond, NULL) ;
+
+	plac->bulk = bulk ;
+
+	for (bulk->started = 1 ; bulk->started < threads ; bulk->started++)
+	{	ALAC_BULK_WORKER *worker = &bulk->workers [bulk->started] ;
+
+		worker->bulk = bulk ;
+		worker->index = bulk->started ;
+		if (pthread_create (&worker->thread, NULL, alac_bulk_worker, worker) != 0)
+		{	psf_log_printf (psf, "%s : could not start decoder thread %d.\n", __func__, bulk->started) ;
+			alac_bulk_close (plac) ;
+			return SFE_INTERNAL ;
+			} ;
+		} ;
+
+	return 0 ;
+} /* alac_bulk_open */
+
+static int
+alac_bulk_decode (SF_PRIVATE *psf, ALAC_PRIVATE *plac, sf_count_t frames)
+{	struct alac_bulk *bulk = plac->bulk ;
+	PAKT_INFO	*info = plac->pakt_info ;
+	uint32_t	k, want, blocks, packet_size, total ;
+	size_t		bytes = 0, stride ;
+
+	want = frames / plac->frames_per_block > bulk->max_blocks ? bulk->max_blocks : (uint32_t) (frames / plac->frames_per_block) ;
+
+	for (blocks = 0 ; blocks < want && info->current + blocks < info->count ; blocks++)
+	{	packet_size = info->packet_size [info->current + blocks] ;
+		if (packet_size == 0 || packet_size > sizeof (plac->byte_buffer))
+			break ;
+		bulk->offset [blocks] = bytes ;
+		bytes += packet_size ;
+		} ;
+	bulk->offset [blocks] = bytes ;
+
+	/* Anything odd is left to alac_decode_block () to report. */
+	if (blocks < 2)
+		return 0 ;
+
+	/*
+	** The bit reader doesn't check the end of a packet and a damaged one can send it
+	** well past it, so leave as much room after the last packet as byte_buffer has.
+	*/
+	if (bytes + sizeof (plac->byte_buffer) > bulk->datasize)
+	{	uint8_t *data ;
+
+		if ((data = realloc (bulk->data, bytes + sizeof (plac->byte_buffer))) == NULL)
+			return 0 ;
+		bulk->data = data ;
+		bulk->datasize = bytes + sizeof (plac->byte_buffer) ;
+		} ;
+
+	psf_fseek (psf, plac->input_data_pos, SEEK_SET) ;
+	if (psf_fread (bulk->data, 1, bytes, psf) != (sf_count_t) bytes)
+		return 0 ;
+
+	pthread_mutex_lock (&bulk->mutex) ;
+	bulk->blocks = blocks ;
+	bulk->pending = bulk->threads - 1 ;
+	bulk->generation ++ ;
+	pthread_cond_broadcast (&bulk->cond) ;
+	pthread_mutex_unlock (&bulk->mutex) ;
+
+	alac_bulk_slice (bulk, 0) ;
+
+	pthread_mutex_lock (&bulk->mutex) ;
+	while (bulk->pending > 0)
+		pthread_cond_wait (&bulk->cond, &bulk->mutex) ;
+	pthread_mutex_unlock (&bulk->mutex) ;
+
+	/* Close the gaps left by short blocks, normally only the last one in the file. */
+	stride = (size_t) plac->frames_per_block * plac->channels ;
+	for (k = 0, total = 0 ; k < blocks ; k++)
+	{	if (total != k * plac->frames_per_block)
+			memmove (bulk->pcm + (size_t) total * plac->channels, bulk->pcm + k * stride, bulk->frames [k] * plac->channels * sizeof (int32_t)) ;
+		total += bulk->frames [k] ;
+		} ;
+
+	plac->input_data_pos += bytes ;
+	info->current += blocks ;
+
+	plac->block = bulk->pcm ;
+	plac->frames_this_block = total ;
+	plac->partial_block_frames = 0 ;
+
+	return 1 ;
+} /* alac_bulk_decode */
+
+#else
+
+struct alac_bulk
+{	int dummy ;
+} ;
+
+static void
+alac_bulk_close (ALAC_PRIVATE *plac)
+{	plac->bulk = NULL ;
+} /* alac_bulk_close */
+
+static int
+alac_bulk_open (SF_PRIVATE * UNUSED (psf), ALAC_PRIVATE * UNUSED (plac), int UNUSED (threads))
+{	return SFE_INTERNAL ;
+} /* alac_bulk_open */
+
+static int
+alac_bulk_decode (SF_PRIVATE * UNUSED (psf), ALAC_PRIVATE * UNUSED (plac), sf_count_t UNUSED (frames))
+{	return 0 ;
+} /* alac_bulk_decode */
+
+#endif
+
+int
+alac_set_decoder_threads (SF_PRIVATE *psf, int threads)
+{	ALAC_PRIVATE *plac ;
+	int reposition ;
+
+	if ((plac = psf->codec_data) == NULL || psf->file.mode != SFM_READ)
+		return SF_FALSE ;
+
+	if (threads < 0 || threads > ALAC_MAX_DECODER_THREADS)
+		return SF_FALSE ;
+
+#if (ALAC_BULK_THREADS && defined (_SC_NPROCESSORS_ONLN))
+	if (threads == 0)
+		threads = sysconf (_SC_NPROCESSORS_ONLN) ;
+#endif
+	if (threads > ALAC_MAX_DECODER_THREADS)
+		threads = ALAC_MAX_DECODER_THREADS ;
+	else if (threads < 1)
+		threads = 1 ;
+
+	if (ALAC_BULK_THREADS == 0 && threads > 1)
+		return SF_FALSE ;
+
+	/* A batch being read is dropped with the old decoder, so decode the rest again. */
+	reposition = plac->bulk != NULL && plac->block != plac->buffer ;
+
+	alac_bulk_close (plac) ;
+
+	if (reposition && alac_seek (psf, SFM_READ, psf->read_current) < 0)
+		return SF_FALSE ;
+
+	psf_log_printf (psf, "%s : Setting SFC_SET_DECODER_THREADS to %d.\n", __func__, threads) ;
+
+	if (threads > 1 && alac_bulk_open (psf, plac, threads) != 0)
+		return SF_FALSE ;
+
+	return SF_TRUE ;
+} /* alac_set_decoder_threads */
+
 /*============================================================================================
 ** ALAC read functions.
 */
@@ -467,13 +819,13 @@ alac_read_s (SF_PRIVATE *psf, short *ptr, sf_count_t len)
 		return 0 ;
 
 	while (len > 0)
-	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_block (psf, plac) == 0)
+	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_next (psf, plac, len / plac->channels) == 0)
 			break ;
 
 		readcount = (plac->frames_this_block - plac->partial_block_frames) * plac->channels ;
 		readcount = readcount > len ? len : readcount ;
 
-		iptr = plac->buffer + plac->partial_block_frames * plac->channels ;
+		iptr = plac->block + plac->partial_block_frames * plac->channels ;
 
 		for (k = 0 ; k < readcount ; k++)
 			ptr [total + k] = iptr [k] >> 16 ;
@@ -497,13 +849,13 @@ alac_read_i (SF_PRIVATE *psf, int *ptr, sf_count_t len)
 		return 0 ;
 
 	while (len > 0)
-	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_block (psf, plac) == 0)
+	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_next (psf, plac, len / plac->channels) == 0)
 			break ;
 
 		readcount = (plac->frames_this_block - plac->partial_block_frames) * plac->channels ;
 		readcount = readcount > len ? len : readcount ;
 
-		iptr = plac->buffer + plac->partial_block_frames * plac->channels ;
+		iptr = plac->block + plac->partial_block_frames * plac->channels ;
 
 		for (k = 0 ; k < readcount ; k++)
 			ptr [total + k] = iptr [k] ;
@@ -530,13 +882,13 @@ alac_read_f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	normfact = (psf->norm_float == SF_TRUE) ? 1.0 / ((float) 0x80000000) : 1.0 ;
 
 	while (len > 0)
-	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_block (psf, plac) == 0)
+	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_next (psf, plac, len / plac->channels) == 0)
 			break ;
 
 		readcount = (plac->frames_this_block - plac->partial_block_frames) * plac->channels ;
 		readcount = readcount > len ? len : readcount ;
 
-		iptr = plac->buffer + plac->partial_block_frames * plac->channels ;
+		iptr = plac->block + plac->partial_block_frames * plac->channels ;
 
 		for (k = 0 ; k < readcount ; k++)
 			ptr [total + k] = normfact * iptr [k] ;
@@ -563,13 +915,13 @@ alac_read_d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	normfact = (psf->norm_double == SF_TRUE) ? 1.0 / ((float) 0x80000000) : 1.0 ;
 
 	while (len > 0)
-	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_block (psf, plac) == 0)
+	{	if (plac->partial_block_frames >= plac->frames_this_block && alac_decode_next (psf, plac, len / plac->channels) == 0)
 			break ;
 
 		readcount = (plac->frames_this_block - plac->partial_block_frames) * plac->channels ;
 		readcount = readcount > len ? len : readcount ;
 
-		iptr = plac->buffer + plac->partial_block_frames * plac->channels ;
+		iptr = plac->block + plac->partial_block_frames * plac->channels ;
 
 		for (k = 0 ; k < readcount ; k++)
 			ptr [total + k] = normfact * iptr [k] ;
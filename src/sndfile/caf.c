@@ -230,7 +230,7 @@ caf_close (SF_PRIVATE *psf)
 } /* caf_close */
 
 static int
-caf_command (SF_PRIVATE * psf, int command, void * UNUSED (data), int UNUSED (datasize))
+caf_command (SF_PRIVATE * psf, int command, void * UNUSED (data), int datasize)
 {	CAF_PRIVATE	*pcaf ;
 
 	if ((pcaf = psf->container_data) == NULL)
@@ -241,6 +241,18 @@ caf_command (SF_PRIVATE * psf, int command, void * UNUSED (data), int UNUSED (da
 			pcaf->chanmap_tag = aiff_caf_find_channel_layout_tag (psf->channel_map, psf->sf.channels) ;
 			return (pcaf->chanmap_tag != 0) ;
 
+		case SFC_SET_DECODER_THREADS :
+			switch (SF_CODEC (psf->sf.format))
+			{	case SF_FORMAT_ALAC_16 :
+				case SF_FORMAT_ALAC_20 :
+				case SF_FORMAT_ALAC_24 :
+				case SF_FORMAT_ALAC_32 :
+					return alac_set_decoder_threads (psf, datasize) ;
+				default :
+					break ;
+				} ;
+			return SF_FALSE ;
+
 		default :
 			break ;
 	} ;
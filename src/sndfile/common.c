@@ -19,6 +19,7 @@
 #include <config.h>
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 #if HAVE_UNISTD_H
 #include <unistd.h>
@@ -28,6 +29,7 @@
 #include <ctype.h>
 #include <math.h>
 #include <time.h>
+#include <sys/stat.h>
 #if HAVE_SYS_TIME_H
 #include <sys/time.h>
 #endif
@@ -107,6 +109,9 @@ psf_log_printf (SF_PRIVATE *psf, const char *format, ...)
 	int			d, tens, shift, width, width_specifier, left_align, slen ;
 	char		c, *strptr, istr [5], lead_char, sign_char ;
 
+	if (psf->no_parselog)
+		return ;
+
 	va_start (ap, format) ;
 
 	while ((c = *format++))
@@ -1749,3 +1754,205 @@ psf_open_tmpfile (char * fname, size_t fnamelen)
 	memset (fname, 0, fnamelen) ;
 	return NULL ;
 } /* psf_open_tmpfile */
+
+/*==============================================================================
+** Seek index.
+**
+** The compressed codecs record where decoding can restart as they decode,
+** so repeated seeks start from a known file position instead of searching.
+** The points can be kept in a "<path>.sfidx" sidecar file between opens. It
+** is tied to the file it was built from by the length, data offset, frame
+** count and modification time.
+*/
+
+#define	SEEK_SIDECAR_MAGIC		"SFIX"
+#define	SEEK_SIDECAR_VERSION	1
+
+typedef struct
+{	char		magic [4] ;
+	uint32_t	version ;
+	int64_t		filelength, fileoffset, dataoffset ;
+	int64_t		frames, mtime ;
+	int64_t		count ;
+} SEEK_SIDECAR_HEADER ;
+
+void
+psf_seek_index_add (SF_PRIVATE *psf, sf_count_t frame, sf_count_t offset)
+{	PSF_SEEK_INDEX *idx = &psf->seekidx ;
+	sf_count_t low, high, mid ;
+
+	if (idx->enabled == 0 || frame < 0 || offset < 0)
+		return ;
+
+	/* Points are nearly always found in order, so check the end first. */
+	if (idx->count == 0 || idx->points [idx->count - 1].frame < frame)
+		low = idx->count ;
+	else
+	{	low = 0 ;
+		high = idx->count ;
+		while (low < high)
+		{	mid = low + (high - low) / 2 ;
+			if (idx->points [mid].frame < frame)
+				low = mid + 1 ;
+			else
+				high = mid ;
+			} ;
+
+		if (low < idx->count && idx->points [low].frame == frame)
+			return ;
+		} ;
+
+	if (idx->count >= idx->alloced)
+	{	sf_count_t alloced = idx->alloced < 256 ? 256 : 2 * idx->alloced ;
+		PSF_SEEK_POINT *points ;
+
+		if ((points = realloc (idx->points, alloced * sizeof (PSF_SEEK_POINT))) == NULL)
+			return ;
+		idx->points = points ;
+		idx->alloced = alloced ;
+		} ;
+
+	if (low < idx->count)
+		memmove (idx->points + low + 1, idx->points + low, (idx->count - low) * sizeof (PSF_SEEK_POINT)) ;
+
+	idx->points [low].frame = frame ;
+	idx->points [low].offset = offset ;
+	idx->count ++ ;
+	idx->dirty = SF_TRUE ;
+} /* psf_seek_index_add */
+
+const PSF_SEEK_POINT *
+psf_seek_index_find (const SF_PRIVATE *psf, sf_count_t frame, sf_count_t *next_frame)
+{	const PSF_SEEK_INDEX *idx = &psf->seekidx ;
+	sf_count_t low, high, mid ;
+
+	if (idx->enabled == 0 || idx->count == 0 || frame < idx->points [0].frame)
+		return NULL ;
+
+	/* Find the last point at or before frame. */
+	low = 0 ;
+	high = idx->count ;
+	while (high - low > 1)
+	{	mid = low + (high - low) / 2 ;
+		if (idx->points [mid].frame <= frame)
+			low = mid ;
+		else
+			high = mid ;
+		} ;
+
+	if (next_frame != NULL)
+		*next_frame = low + 1 < idx->count ? idx->points [low + 1].frame : -1 ;
+
+	return idx->points + low ;
+} /* psf_seek_index_find */
+
+void
+psf_seek_index_clear (SF_PRIVATE *psf)
+{
+	psf->seekidx.count = 0 ;
+	psf->seekidx.dirty = SF_FALSE ;
+} /* psf_seek_index_clear */
+
+static int
+psf_seek_sidecar_header (SF_PRIVATE *psf, char *path, size_t pathlen, SEEK_SIDECAR_HEADER *header)
+{	struct stat statbuf ;
+
+	if (psf->virtual_io || psf->is_pipe || psf->file.path.c [0] == 0)
+		return SFE_BAD_COMMAND_PARAM ;
+
+#if USE_WINDOWS_API
+	/* The path union holds a wide string. */
+	if (psf->file.use_wchar)
+		return SFE_BAD_COMMAND_PARAM ;
+#endif
+
+	if (stat (psf->file.path.c, &statbuf) != 0)
+		return SFE_BAD_STAT_SIZE ;
+
+	if ((size_t) snprintf (path, pathlen, "%s.sfidx", psf->file.path.c) >= pathlen)
+		return SFE_BAD_COMMAND_PARAM ;
+
+	memset (header, 0, sizeof (SEEK_SIDECAR_HEADER)) ;
+	memcpy (header->magic, SEEK_SIDECAR_MAGIC, sizeof (header->magic)) ;
+	header->version = SEEK_SIDECAR_VERSION ;
+	header->filelength = psf->filelength ;
+	header->fileoffset = psf->fileoffset ;
+	header->dataoffset = psf->dataoffset ;
+	header->frames = psf->sf.frames ;
+	header->mtime = statbuf.st_mtime ;
+
+	return 0 ;
+} /* psf_seek_sidecar_header */
+
+int
+psf_seek_index_set_sidecar (SF_PRIVATE *psf, int on)
+{	SEEK_SIDECAR_HEADER expected, header ;
+	PSF_SEEK_POINT point ;
+	char path [SF_FILENAME_LEN + 8] ;
+	FILE *file ;
+	sf_count_t k ;
+	int error ;
+
+	if (on == SF_FALSE)
+	{	psf->seekidx.sidecar = SF_FALSE ;
+		return 0 ;
+		} ;
+
+	if (psf->seekidx.sidecar)
+		return 0 ;
+
+	if ((error = psf_seek_sidecar_header (psf, path, sizeof (path), &expected)) != 0)
+		return error ;
+
+	psf->seekidx.sidecar = SF_TRUE ;
+
+	/* A missing or stale sidecar is not an error, it gets rewritten on close. */
+	if ((file = fopen (path, "rb")) == NULL)
+		return 0 ;
+
+	if (fread (&header, sizeof (header), 1, file) != 1 || header.count < 0
+			|| memcmp (&header, &expected, offsetof (SEEK_SIDECAR_HEADER, count)) != 0)
+	{	psf_log_printf (psf, "Ignoring stale seek index %s\n", path) ;
+		fclose (file) ;
+		return 0 ;
+		} ;
+
+	for (k = 0 ; k < header.count ; k++)
+	{	if (fread (&point, sizeof (point), 1, file) != 1)
+			break ;
+		psf_seek_index_add (psf, point.frame, point.offset) ;
+		} ;
+
+	/* Only points the sidecar lacks make it worth rewriting. */
+	psf->seekidx.dirty = k != header.count || psf->seekidx.count != header.count ;
+
+	fclose (file) ;
+
+	return 0 ;
+} /* psf_seek_index_set_sidecar */
+
+void
+psf_seek_index_close (SF_PRIVATE *psf)
+{	SEEK_SIDECAR_HEADER header ;
+	char path [SF_FILENAME_LEN + 8] ;
+	FILE *file ;
+
+	if (psf->seekidx.sidecar && psf->seekidx.dirty && psf->seekidx.count > 0
+			&& psf_seek_sidecar_header (psf, path, sizeof (path), &header) == 0)
+	{	header.count = psf->seekidx.count ;
+
+		if ((file = fopen (path, "wb")) != NULL)
+		{	if (fwrite (&header, sizeof (header), 1, file) != 1
+					|| fwrite (psf->seekidx.points, sizeof (PSF_SEEK_POINT), header.count, file) != (size_t) header.count)
+				header.count = 0 ;
+			fclose (file) ;
+
+			/* Don't leave a truncated index behind. */
+			if (header.count == 0)
+				remove (path) ;
+			} ;
+		} ;
+
+	free (psf->seekidx.points) ;
+	memset (&psf->seekidx, 0, sizeof (psf->seekidx)) ;
+} /* psf_seek_index_close */
@@ -76,6 +76,10 @@
 #endif
 
 #define	SF_BUFFER_LEN			(8192)
+#define	SF_IO_BUFFER_LEN		(65536)
+#define	SF_PROBE_HEAD_LEN		(4096)
+#define	SF_IO_BUFFER_MAX		(0x4000000)
+#define	SF_IO_READAHEAD_MAX		(64)
 #define	SF_FILENAME_LEN			(1024)
 #define SF_SYSERR_LEN			(256)
 #define SF_MAX_STRINGS			(32)
@@ -363,6 +367,49 @@ typedef struct
 	int				mode ;			/* Open mode : SFM_READ, SFM_WRITE or SFM_RDWR. */
 } PSF_FILE ;
 
+/*
+**	Read-ahead/write-behind buffer sitting between psf_fread/psf_fwrite and
+**	the file descriptor. Only used by src/file_io.c.
+*/
+
+enum
+{	PSF_IO_IDLE = 0,	/* Nothing buffered, the descriptor is at the logical position. */
+	PSF_IO_READ,		/* Holds file bytes [start, start + fill), logically at start + pos. */
+	PSF_IO_WRITE		/* Holds fill bytes still to be written at start. */
+} ;
+
+typedef struct
+{	unsigned char	*ptr ;
+	sf_count_t		size ;		/* Capacity in bytes, 0 for unbuffered i/o. */
+	sf_count_t		start ;		/* File position of ptr [0], -1 if unknown. */
+	sf_count_t		fill, pos ;
+	sf_count_t		fdpos ;		/* Descriptor position while reading. */
+	int				state ;
+
+	/* Number of blocks to read in the background and the worker doing it. */
+	int				ahead ;
+	struct psf_io_async	*async ;
+} PSF_IO_BUFFER ;
+
+/*
+**	Frame to file position map kept by the compressed codecs which can not
+**	compute where a frame lives. Points are added as the data is decoded and
+**	kept sorted by frame.
+*/
+
+typedef struct
+{	sf_count_t		frame ;		/* First frame produced by decoding from offset. */
+	sf_count_t		offset ;	/* File position decoding can be started from. */
+} PSF_SEEK_POINT ;
+
+typedef struct
+{	PSF_SEEK_POINT	*points ;
+	sf_count_t		count, alloced ;
+	int				enabled ;	/* Set by the codec when it records and uses points. */
+	int				sidecar ;	/* Load from and save to "<path>.sfidx". */
+	int				dirty ;		/* Points added since loading. */
+} PSF_SEEK_INDEX ;
+
 
 
 typedef union
@@ -393,6 +440,11 @@ typedef struct sf_private_tag
 
 	PSF_FILE		file, rsrc ;
 
+	PSF_IO_BUFFER	iobuf ;
+	SF_IO_STATS		io_stats ;
+
+	PSF_SEEK_INDEX	seekidx ;
+
 	char			syserr		[SF_SYSERR_LEN] ;
 
 	/* parselog and indx should only be changed within the logging functions
@@ -403,6 +455,9 @@ typedef struct sf_private_tag
 		int				indx ;
 	} parselog ;
 
+	/* Set by sf_probe () which has no use for the parse log. */
+	int				no_parselog ;
+
 
 	struct
 	{	unsigned char	* ptr ;
@@ -517,6 +572,9 @@ typedef struct sf_private_tag
 	sf_count_t		(*write_float)	(struct sf_private_tag*, const float *ptr, sf_count_t len) ;
 	sf_count_t		(*write_double)	(struct sf_private_tag*, const double *ptr, sf_count_t len) ;
 
+	/* Optional, for files that store each channel separately. Counts frames. */
+	sf_count_t		(*read_float_planar)	(struct sf_private_tag*, float * const *ptr, sf_count_t frames) ;
+
 	sf_count_t		(*seek) 		(struct sf_private_tag*, int mode, sf_count_t samples_from_start) ;
 	int				(*write_header)	(struct sf_private_tag*, int calc_length) ;
 	int				(*command)		(struct sf_private_tag*, int command, void *data, int datasize) ;
@@ -853,6 +911,8 @@ int psf_file_valid (SF_PRIVATE *psf) ;
 void psf_set_file (SF_PRIVATE *psf, int fd) ;
 void psf_init_files (SF_PRIVATE *psf) ;
 void psf_use_rsrc (SF_PRIVATE *psf, int on_off) ;
+int psf_set_io_buffer (SF_PRIVATE *psf, sf_count_t size) ;
+int psf_set_io_readahead (SF_PRIVATE *psf, int blocks) ;
 
 SNDFILE * psf_open_file (SF_PRIVATE *psf, SF_INFO *sfinfo) ;
 
@@ -932,11 +992,13 @@ int		float32_init	(SF_PRIVATE *psf) ;
 int		double64_init	(SF_PRIVATE *psf) ;
 int		dwvw_init		(SF_PRIVATE *psf, int bitwidth) ;
 int		gsm610_init		(SF_PRIVATE *psf) ;
+int		gsm610_set_pool	(int enable) ;
 int		nms_adpcm_init	(SF_PRIVATE *psf) ;
 int		vox_adpcm_init	(SF_PRIVATE *psf) ;
 int		flac_init		(SF_PRIVATE *psf) ;
 int		g72x_init 		(SF_PRIVATE * psf) ;
 int		alac_init		(SF_PRIVATE *psf, const ALAC_DECODER_INFO * info) ;
+int		alac_set_decoder_threads (SF_PRIVATE *psf, int threads) ;
 
 int 	dither_init		(SF_PRIVATE *psf, int mode) ;
 
@@ -1035,6 +1097,16 @@ void	alac_get_desc_chunk_items (int subformat, uint32_t *fmt_flags, uint32_t *fr
 
 FILE *	psf_open_tmpfile (char * fname, size_t fnamelen) ;
 
+/*------------------------------------------------------------------------------------
+** Seek index functions. Implementation in common.c.
+*/
+
+void	psf_seek_index_add (SF_PRIVATE *psf, sf_count_t frame, sf_count_t offset) ;
+const PSF_SEEK_POINT * psf_seek_index_find (const SF_PRIVATE *psf, sf_count_t frame, sf_count_t *next_frame) ;
+void	psf_seek_index_clear (SF_PRIVATE *psf) ;
+int		psf_seek_index_set_sidecar (SF_PRIVATE *psf, int on) ;
+void	psf_seek_index_close (SF_PRIVATE *psf) ;
+
 /*------------------------------------------------------------------------------------
 ** Helper/debug functions.
 */
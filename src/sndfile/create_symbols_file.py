@@ -79,7 +79,10 @@ ALL_SYMBOLS = (
 	(	"sf_get_chunk_data",	102 ),
 	(	"sf_get_chunk_iterator",	103 ),
 	(	"sf_next_chunk_iterator",	104 ),
-	(	"sf_current_byterate",	110 )
+	(	"sf_current_byterate",	110 ),
+	(	"sf_readf_float_planar",	120 ),
+	(	"sf_writef_float_planar",	121 ),
+	(	"sf_probe",				122 )
 	)
 
 #-------------------------------------------------------------------------------
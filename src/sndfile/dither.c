@@ -19,6 +19,8 @@
 #include	"sfconfig.h"
 
 #include	<stdlib.h>
+#include	<string.h>
+#include	<math.h>
 
 #include	"sndfile.h"
 #include	"sfendian.h"
@@ -56,6 +58,12 @@
 #define	SFE_DITHER_BAD_PTR	666
 #define	SFE_DITHER_BAD_TYPE	667
 
+/* Number of independent generator lanes, so noise generation can be vectorised. */
+#define	DITHER_LANES		16
+
+/* Length of the longest noise shaping filter. */
+#define	DITHER_SHAPE_TAPS	3
+
 typedef struct
 {	int			read_short_dither_bits, read_int_dither_bits ;
 	int			write_short_dither_bits, write_int_dither_bits ;
@@ -72,17 +80,34 @@ typedef struct
 	sf_count_t	(*write_float)	(SF_PRIVATE *psf, const float *ptr, sf_count_t len) ;
 	sf_count_t	(*write_double)	(SF_PRIVATE *psf, const double *ptr, sf_count_t len) ;
 
+	/* Write dither state, set up by dither_write_reset (). */
+	int			write_type ;
+	float		write_level ;
+	const double *write_shape ;
+	uint32_t	rand_state [DITHER_LANES] ;
+	double		shape_error [SF_MAX_CHANNELS][DITHER_SHAPE_TAPS] ;
+
+	float	noise [SF_BUFFER_LEN / sizeof (float)] ;
 	double buffer [SF_BUFFER_LEN / sizeof (double)] ;
 } DITHER_DATA ;
 
+/*
+** Error feedback filters. The quantisation error is fed back through these, so
+** the noise transfer function is 1 - (h0 z^-1 + h1 z^-2 + h2 z^-3).
+*/
+static const double dither_shape_highpass [DITHER_SHAPE_TAPS] = { 1.0, 0.0, 0.0 } ;
+
+/* Wannamaker's 3 tap F-weighted filter. */
+static const double dither_shape_f_weighted [DITHER_SHAPE_TAPS] = { 1.623, -0.982, 0.109 } ;
+
 static sf_count_t dither_read_short		(SF_PRIVATE *psf, short *ptr, sf_count_t len) ;
 static sf_count_t dither_read_int		(SF_PRIVATE *psf, int *ptr, sf_count_t len) ;
 
-static sf_count_t dither_write_short	(SF_PRIVATE *psf, const short *ptr, sf_count_t len) ;
-static sf_count_t dither_write_int		(SF_PRIVATE *psf, const int *ptr, sf_count_t len) ;
 static sf_count_t dither_write_float	(SF_PRIVATE *psf, const float *ptr, sf_count_t len) ;
 static sf_count_t dither_write_double	(SF_PRIVATE *psf, const double *ptr, sf_count_t len) ;
 
+static void dither_write_reset (DITHER_DATA *pdither, const SF_DITHER_INFO *info) ;
+
 int
 dither_init (SF_PRIVATE *psf, int mode)
 {	DITHER_DATA *pdither ;
@@ -155,34 +180,24 @@ dither_init (SF_PRIVATE *psf, int mode)
 		if (pdither == NULL)
 			return SFE_MALLOC_FAILED ;
 
-		switch (SF_CODEC (psf->sf.format))
-		{	case SF_FORMAT_DOUBLE :
-			case SF_FORMAT_FLOAT :
-					pdither->write_int = psf->write_int ;
-					psf->write_int = dither_write_int ;
-					break ;
-
-			case SF_FORMAT_PCM_32 :
-			case SF_FORMAT_PCM_24 :
-			case SF_FORMAT_PCM_16 :
-			case SF_FORMAT_PCM_S8 :
-			case SF_FORMAT_PCM_U8 :
-					break ;
-
-			default : break ;
+		/*
+		** Only the float and double writers are wrapped, short and int writes
+		** are never dithered. Each write then asks dither_range () whether
+		** the output is integer PCM or DPCM, and passes float, double and the
+		** other codecs straight through.
+		** Don't wrap the writers twice if dither is set again.
+		*/
+		if (psf->write_float != dither_write_float)
+		{	pdither->write_float = psf->write_float ;
+			psf->write_float = dither_write_float ;
 			} ;
 
-		pdither->write_short = psf->write_short ;
-		psf->write_short = dither_write_short ;
-
-		pdither->write_int = psf->write_int ;
-		psf->write_int = dither_write_int ;
-
-		pdither->write_float = psf->write_float ;
-		psf->write_float = dither_write_float ;
+		if (psf->write_double != dither_write_double)
+		{	pdither->write_double = psf->write_double ;
+			psf->write_double = dither_write_double ;
+			} ;
 
-		pdither->write_double = psf->write_double ;
-		psf->write_double = dither_write_double ;
+		dither_write_reset (pdither, &psf->write_dither) ;
 		} ;
 
 	return 0 ;
@@ -191,11 +206,8 @@ dither_init (SF_PRIVATE *psf, int mode)
 /*==============================================================================
 */
 
-static void dither_short	(const short *in, short *out, int frames, int channels) ;
-static void dither_int		(const int *in, int *out, int frames, int channels) ;
-
-static void dither_float	(const float *in, float *out, int frames, int channels) ;
-static void dither_double	(const double *in, double *out, int frames, int channels) ;
+static void dither_float		(DITHER_DATA *pdither, const float *in, float *out, int frames, int channels, double normfact, double minimum, double maximum) ;
+static void dither_double	(DITHER_DATA *pdither, const double *in, double *out, int frames, int channels, double normfact, double minimum, double maximum) ;
 
 static sf_count_t
 dither_read_short (SF_PRIVATE * UNUSED (psf), short * UNUSED (ptr), sf_count_t len)
@@ -212,96 +224,93 @@ dither_read_int (SF_PRIVATE * UNUSED (psf), int * UNUSED (ptr), sf_count_t len)
 /*------------------------------------------------------------------------------
 */
 
-static sf_count_t
-dither_write_short	(SF_PRIVATE *psf, const short *ptr, sf_count_t len)
-{	DITHER_DATA *pdither ;
-	int			bufferlen, writecount, thiswrite ;
-	sf_count_t	total = 0 ;
+static void
+dither_write_reset (DITHER_DATA *pdither, const SF_DITHER_INFO *info)
+{	int lane ;
 
-	if ((pdither = psf->dither) == NULL)
-	{	psf->error = SFE_DITHER_BAD_PTR ;
-		return 0 ;
-		} ;
+	pdither->write_type = info->type & ~SFD_CUSTOM_LEVEL ;
+	pdither->write_level = (info->type & SFD_CUSTOM_LEVEL) ? info->level : 1.0 ;
 
-	switch (SF_CODEC (psf->sf.format))
-	{	case SF_FORMAT_PCM_S8 :
-		case SF_FORMAT_PCM_U8 :
-		case SF_FORMAT_DPCM_8 :
+	switch (pdither->write_type)
+	{	case SFD_SHAPED_HIGHPASS :
+				pdither->write_shape = dither_shape_highpass ;
 				break ;
 
-		default :
-			return pdither->write_short (psf, ptr, len) ;
-		} ;
-
-	bufferlen = sizeof (pdither->buffer) / sizeof (short) ;
-
-	while (len > 0)
-	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
-		writecount /= psf->sf.channels ;
-		writecount *= psf->sf.channels ;
-
-		dither_short (ptr, (short*) pdither->buffer, writecount / psf->sf.channels, psf->sf.channels) ;
+		case SFD_SHAPED_F_WEIGHTED :
+				pdither->write_shape = dither_shape_f_weighted ;
+				break ;
 
-		thiswrite = pdither->write_short (psf, (short*) pdither->buffer, writecount) ;
-		total += thiswrite ;
-		len -= thiswrite ;
-		if (thiswrite < writecount)
-			break ;
+		default :
+				pdither->write_shape = NULL ;
+				break ;
 		} ;
 
-	return total ;
-} /* dither_write_short */
+	/* Fixed seeds, so the same input always gives the same output. */
+	for (lane = 0 ; lane < DITHER_LANES ; lane++)
+		pdither->rand_state [lane] = 0x9E3779B9u * (lane + 1) ;
 
-static sf_count_t
-dither_write_int	(SF_PRIVATE *psf, const int *ptr, sf_count_t len)
-{	DITHER_DATA *pdither ;
-	int			bufferlen, writecount, thiswrite ;
-	sf_count_t	total = 0 ;
+	memset (pdither->shape_error, 0, sizeof (pdither->shape_error)) ;
+} /* dither_write_reset */
 
-	if ((pdither = psf->dither) == NULL)
-	{	psf->error = SFE_DITHER_BAD_PTR ;
-		return 0 ;
-		} ;
+/*
+** Returns how many input units make up one LSB of the output, mirroring the
+** normalisation factors of the converters dither is applied in front of, and
+** sets the range of the output's integers. Dither can push a full scale
+** sample one LSB past it, and the converters without clipping would wrap it
+** around. Returns 0 if the output format doesn't need dither.
+*/
+static double
+dither_range (SF_PRIVATE *psf, int normalize, double *minimum, double *maximum)
+{	double	scale ;
+	int		bits ;
 
 	switch (SF_CODEC (psf->sf.format))
 	{	case SF_FORMAT_PCM_S8 :
 		case SF_FORMAT_PCM_U8 :
+				bits = 8 ;
+				break ;
+
 		case SF_FORMAT_PCM_16 :
+				bits = 16 ;
+				break ;
+
 		case SF_FORMAT_PCM_24 :
+				bits = 24 ;
+				break ;
+
+		case SF_FORMAT_PCM_32 :
+				bits = 32 ;
 				break ;
 
 		case SF_FORMAT_DPCM_8 :
+				*minimum = -128.0 ;
+				*maximum = 127.0 ;
+				return normalize ? (1.0 * 0x7F) : 1.0 ;
+
 		case SF_FORMAT_DPCM_16 :
-				break ;
+				*minimum = -32768.0 ;
+				*maximum = 32767.0 ;
+				return normalize ? (1.0 * 0x7FFF) : 1.0 ;
 
 		default :
-			return pdither->write_int (psf, ptr, len) ;
+			return 0.0 ;
 		} ;
 
+	scale = ldexp (1.0, bits - 1) ;
+	*minimum = -scale ;
+	*maximum = scale - 1.0 ;
 
-	bufferlen = sizeof (pdither->buffer) / sizeof (int) ;
-
-	while (len > 0)
-	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
-		writecount /= psf->sf.channels ;
-		writecount *= psf->sf.channels ;
-
-		dither_int (ptr, (int*) pdither->buffer, writecount / psf->sf.channels, psf->sf.channels) ;
-
-		thiswrite = pdither->write_int (psf, (int*) pdither->buffer, writecount) ;
-		total += thiswrite ;
-		len -= thiswrite ;
-		if (thiswrite < writecount)
-			break ;
-		} ;
+	if (normalize == SF_FALSE)
+		return 1.0 ;
 
-	return total ;
-} /* dither_write_int */
+	return psf->add_clipping ? scale : scale - 1.0 ;
+} /* dither_range */
 
 static sf_count_t
 dither_write_float	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 {	DITHER_DATA *pdither ;
 	int			bufferlen, writecount, thiswrite ;
+	double		normfact, minimum, maximum ;
 	sf_count_t	total = 0 ;
 
 	if ((pdither = psf->dither) == NULL)
@@ -309,32 +318,23 @@ dither_write_float	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 		return 0 ;
 		} ;
 
-	switch (SF_CODEC (psf->sf.format))
-	{	case SF_FORMAT_PCM_S8 :
-		case SF_FORMAT_PCM_U8 :
-		case SF_FORMAT_PCM_16 :
-		case SF_FORMAT_PCM_24 :
-				break ;
-
-		case SF_FORMAT_DPCM_8 :
-		case SF_FORMAT_DPCM_16 :
-				break ;
-
-		default :
-			return pdither->write_float (psf, ptr, len) ;
-		} ;
+	if ((normfact = dither_range (psf, psf->norm_float, &minimum, &maximum)) <= 0.0)
+		return pdither->write_float (psf, ptr, len) ;
 
 	bufferlen = sizeof (pdither->buffer) / sizeof (float) ;
 
 	while (len > 0)
-	{	writecount = (len >= bufferlen) ? bufferlen : (float) len ;
+	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
 		writecount /= psf->sf.channels ;
 		writecount *= psf->sf.channels ;
+		if (writecount <= 0)
+			break ;
 
-		dither_float (ptr, (float*) pdither->buffer, writecount / psf->sf.channels, psf->sf.channels) ;
+		dither_float (pdither, ptr, (float*) pdither->buffer, writecount / psf->sf.channels, psf->sf.channels, normfact, minimum, maximum) ;
 
 		thiswrite = pdither->write_float (psf, (float*) pdither->buffer, writecount) ;
 		total += thiswrite ;
+		ptr += thiswrite ;
 		len -= thiswrite ;
 		if (thiswrite < writecount)
 			break ;
@@ -347,6 +347,7 @@ static sf_count_t
 dither_write_double	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 {	DITHER_DATA *pdither ;
 	int			bufferlen, writecount, thiswrite ;
+	double		normfact, minimum, maximum ;
 	sf_count_t	total = 0 ;
 
 	if ((pdither = psf->dither) == NULL)
@@ -354,33 +355,23 @@ dither_write_double	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 		return 0 ;
 		} ;
 
-	switch (SF_CODEC (psf->sf.format))
-	{	case SF_FORMAT_PCM_S8 :
-		case SF_FORMAT_PCM_U8 :
-		case SF_FORMAT_PCM_16 :
-		case SF_FORMAT_PCM_24 :
-				break ;
-
-		case SF_FORMAT_DPCM_8 :
-		case SF_FORMAT_DPCM_16 :
-				break ;
-
-		default :
-			return pdither->write_double (psf, ptr, len) ;
-		} ;
-
+	if ((normfact = dither_range (psf, psf->norm_double, &minimum, &maximum)) <= 0.0)
+		return pdither->write_double (psf, ptr, len) ;
 
 	bufferlen = sizeof (pdither->buffer) / sizeof (double) ;
 
 	while (len > 0)
-	{	writecount = (len >= bufferlen) ? bufferlen : (double) len ;
+	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
 		writecount /= psf->sf.channels ;
 		writecount *= psf->sf.channels ;
+		if (writecount <= 0)
+			break ;
 
-		dither_double (ptr, (double*) pdither->buffer, writecount / psf->sf.channels, psf->sf.channels) ;
+		dither_double (pdither, ptr, (double*) pdither->buffer, writecount / psf->sf.channels, psf->sf.channels, normfact, minimum, maximum) ;
 
 		thiswrite = pdither->write_double (psf, (double*) pdither->buffer, writecount) ;
 		total += thiswrite ;
+		ptr += thiswrite ;
 		len -= thiswrite ;
 		if (thiswrite < writecount)
 			break ;
@@ -392,44 +383,241 @@ dither_write_double	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 /*==============================================================================
 */
 
+/*
+** Fills noise with count dither values in LSB units. Each lane is an
+** independent xorshift32 generator, and the lanes don't depend on each
+** other, so the compiler is free to vectorise the inner loops.
+*/
 static void
-dither_short (const short *in, short *out, int frames, int channels)
-{	int ch, k ;
+dither_noise (DITHER_DATA *pdither, float *noise, int count)
+{	uint32_t	state [DITHER_LANES], x ;
+	float		scale ;
+	int			k, lane ;
+
+	memcpy (state, pdither->rand_state, sizeof (state)) ;
+	scale = pdither->write_level / 65536.0f ;
+
+	if (pdither->write_type == SFD_WHITE)
+	{	/* Rectangular PDF, +/- 0.5 LSB. */
+		for (k = 0 ; k < count ; k += DITHER_LANES)
+			for (lane = 0 ; lane < DITHER_LANES ; lane++)
+			{	x = state [lane] ;
+				x ^= x << 13 ;
+				x ^= x >> 17 ;
+				x ^= x << 5 ;
+				state [lane] = x ;
+				noise [k + lane] = ((int) (x >> 16) - 0x8000) * scale ;
+				} ;
+		}
+	else
+	{	/* Triangular PDF, +/- 1 LSB, as the difference of two uniform values. */
+		for (k = 0 ; k < count ; k += DITHER_LANES)
+			for (lane = 0 ; lane < DITHER_LANES ; lane++)
+			{	x = state [lane] ;
+				x ^= x << 13 ;
+				x ^= x >> 17 ;
+				x ^= x << 5 ;
+				state [lane] = x ;
+				noise [k + lane] = ((int) (x >> 16) - (int) (x & 0xFFFF)) * scale ;
+				} ;
+		} ;
 
-	for (ch = 0 ; ch < channels ; ch++)
-		for (k = ch ; k < channels * frames ; k += channels)
-			out [k] = in [k] ;
+	memcpy (pdither->rand_state, state, sizeof (state)) ;
+} /* dither_noise */
 
-} /* dither_short */
+/*
+** Flat (unshaped) dither with the noise generated in the same pass as the
+** add, four lanes to a register. Generating it into pdither->noise first
+** and adding it in a second loop costs about twice as much, because the
+** compiler can't prove in, out and noise don't overlap and won't vectorise
+** the add. Both clamp to [lo, hi] like the scalar loops and return how many
+** samples they did, a multiple of DITHER_LANES, and the lanes advance
+** exactly as dither_noise () would have advanced them, so the output is the
+** same as the scalar path.
+*/
 
-static void
-dither_int (const int *in, int *out, int frames, int channels)
-{	int ch, k ;
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+#define	DITHER_X86_SIMD	1
+#else
+#define	DITHER_X86_SIMD	0
+#endif
 
-	for (ch = 0 ; ch < channels ; ch++)
-		for (k = ch ; k < channels * frames ; k += channels)
-			out [k] = in [k] ;
+#if DITHER_X86_SIMD
+
+#include <immintrin.h>
+
+#define	DITHER_TARGET_SSE2	__attribute__ ((target ("sse2")))
+
+/* Advances a register of lanes and returns their noise, scaled by scale. */
+static inline DITHER_TARGET_SSE2 __m128
+dither_noise_sse2 (__m128i *state, int white, __m128 scale)
+{	__m128i x = *state, value ;
+
+	x = _mm_xor_si128 (x, _mm_slli_epi32 (x, 13)) ;
+	x = _mm_xor_si128 (x, _mm_srli_epi32 (x, 17)) ;
+	x = _mm_xor_si128 (x, _mm_slli_epi32 (x, 5)) ;
+	*state = x ;
+
+	if (white)
+		value = _mm_sub_epi32 (_mm_srli_epi32 (x, 16), _mm_set1_epi32 (0x8000)) ;
+	else
+		value = _mm_sub_epi32 (_mm_srli_epi32 (x, 16), _mm_and_si128 (x, _mm_set1_epi32 (0xFFFF))) ;
+
+	return _mm_mul_ps (_mm_cvtepi32_ps (value), scale) ;
+} /* dither_noise_sse2 */
+
+static DITHER_TARGET_SSE2 int
+dither_float_sse2 (DITHER_DATA *pdither, const float *in, float *out, int count, double normfact, float lo, float hi)
+{	__m128i	state [DITHER_LANES / 4] ;
+	__m128	scale, rescale, low, high, value ;
+	int		white, k, reg ;
+
+	for (reg = 0 ; reg < DITHER_LANES / 4 ; reg++)
+		state [reg] = _mm_loadu_si128 ((const __m128i *) (pdither->rand_state + 4 * reg)) ;
+	scale = _mm_set1_ps (pdither->write_level / 65536.0f) ;
+	rescale = _mm_set1_ps (1.0 / normfact) ;
+	low = _mm_set1_ps (lo) ;
+	high = _mm_set1_ps (hi) ;
+	white = pdither->write_type == SFD_WHITE ;
+
+	for (k = 0 ; k + DITHER_LANES <= count ; k += DITHER_LANES)
+		for (reg = 0 ; reg < DITHER_LANES / 4 ; reg++)
+		{	value = _mm_add_ps (_mm_loadu_ps (in + k + 4 * reg),
+						_mm_mul_ps (dither_noise_sse2 (state + reg, white, scale), rescale)) ;
+			_mm_storeu_ps (out + k + 4 * reg, _mm_min_ps (_mm_max_ps (value, low), high)) ;
+			} ;
 
-} /* dither_int */
+	for (reg = 0 ; reg < DITHER_LANES / 4 ; reg++)
+		_mm_storeu_si128 ((__m128i *) (pdither->rand_state + 4 * reg), state [reg]) ;
+
+	return k ;
+} /* dither_float_sse2 */
+
+static DITHER_TARGET_SSE2 int
+dither_double_sse2 (DITHER_DATA *pdither, const double *in, double *out, int count, double normfact, double lo, double hi)
+{	__m128i	state [DITHER_LANES / 4] ;
+	__m128	scale, noise ;
+	__m128d	rescale, low, high, value ;
+	int		white, k, reg ;
+	double	*dest ;
+
+	for (reg = 0 ; reg < DITHER_LANES / 4 ; reg++)
+		state [reg] = _mm_loadu_si128 ((const __m128i *) (pdither->rand_state + 4 * reg)) ;
+	scale = _mm_set1_ps (pdither->write_level / 65536.0f) ;
+	rescale = _mm_set1_pd (1.0 / normfact) ;
+	low = _mm_set1_pd (lo) ;
+	high = _mm_set1_pd (hi) ;
+	white = pdither->write_type == SFD_WHITE ;
+
+	for (k = 0 ; k + DITHER_LANES <= count ; k += DITHER_LANES)
+		for (reg = 0 ; reg < DITHER_LANES / 4 ; reg++)
+		{	noise = dither_noise_sse2 (state + reg, white, scale) ;
+			dest = out + k + 4 * reg ;
+			value = _mm_add_pd (_mm_loadu_pd (in + k + 4 * reg), _mm_mul_pd (_mm_cvtps_pd (noise), rescale)) ;
+			_mm_storeu_pd (dest, _mm_min_pd (_mm_max_pd (value, low), high)) ;
+			value = _mm_add_pd (_mm_loadu_pd (in + k + 4 * reg + 2),
+						_mm_mul_pd (_mm_cvtps_pd (_mm_movehl_ps (noise, noise)), rescale)) ;
+			_mm_storeu_pd (dest + 2, _mm_min_pd (_mm_max_pd (value, low), high)) ;
+			} ;
 
-static void
-dither_float (const float *in, float *out, int frames, int channels)
-{	int ch, k ;
+	for (reg = 0 ; reg < DITHER_LANES / 4 ; reg++)
+		_mm_storeu_si128 ((__m128i *) (pdither->rand_state + 4 * reg), state [reg]) ;
 
-	for (ch = 0 ; ch < channels ; ch++)
-		for (k = ch ; k < channels * frames ; k += channels)
-			out [k] = in [k] ;
+	return k ;
+} /* dither_double_sse2 */
 
-} /* dither_float */
+#endif /* DITHER_X86_SIMD */
 
 static void
-dither_double (const double *in, double *out, int frames, int channels)
-{	int ch, k ;
+dither_float (DITHER_DATA *pdither, const float *in, float *out, int frames, int channels, double normfact, double minimum, double maximum)
+{	const double *shape = pdither->write_shape ;
+	const float	*noise = pdither->noise ;
+	double		*error, target, quantized ;
+	float		scale, value, lo, hi ;
+	int			ch, k, count ;
+
+	count = frames * channels ;
+
+	if (shape == NULL)
+	{	/*
+		** The converter rounds to the output's LSB, so adding the noise is
+		** enough, kept within the range the converter rounds into.
+		*/
+		lo = minimum / normfact ;
+		hi = maximum / normfact ;
+		k = 0 ;
+#if DITHER_X86_SIMD
+		if (__builtin_cpu_supports ("sse2"))
+			k = dither_float_sse2 (pdither, in, out, count, normfact, lo, hi) ;
+#endif
+		dither_noise (pdither, pdither->noise, count - k) ;
+		scale = 1.0 / normfact ;
+		for ( ; k < count ; k++, noise++)
+		{	value = in [k] + noise [0] * scale ;
+			out [k] = value < lo ? lo : (value > hi ? hi : value) ;
+			} ;
+		return ;
+		} ;
 
-	for (ch = 0 ; ch < channels ; ch++)
-		for (k = ch ; k < channels * frames ; k += channels)
-			out [k] = in [k] ;
+	dither_noise (pdither, pdither->noise, count) ;
+
+	/*
+	** Noise shaping needs the actual quantisation error, so the quantisation
+	** is done here and the converter gets values that are already on its grid.
+	** The bounds are integers, so clamping after rounding gives the same
+	** sample as clamping before it. The error fed back is the one before the
+	** clamp, so a run of full scale samples can't wind up the filter.
+	*/
+	for (k = 0 ; k < count ; k += channels)
+		for (ch = 0 ; ch < channels ; ch++)
+		{	error = pdither->shape_error [ch] ;
+			target = in [k + ch] * normfact - (shape [0] * error [0] + shape [1] * error [1] + shape [2] * error [2]) ;
+			quantized = lrint (target + noise [k + ch]) ;
+			error [2] = error [1] ;
+			error [1] = error [0] ;
+			error [0] = quantized - target ;
+			out [k + ch] = (quantized < minimum ? minimum : (quantized > maximum ? maximum : quantized)) / normfact ;
+			} ;
+} /* dither_float */
+
+static void
+dither_double (DITHER_DATA *pdither, const double *in, double *out, int frames, int channels, double normfact, double minimum, double maximum)
+{	const double *shape = pdither->write_shape ;
+	const float	*noise = pdither->noise ;
+	double		*error, target, quantized, scale, value, lo, hi ;
+	int			ch, k, count ;
+
+	count = frames * channels ;
+
+	if (shape == NULL)
+	{	lo = minimum / normfact ;
+		hi = maximum / normfact ;
+		k = 0 ;
+#if DITHER_X86_SIMD
+		if (__builtin_cpu_supports ("sse2"))
+			k = dither_double_sse2 (pdither, in, out, count, normfact, lo, hi) ;
+#endif
+		dither_noise (pdither, pdither->noise, count - k) ;
+		scale = 1.0 / normfact ;
+		for ( ; k < count ; k++, noise++)
+		{	value = in [k] + noise [0] * scale ;
+			out [k] = value < lo ? lo : (value > hi ? hi : value) ;
+			} ;
+		return ;
+		} ;
 
+	dither_noise (pdither, pdither->noise, count) ;
+
+	for (k = 0 ; k < count ; k += channels)
+		for (ch = 0 ; ch < channels ; ch++)
+		{	error = pdither->shape_error [ch] ;
+			target = in [k + ch] * normfact - (shape [0] * error [0] + shape [1] * error [1] + shape [2] * error [2]) ;
+			quantized = lrint (target + noise [k + ch]) ;
+			error [2] = error [1] ;
+			error [1] = error [0] ;
+			error [0] = quantized - target ;
+			out [k + ch] = (quantized < minimum ? minimum : (quantized > maximum ? maximum : quantized)) / normfact ;
+			} ;
 } /* dither_double */
 
 /*==============================================================================
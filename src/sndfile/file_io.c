@@ -72,10 +72,31 @@ static void psf_log_syserr (SF_PRIVATE *psf, int error) ;
 ** Win32 stuff at the bottom of the file. Unix and other sensible OSes here.
 */
 
+#if defined (_POSIX_THREADS) && (_POSIX_THREADS > 0)
+#define	PSF_ASYNC_IO	1
+#include <pthread.h>
+#else
+#define	PSF_ASYNC_IO	0
+#endif
+
 static int psf_close_fd (int fd) ;
 static int psf_open_fd (PSF_FILE * pfile) ;
 static sf_count_t psf_get_filelen_fd (int fd) ;
 
+static ssize_t psf_sys_read (SF_PRIVATE *psf, void *ptr, size_t count) ;
+static ssize_t psf_sys_write (SF_PRIVATE *psf, const void *ptr, size_t count) ;
+static sf_count_t psf_sys_lseek (SF_PRIVATE *psf, sf_count_t offset, int whence) ;
+
+static int psf_io_begin (SF_PRIVATE *psf, int state) ;
+static int psf_io_idle (SF_PRIVATE *psf) ;
+static sf_count_t psf_io_read (SF_PRIVATE *psf, char *ptr, sf_count_t bytes) ;
+static sf_count_t psf_io_write (SF_PRIVATE *psf, const char *ptr, sf_count_t bytes) ;
+static ssize_t psf_io_fill (SF_PRIVATE *psf, void *ptr, sf_count_t bytes) ;
+
+static int psf_async_fill (SF_PRIVATE *psf, ssize_t *result) ;
+static void psf_async_discard (SF_PRIVATE *psf) ;
+static void psf_async_close (SF_PRIVATE *psf) ;
+
 int
 psf_fopen (SF_PRIVATE *psf)
 {
@@ -101,6 +122,10 @@ psf_fclose (SF_PRIVATE *psf)
 	if (psf->virtual_io)
 		return 0 ;
 
+	/* Anything still sitting in the write buffer has to hit the file first. */
+	psf_io_idle (psf) ;
+	psf_async_close (psf) ;
+
 	if (psf->file.do_not_close_descriptor)
 	{	psf->file.filedes = -1 ;
 		return 0 ;
@@ -174,6 +199,9 @@ psf_get_filelen (SF_PRIVATE *psf)
 	if (psf->virtual_io)
 		return psf->vio.get_filelen (psf->vio_user_data) ;
 
+	if (psf->iobuf.state == PSF_IO_WRITE)
+		psf_io_idle (psf) ;
+
 	filelen = psf_get_filelen_fd (psf->file.filedes) ;
 
 	if (filelen == -1)
@@ -241,6 +269,7 @@ psf_set_stdio (SF_PRIVATE *psf)
 				break ;
 		} ;
 	psf->filelength = 0 ;
+	psf->iobuf.start = -1 ;
 
 	return error ;
 } /* psf_set_stdio */
@@ -248,6 +277,7 @@ psf_set_stdio (SF_PRIVATE *psf)
 void
 psf_set_file (SF_PRIVATE *psf, int fd)
 {	psf->file.filedes = fd ;
+	psf->iobuf.start = -1 ;
 } /* psf_set_file */
 
 int
@@ -286,11 +316,32 @@ psf_fseek (SF_PRIVATE *psf, sf_count_t offset, int whence)
 				return 0 ;
 		} ;
 
-	absolute_position = lseek (psf->file.filedes, offset, whence) ;
+	if (psf->iobuf.state == PSF_IO_READ)
+	{	/* The descriptor is ahead of the logical position, so work from the latter. */
+		if (whence == SEEK_CUR)
+		{	offset += psf->iobuf.start + psf->iobuf.pos ;
+			whence = SEEK_SET ;
+			} ;
+
+		/* Seeks within the read-ahead data don't need a system call. */
+		if (whence == SEEK_SET && offset >= psf->iobuf.start && offset <= psf->iobuf.start + psf->iobuf.fill)
+		{	psf->iobuf.pos = offset - psf->iobuf.start ;
+			return offset - psf->fileoffset ;
+			} ;
+
+		psf->iobuf.state = PSF_IO_IDLE ;
+		psf->iobuf.fill = psf->iobuf.pos = 0 ;
+		}
+	else if (psf->iobuf.state == PSF_IO_WRITE)
+		psf_io_idle (psf) ;
+
+	absolute_position = psf_sys_lseek (psf, offset, whence) ;
 
 	if (absolute_position < 0)
 		psf_log_syserr (psf, errno) ;
 
+	psf->iobuf.start = (absolute_position < 0) ? -1 : absolute_position ;
+
 	return absolute_position - psf->fileoffset ;
 } /* psf_fseek */
 
@@ -308,17 +359,17 @@ psf_fread (void *ptr, sf_count_t bytes, sf_count_t items, SF_PRIVATE *psf)
 	if (items <= 0)
 		return 0 ;
 
+	if (psf_io_begin (psf, PSF_IO_READ) == 0)
+		return psf_io_read (psf, (char*) ptr, items) / bytes ;
+
 	while (items > 0)
 	{	/* Break the read down to a sensible size. */
 		count = (items > SENSIBLE_SIZE) ? SENSIBLE_SIZE : (ssize_t) items ;
 
-		count = read (psf->file.filedes, ((char*) ptr) + total, (size_t) count) ;
+		count = psf_sys_read (psf, ((char*) ptr) + total, (size_t) count) ;
 
 		if (count == -1)
-		{	if (errno == EINTR)
-				continue ;
-
-			psf_log_syserr (psf, errno) ;
+		{	psf_log_syserr (psf, errno) ;
 			break ;
 			} ;
 
@@ -352,17 +403,17 @@ psf_fwrite (const void *ptr, sf_count_t bytes, sf_count_t items, SF_PRIVATE *psf
 	if (items <= 0)
 		return 0 ;
 
+	if (psf_io_begin (psf, PSF_IO_WRITE) == 0)
+		return psf_io_write (psf, (const char*) ptr, items) / bytes ;
+
 	while (items > 0)
 	{	/* Break the writes down to a sensible size. */
 		count = (items > SENSIBLE_SIZE) ? SENSIBLE_SIZE : items ;
 
-		count = write (psf->file.filedes, ((const char*) ptr) + total, count) ;
+		count = psf_sys_write (psf, ((const char*) ptr) + total, count) ;
 
 		if (count == -1)
-		{	if (errno == EINTR)
-				continue ;
-
-			psf_log_syserr (psf, errno) ;
+		{	psf_log_syserr (psf, errno) ;
 			break ;
 			} ;
 
@@ -389,13 +440,26 @@ psf_ftell (SF_PRIVATE *psf)
 	if (psf->is_pipe)
 		return psf->pipeoffset ;
 
-	pos = lseek (psf->file.filedes, 0, SEEK_CUR) ;
+	switch (psf->iobuf.state)
+	{	case PSF_IO_READ :
+			return psf->iobuf.start + psf->iobuf.pos - psf->fileoffset ;
+
+		case PSF_IO_WRITE :
+			return psf->iobuf.start + psf->iobuf.fill - psf->fileoffset ;
+
+		default :
+			break ;
+		} ;
+
+	pos = psf_sys_lseek (psf, 0, SEEK_CUR) ;
 
 	if (pos == ((sf_count_t) -1))
 	{	psf_log_syserr (psf, errno) ;
 		return -1 ;
 		} ;
 
+	psf->iobuf.start = pos ;
+
 	return pos - psf->fileoffset ;
 } /* psf_ftell */
 
@@ -417,14 +481,13 @@ psf_fgets (char *buffer, sf_count_t bufsize, SF_PRIVATE *psf)
 {	sf_count_t	k = 0 ;
 	sf_count_t		count ;
 
+	psf_io_idle (psf) ;
+
 	while (k < bufsize - 1)
-	{	count = read (psf->file.filedes, &(buffer [k]), 1) ;
+	{	count = psf_sys_read (psf, &(buffer [k]), 1) ;
 
 		if (count == -1)
-		{	if (errno == EINTR)
-				continue ;
-
-			psf_log_syserr (psf, errno) ;
+		{	psf_log_syserr (psf, errno) ;
 			break ;
 			} ;
 
@@ -433,6 +496,7 @@ psf_fgets (char *buffer, sf_count_t bufsize, SF_PRIVATE *psf)
 		} ;
 
 	buffer [k] = 0 ;
+	psf->iobuf.start = -1 ;
 
 	return k ;
 } /* psf_fgets */
@@ -487,6 +551,9 @@ psf_ftruncate (SF_PRIVATE *psf, sf_count_t len)
 	if ((sizeof (off_t) < sizeof (sf_count_t)) && len > 0x7FFFFFFF)
 		return -1 ;
 
+	psf_io_idle (psf) ;
+	psf_async_discard (psf) ;
+
 	retval = ftruncate (psf->file.filedes, len) ;
 
 	if (retval == -1)
@@ -500,11 +567,18 @@ psf_init_files (SF_PRIVATE *psf)
 {	psf->file.filedes = -1 ;
 	psf->rsrc.filedes = -1 ;
 	psf->file.savedes = -1 ;
+
+	psf->iobuf.size = SF_IO_BUFFER_LEN ;
+	psf->iobuf.start = -1 ;
 } /* psf_init_files */
 
 void
 psf_use_rsrc (SF_PRIVATE *psf, int on_off)
 {
+	/* The buffer belongs to whichever descriptor is current. */
+	psf_io_idle (psf) ;
+	psf->iobuf.start = -1 ;
+
 	if (on_off)
 	{	if (psf->file.filedes != psf->rsrc.filedes)
 		{	psf->file.savedes = psf->file.filedes ;
@@ -576,14 +650,561 @@ psf_log_syserr (SF_PRIVATE *psf, int error)
 void
 psf_fsync (SF_PRIVATE *psf)
 {
+	psf_io_idle (psf) ;
+
 #if HAVE_FSYNC
 	if (psf->file.mode == SFM_WRITE || psf->file.mode == SFM_RDWR)
 		fsync (psf->file.filedes) ;
-#else
-	psf = NULL ;
 #endif
 } /* psf_fsync */
 
+int
+psf_set_io_buffer (SF_PRIVATE *psf, sf_count_t size)
+{
+	if (psf_io_idle (psf) != 0)
+		return psf->error ;
+
+	/* The background blocks have the old size. */
+	psf_async_close (psf) ;
+
+	free (psf->iobuf.ptr) ;
+	psf->iobuf.ptr = NULL ;
+	psf->iobuf.size = size ;
+
+	return 0 ;
+} /* psf_set_io_buffer */
+
+int
+psf_set_io_readahead (SF_PRIVATE *psf, int blocks)
+{
+#if PSF_ASYNC_IO
+	if (psf_io_idle (psf) != 0)
+		return psf->error ;
+
+	psf_async_close (psf) ;
+	psf->iobuf.ahead = blocks ;
+
+	return 0 ;
+#else
+	return (blocks == 0) ? 0 : SFE_UNIMPLEMENTED ;
+#endif
+} /* psf_set_io_readahead */
+
+/*------------------------------------------------------------------------------
+** System call wrappers. They retry on EINTR and keep the counters returned by
+** SFC_GET_IO_STATS.
+*/
+
+static ssize_t
+psf_sys_read (SF_PRIVATE *psf, void *ptr, size_t count)
+{	ssize_t result ;
+
+	do
+	{	psf->io_stats.read_calls ++ ;
+		result = read (psf->file.filedes, ptr, count) ;
+		}
+	while (result == -1 && errno == EINTR) ;
+
+	if (result > 0)
+		psf->io_stats.bytes_read += result ;
+
+	return result ;
+} /* psf_sys_read */
+
+static ssize_t
+psf_sys_write (SF_PRIVATE *psf, const void *ptr, size_t count)
+{	ssize_t result ;
+
+	do
+	{	psf->io_stats.write_calls ++ ;
+		result = write (psf->file.filedes, ptr, count) ;
+		}
+	while (result == -1 && errno == EINTR) ;
+
+	if (result > 0)
+		psf->io_stats.bytes_written += result ;
+
+	return result ;
+} /* psf_sys_write */
+
+static sf_count_t
+psf_sys_lseek (SF_PRIVATE *psf, sf_count_t offset, int whence)
+{
+	psf->io_stats.seek_calls ++ ;
+	return lseek (psf->file.filedes, offset, whence) ;
+} /* psf_sys_lseek */
+
+/*------------------------------------------------------------------------------
+** Read-ahead/write-behind buffering. Requests smaller than the buffer are
+** served from or collected in it, so a codec reading or writing through its
+** 8k stack buffer (or a header parser reading a few bytes at a time) costs
+** one system call per buffer full instead of one per request. Requests at
+** least as big as the buffer bypass it.
+*/
+
+static int
+psf_io_begin (SF_PRIVATE *psf, int state)
+{	PSF_IO_BUFFER *buf = &psf->iobuf ;
+
+	if (buf->state == state)
+		return 0 ;
+
+	if (buf->size <= 0 || psf->is_pipe || psf_io_idle (psf) != 0)
+		return 1 ;
+
+	if (buf->ptr == NULL && (buf->ptr = malloc ((size_t) buf->size)) == NULL)
+	{	/* Carry on unbuffered. */
+		buf->size = 0 ;
+		return 1 ;
+		} ;
+
+	if (buf->start < 0 && (buf->start = psf_sys_lseek (psf, 0, SEEK_CUR)) < 0)
+	{	buf->start = -1 ;
+		return 1 ;
+		} ;
+
+	/* Blocks read in the background are about to go stale. */
+	if (state == PSF_IO_WRITE)
+		psf_async_discard (psf) ;
+
+	buf->fill = buf->pos = 0 ;
+	buf->fdpos = buf->start ;
+	buf->state = state ;
+
+	return 0 ;
+} /* psf_io_begin */
+
+static int
+psf_io_idle (SF_PRIVATE *psf)
+{	PSF_IO_BUFFER *buf = &psf->iobuf ;
+	sf_count_t	total = 0 ;
+	ssize_t		count ;
+	int			error = 0 ;
+
+	switch (buf->state)
+	{	case PSF_IO_READ :
+			/* Put the descriptor back where the caller thinks it is. */
+			if (buf->start + buf->pos != buf->fdpos && psf_sys_lseek (psf, buf->start + buf->pos, SEEK_SET) < 0)
+			{	psf_log_syserr (psf, errno) ;
+				error = 1 ;
+				break ;
+				} ;
+			buf->start += buf->pos ;
+			break ;
+
+		case PSF_IO_WRITE :
+			while (total < buf->fill)
+			{	count = psf_sys_write (psf, buf->ptr + total, (size_t) (buf->fill - total)) ;
+
+				if (count <= 0)
+				{	psf_log_syserr (psf, count == 0 ? EIO : errno) ;
+					error = 1 ;
+					break ;
+					} ;
+
+				total += count ;
+				} ;
+			buf->start += total ;
+			break ;
+
+		default :
+			return 0 ;
+		} ;
+
+	if (error)
+		buf->start = -1 ;
+
+	buf->state = PSF_IO_IDLE ;
+	buf->fill = buf->pos = 0 ;
+
+	return error ? -1 : 0 ;
+} /* psf_io_idle */
+
+static sf_count_t
+psf_io_read (SF_PRIVATE *psf, char *ptr, sf_count_t bytes)
+{	PSF_IO_BUFFER *buf = &psf->iobuf ;
+	sf_count_t	total = 0, avail ;
+	ssize_t		count ;
+
+	while (bytes > 0)
+	{	avail = buf->fill - buf->pos ;
+
+		if (avail > 0)
+		{	avail = SF_MIN (avail, bytes) ;
+			memcpy (ptr + total, buf->ptr + buf->pos, (size_t) avail) ;
+			buf->pos += avail ;
+			total += avail ;
+			bytes -= avail ;
+			continue ;
+			} ;
+
+		buf->start += buf->fill ;
+		buf->fill = buf->pos = 0 ;
+
+		if (bytes >= buf->size)
+		{	count = psf_io_fill (psf, ptr + total, SF_MIN (bytes, (sf_count_t) SENSIBLE_SIZE)) ;
+			if (count > 0)
+			{	buf->start += count ;
+				total += count ;
+				bytes -= count ;
+				continue ;
+				} ;
+			}
+		else
+		{	if (buf->ahead <= 0 || psf_async_fill (psf, &count) != 0)
+				count = psf_io_fill (psf, buf->ptr, buf->size) ;
+			if (count > 0)
+			{	buf->fill = count ;
+				continue ;
+				} ;
+			} ;
+
+		if (count == -1)
+			psf_log_syserr (psf, errno) ;
+		break ;
+		} ;
+
+	return total ;
+} /* psf_io_read */
+
+static sf_count_t
+psf_io_write (SF_PRIVATE *psf, const char *ptr, sf_count_t bytes)
+{	PSF_IO_BUFFER *buf = &psf->iobuf ;
+	sf_count_t	total = 0 ;
+	ssize_t		count ;
+
+	if (buf->fill + bytes > buf->size)
+	{	/* Make room, psf_io_idle () leaves the descriptor at the logical position. */
+		if (psf_io_idle (psf) != 0 || psf_io_begin (psf, PSF_IO_WRITE) != 0)
+			return 0 ;
+
+		if (bytes >= buf->size)
+		{	while (total < bytes)
+			{	count = psf_sys_write (psf, ptr + total, (size_t) SF_MIN (bytes - total, (sf_count_t) SENSIBLE_SIZE)) ;
+
+				if (count <= 0)
+				{	if (count == -1)
+						psf_log_syserr (psf, errno) ;
+					break ;
+					} ;
+
+				total += count ;
+				} ;
+
+			buf->start += total ;
+			return total ;
+			} ;
+		} ;
+
+	memcpy (buf->ptr + buf->fill, ptr, (size_t) bytes) ;
+	buf->fill += bytes ;
+
+	return bytes ;
+} /* psf_io_write */
+
+static ssize_t
+psf_io_fill (SF_PRIVATE *psf, void *ptr, sf_count_t bytes)
+{	PSF_IO_BUFFER *buf = &psf->iobuf ;
+	ssize_t count ;
+
+#if PSF_ASYNC_IO
+	/* While a worker is reading ahead the descriptor position is left alone. */
+	if (buf->async != NULL)
+	{	do
+		{	psf->io_stats.read_calls ++ ;
+			count = pread (psf->file.filedes, ptr, (size_t) bytes, buf->start) ;
+			}
+		while (count == -1 && errno == EINTR) ;
+
+		if (count > 0)
+			psf->io_stats.bytes_read += count ;
+
+		return count ;
+		} ;
+#endif
+
+	count = psf_sys_read (psf, ptr, (size_t) bytes) ;
+	if (count > 0)
+		buf->fdpos += count ;
+
+	return count ;
+} /* psf_io_fill */
+
+#if PSF_ASYNC_IO
+
+/*------------------------------------------------------------------------------
+** Background read-ahead. With SFC_SET_IO_READAHEAD set to N, a worker thread
+** owned by the SNDFILE keeps the N buffer sized blocks following the current
+** one in flight using pread (), so a refill usually just swaps in a block
+** that was read while the codec was busy decoding the previous one. Blocks
+** that are no longer ahead of the reader are dropped.
+*/
+
+enum
+{	PSF_SLOT_EMPTY = 0,
+	PSF_SLOT_QUEUED,
+	PSF_SLOT_BUSY,
+	PSF_SLOT_DONE
+} ;
+
+typedef struct
+{	unsigned char	*data ;
+	sf_count_t		offset ;
+	ssize_t			result ;
+	int				error ;
+	int				fd ;
+	int				state ;
+} PSF_IO_SLOT ;
+
+struct psf_io_async
+{	pthread_t		thread ;
+	pthread_mutex_t	mutex ;
+	pthread_cond_t	wake, done ;
+	int				running ;
+	size_t			size ;
+	int				count ;
+	PSF_IO_SLOT		slots [] ;
+} ;
+
+static void *
+psf_async_worker (void *data)
+{	struct psf_io_async *async = data ;
+	PSF_IO_SLOT	*slot ;
+	int			k ;
+
+	pthread_mutex_lock (&async->mutex) ;
+
+	while (async->running)
+	{	/* The block closest to the reader goes first. */
+		slot = NULL ;
+		for (k = 0 ; k < async->count ; k++)
+			if (async->slots [k].state == PSF_SLOT_QUEUED && (slot == NULL || async->slots [k].offset < slot->offset))
+				slot = async->slots + k ;
+
+		if (slot == NULL)
+		{	pthread_cond_wait (&async->wake, &async->mutex) ;
+			continue ;
+			} ;
+
+		slot->state = PSF_SLOT_BUSY ;
+		pthread_mutex_unlock (&async->mutex) ;
+
+		do
+			slot->result = pread (slot->fd, slot->data, async->size, slot->offset) ;
+		while (slot->result == -1 && errno == EINTR) ;
+		slot->error = (slot->result == -1) ? errno : 0 ;
+
+		pthread_mutex_lock (&async->mutex) ;
+		slot->state = PSF_SLOT_DONE ;
+		pthread_cond_broadcast (&async->done) ;
+		} ;
+
+	pthread_mutex_unlock (&async->mutex) ;
+
+	return NULL ;
+} /* psf_async_worker */
+
+static struct psf_io_async *
+psf_async_open (SF_PRIVATE *psf)
+{	PSF_IO_BUFFER *buf = &psf->iobuf ;
+	struct psf_io_async *async ;
+	int k ;
+
+	if (buf->async != NULL)
+		return buf->async ;
+
+	if ((async = calloc (1, sizeof (struct psf_io_async) + buf->ahead * sizeof (PSF_IO_SLOT))) == NULL)
+		goto fail ;
+
+	async->size = (size_t) buf->size ;
+	async->count = buf->ahead ;
+	async->running = 1 ;
+
+	for (k = 0 ; k < async->count ; k++)
+		if ((async->slots [k].data = malloc (async->size)) == NULL)
+			goto fail ;
+
+	pthread_mutex_init (&async->mutex, NULL) ;
+	pthread_cond_init (&async->wake, NULL) ;
+	pthread_cond_init (&async->done, NULL) ;
+
+	if (pthread_create (&async->thread, NULL, psf_async_worker, async) != 0)
+	{	pthread_cond_destroy (&async->done) ;
+		pthread_cond_destroy (&async->wake) ;
+		pthread_mutex_destroy (&async->mutex) ;
+		goto fail ;
+		} ;
+
+	return (buf->async = async) ;
+
+fail :
+	/* Carry on reading synchronously. */
+	if (async != NULL)
+		for (k = 0 ; k < async->count ; k++)
+			free (async->slots [k].data) ;
+	free (async) ;
+	buf->ahead = 0 ;
+
+	return NULL ;
+} /* psf_async_open */
+
+/* Called with the mutex held. */
+static void
+psf_async_drop_slot (SF_PRIVATE *psf, struct psf_io_async *async, PSF_IO_SLOT *slot)
+{
+	while (slot->state == PSF_SLOT_BUSY)
+		pthread_cond_wait (&async->done, &async->mutex) ;
+
+	if (slot->state == PSF_SLOT_DONE)
+	{	psf->io_stats.read_calls ++ ;
+		if (slot->result > 0)
+			psf->io_stats.bytes_read += slot->result ;
+		} ;
+
+	slot->state = PSF_SLOT_EMPTY ;
+} /* psf_async_drop_slot */
+
+static int
+psf_async_fill (SF_PRIVATE *psf, ssize_t *result)
+{	PSF_IO_BUFFER *buf = &psf->iobuf ;
+	struct psf_io_async *async ;
+	PSF_IO_SLOT	*slot = NULL ;
+	unsigned char *data ;
+	sf_count_t	offset, end ;
+	int			fd = psf->file.filedes, k, j ;
+
+	if ((async = psf_async_open (psf)) == NULL)
+		return 1 ;
+
+	pthread_mutex_lock (&async->mutex) ;
+
+	for (k = 0 ; k < async->count ; k++)
+		if (async->slots [k].state != PSF_SLOT_EMPTY && async->slots [k].fd == fd && async->slots [k].offset == buf->start)
+			slot = async->slots + k ;
+
+	/* A block the worker hasn't started on yet is quicker to read right here. */
+	if (slot != NULL && slot->state == PSF_SLOT_QUEUED)
+	{	slot->state = PSF_SLOT_EMPTY ;
+		slot = NULL ;
+		} ;
+
+	if (slot != NULL)
+	{	while (slot->state != PSF_SLOT_DONE)
+			pthread_cond_wait (&async->done, &async->mutex) ;
+
+		psf->io_stats.read_calls ++ ;
+		if (slot->result > 0)
+			psf->io_stats.bytes_read += slot->result ;
+
+		*result = slot->result ;
+		if (slot->result == -1)
+			errno = slot->error ;
+
+		/* Hand the finished block to the reader and recycle the old one. */
+		data = buf->ptr ;
+		buf->ptr = slot->data ;
+		slot->data = data ;
+		slot->state = PSF_SLOT_EMPTY ;
+		}
+	else
+	{	pthread_mutex_unlock (&async->mutex) ;
+		*result = psf_io_fill (psf, buf->ptr, buf->size) ;
+		pthread_mutex_lock (&async->mutex) ;
+		} ;
+
+	/* Only a full block means there may be more of the file to read ahead. */
+	end = (*result == buf->size) ? buf->start + async->count * buf->size : buf->start ;
+
+	for (k = 0 ; k < async->count ; k++)
+	{	slot = async->slots + k ;
+		if (slot->state != PSF_SLOT_EMPTY && (slot->fd != fd || slot->offset <= buf->start || slot->offset > end))
+			psf_async_drop_slot (psf, async, slot) ;
+		} ;
+
+	for (offset = buf->start + buf->size ; offset <= end ; offset += buf->size)
+	{	for (k = 0 ; k < async->count ; k++)
+			if (async->slots [k].state != PSF_SLOT_EMPTY && async->slots [k].offset == offset)
+				break ;
+		if (k < async->count)
+			continue ;
+
+		for (j = 0 ; j < async->count ; j++)
+			if (async->slots [j].state == PSF_SLOT_EMPTY)
+			{	async->slots [j].offset = offset ;
+				async->slots [j].fd = fd ;
+				async->slots [j].state = PSF_SLOT_QUEUED ;
+				break ;
+				} ;
+		} ;
+
+	pthread_cond_signal (&async->wake) ;
+	pthread_mutex_unlock (&async->mutex) ;
+
+	return 0 ;
+} /* psf_async_fill */
+
+static void
+psf_async_discard (SF_PRIVATE *psf)
+{	struct psf_io_async *async = psf->iobuf.async ;
+	int k ;
+
+	if (async == NULL)
+		return ;
+
+	pthread_mutex_lock (&async->mutex) ;
+	for (k = 0 ; k < async->count ; k++)
+		if (async->slots [k].state != PSF_SLOT_EMPTY)
+			psf_async_drop_slot (psf, async, async->slots + k) ;
+	pthread_mutex_unlock (&async->mutex) ;
+} /* psf_async_discard */
+
+static void
+psf_async_close (SF_PRIVATE *psf)
+{	struct psf_io_async *async = psf->iobuf.async ;
+	int k ;
+
+	if (async == NULL)
+		return ;
+
+	psf_async_discard (psf) ;
+
+	pthread_mutex_lock (&async->mutex) ;
+	async->running = 0 ;
+	pthread_cond_signal (&async->wake) ;
+	pthread_mutex_unlock (&async->mutex) ;
+
+	pthread_join (async->thread, NULL) ;
+
+	pthread_cond_destroy (&async->done) ;
+	pthread_cond_destroy (&async->wake) ;
+	pthread_mutex_destroy (&async->mutex) ;
+
+	for (k = 0 ; k < async->count ; k++)
+		free (async->slots [k].data) ;
+	free (async) ;
+
+	psf->iobuf.async = NULL ;
+} /* psf_async_close */
+
+#else
+
+static int
+psf_async_fill (SF_PRIVATE * UNUSED (psf), ssize_t * UNUSED (result))
+{	return 1 ;
+} /* psf_async_fill */
+
+static void
+psf_async_discard (SF_PRIVATE * UNUSED (psf))
+{
+} /* psf_async_discard */
+
+static void
+psf_async_close (SF_PRIVATE * UNUSED (psf))
+{
+} /* psf_async_close */
+
+#endif /* PSF_ASYNC_IO */
+
 #elif	USE_WINDOWS_API
 
 /* Win32 file i/o functions implemented using native Win32 API */
@@ -1107,6 +1728,19 @@ psf_fsync (SF_PRIVATE *psf)
 {	FlushFileBuffers (psf->file.handle) ;
 } /* psf_fsync */
 
+/* USE_WINDOWS_API */ int
+psf_set_io_buffer (SF_PRIVATE *psf, sf_count_t size)
+{	/* The Win32 API does its own buffering, i/o here stays unbuffered. */
+	psf->iobuf.size = 0 ;
+	return (size == 0) ? 0 : SFE_UNIMPLEMENTED ;
+} /* psf_set_io_buffer */
+
+/* USE_WINDOWS_API */ int
+psf_set_io_readahead (SF_PRIVATE *psf, int blocks)
+{	psf->iobuf.ahead = 0 ;
+	return (blocks == 0) ? 0 : SFE_UNIMPLEMENTED ;
+} /* psf_set_io_readahead */
+
 
 /* USE_WINDOWS_API */ int
 psf_ftruncate (SF_PRIVATE *psf, sf_count_t len)
@@ -1518,6 +2152,18 @@ psf_ftruncate (SF_PRIVATE *psf, sf_count_t len)
 	return retval ;
 } /* psf_ftruncate */
 
+/* Win32 */ int
+psf_set_io_buffer (SF_PRIVATE *psf, sf_count_t size)
+{	psf->iobuf.size = 0 ;
+	return (size == 0) ? 0 : SFE_UNIMPLEMENTED ;
+} /* psf_set_io_buffer */
+
+/* Win32 */ int
+psf_set_io_readahead (SF_PRIVATE *psf, int blocks)
+{	psf->iobuf.ahead = 0 ;
+	return (blocks == 0) ? 0 : SFE_UNIMPLEMENTED ;
+} /* psf_set_io_readahead */
+
 
 static void
 psf_log_syserr (SF_PRIVATE *psf, int error)
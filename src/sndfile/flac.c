@@ -26,6 +26,10 @@
 #include	<ctype.h>
 #include	<math.h>
 
+#if HAVE_UNISTD_H
+#include	<unistd.h>
+#endif
+
 #include	"sndfile.h"
 #include	"common.h"
 
@@ -35,6 +39,24 @@
 #include	<FLAC/stream_encoder.h>
 #include	<FLAC/metadata.h>
 
+/*
+** libFLAC 1.5 and later can encode frames on a pool of threads itself. With
+** older versions the encoder runs on a single worker thread instead, fed by
+** the caller while it converts the next samples.
+*/
+#if defined (FLAC_API_VERSION_CURRENT) && (FLAC_API_VERSION_CURRENT >= 14)
+#define	FLAC_NATIVE_THREADS	1
+#else
+#define	FLAC_NATIVE_THREADS	0
+#endif
+
+#if (FLAC_NATIVE_THREADS == 0) && defined (_POSIX_THREADS) && (_POSIX_THREADS > 0)
+#define	FLAC_PIPELINE	1
+#include	<pthread.h>
+#else
+#define	FLAC_PIPELINE	0
+#endif
+
 /*------------------------------------------------------------------------------
 ** Private static functions.
 */
@@ -43,6 +65,11 @@
 
 #define ENC_BUFFER_SIZE 8192
 
+#define	FLAC_MAX_ENCODER_THREADS	64
+
+/* Frames handed to the encoder worker at a time. */
+#define	PIPE_FRAMES		16384
+
 typedef enum
 {	PFLAC_PCM_SHORT = 50,
 	PFLAC_PCM_INT = 51,
@@ -70,6 +97,9 @@ typedef struct
 	const FLAC__Frame *frame ;
 
 	unsigned compression ;
+	unsigned threads ;
+
+	struct flac_pipe *pipe ;
 
 } FLAC_PRIVATE ;
 
@@ -79,6 +109,7 @@ typedef struct
 } FLAC_TAG ;
 
 static sf_count_t	flac_seek (SF_PRIVATE *psf, int mode, sf_count_t offset) ;
+static int			flac_seek_indexed (SF_PRIVATE *psf, sf_count_t offset) ;
 static int			flac_byterate (SF_PRIVATE *psf) ;
 static int			flac_close (SF_PRIVATE *psf) ;
 
@@ -110,6 +141,13 @@ static void		d2flac24_clip_array (const double *src, int32_t *dest, int count, i
 
 static int flac_command (SF_PRIVATE *psf, int command, void *data, int datasize) ;
 
+static FLAC__bool	flac_enc_process (SF_PRIVATE *psf, FLAC_PRIVATE *pflac, const int32_t *buffer, unsigned frames) ;
+static int			flac_pipe_open (SF_PRIVATE *psf, FLAC_PRIVATE *pflac) ;
+static int			flac_pipe_close (SF_PRIVATE *psf, FLAC_PRIVATE *pflac) ;
+static FLAC__bool	flac_pipe_push (SF_PRIVATE *psf, struct flac_pipe *pipe, const int32_t *buffer, unsigned frames) ;
+static FLAC__StreamEncoderTellStatus flac_pipe_tell (struct flac_pipe *pipe, FLAC__uint64 *absolute_byte_offset) ;
+static FLAC__StreamEncoderWriteStatus flac_pipe_output (struct flac_pipe *pipe, const FLAC__byte buffer [], size_t bytes) ;
+
 /* Decoder Callbacks */
 static FLAC__StreamDecoderReadStatus sf_flac_read_callback (const FLAC__StreamDecoder *decoder, FLAC__byte buffer [], size_t *bytes, void *client_data) ;
 static FLAC__StreamDecoderSeekStatus sf_flac_seek_callback (const FLAC__StreamDecoder *decoder, FLAC__uint64 absolute_byte_offset, void *client_data) ;
@@ -388,6 +426,12 @@ static FLAC__StreamDecoderWriteStatus
 sf_flac_write_callback (const FLAC__StreamDecoder * UNUSED (decoder), const FLAC__Frame *frame, const int32_t * const buffer [], void *client_data)
 {	SF_PRIVATE *psf = (SF_PRIVATE*) client_data ;
 	FLAC_PRIVATE* pflac = (FLAC_PRIVATE*) psf->codec_data ;
+	FLAC__uint64 position ;
+
+	/* The decoder is now at the start of the next frame, remember where that is. */
+	if (frame->header.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER
+			&& FLAC__stream_decoder_get_decode_position (pflac->fsd, &position))
+		psf_seek_index_add (psf, frame->header.number.sample_number + frame->header.blocksize, position) ;
 
 	pflac->frame = frame ;
 	pflac->bufferpos = 0 ;
@@ -561,6 +605,10 @@ sf_flac_enc_seek_callback (const FLAC__StreamEncoder * UNUSED (encoder), FLAC__u
 static FLAC__StreamEncoderTellStatus
 sf_flac_enc_tell_callback (const FLAC__StreamEncoder *UNUSED (encoder), FLAC__uint64 *absolute_byte_offset, void *client_data)
 {	SF_PRIVATE *psf = (SF_PRIVATE*) client_data ;
+	FLAC_PRIVATE* pflac = (FLAC_PRIVATE*) psf->codec_data ;
+
+	if (pflac->pipe != NULL)
+		return flac_pipe_tell (pflac->pipe, absolute_byte_offset) ;
 
 	*absolute_byte_offset = psf_ftell (psf) ;
 	if (psf->error)
@@ -572,6 +620,11 @@ sf_flac_enc_tell_callback (const FLAC__StreamEncoder *UNUSED (encoder), FLAC__ui
 static FLAC__StreamEncoderWriteStatus
 sf_flac_enc_write_callback (const FLAC__StreamEncoder * UNUSED (encoder), const FLAC__byte buffer [], size_t bytes, unsigned UNUSED (samples), unsigned UNUSED (current_frame), void *client_data)
 {	SF_PRIVATE *psf = (SF_PRIVATE*) client_data ;
+	FLAC_PRIVATE* pflac = (FLAC_PRIVATE*) psf->codec_data ;
+
+	/* The worker must not touch the file, the caller writes its output. */
+	if (pflac->pipe != NULL)
+		return flac_pipe_output (pflac->pipe, buffer, bytes) ;
 
 	if (psf_fwrite (buffer, 1, bytes, psf) == (sf_count_t) bytes && psf->error == 0)
 		return FLAC__STREAM_ENCODER_WRITE_STATUS_OK ;
@@ -665,6 +718,9 @@ flac_write_header (SF_PRIVATE *psf, int UNUSED (calc_length))
 		psf->dataoffset = psf_ftell (psf) ;
 	pflac->encbuffer = calloc (ENC_BUFFER_SIZE, sizeof (int32_t)) ;
 
+	if (psf->error == 0 && pflac->threads > 1)
+		flac_pipe_open (psf, pflac) ;
+
 	/* can only call init_stream once */
 	psf->write_header = NULL ;
 
@@ -752,7 +808,9 @@ flac_close	(SF_PRIVATE *psf)
 		FLAC__metadata_object_delete (pflac->metadata) ;
 
 	if (psf->file.mode == SFM_WRITE)
-	{	FLAC__stream_encoder_finish (pflac->fse) ;
+	{	/* The last frames and the STREAMINFO rewrite happen on this thread. */
+		flac_pipe_close (psf, pflac) ;
+		FLAC__stream_encoder_finish (pflac->fse) ;
 		FLAC__stream_encoder_delete (pflac->fse) ;
 		free (pflac->encbuffer) ;
 		} ;
@@ -829,6 +887,11 @@ flac_enc_init (SF_PRIVATE *psf)
 		return SFE_FLAC_INIT_DECODER ;
 		} ;
 
+#if FLAC_NATIVE_THREADS
+	if (pflac->threads > 1 && FLAC__stream_encoder_set_num_threads (pflac->fse, pflac->threads) != FLAC__STREAM_ENCODER_SET_NUM_THREADS_OK)
+		psf_log_printf (psf, "FLAC__stream_encoder_set_num_threads (%u) failed, encoding on one thread.\n", pflac->threads) ;
+#endif
+
 	return 0 ;
 } /* flac_enc_init */
 
@@ -858,6 +921,10 @@ flac_read_header (SF_PRIVATE *psf)
 
 		FLAC__stream_decoder_get_decode_position (pflac->fsd, &position) ;
 		psf->dataoffset = position ;
+
+		/* Frames are indexed as they are decoded, starting with the first. */
+		psf->seekidx.enabled = SF_TRUE ;
+		psf_seek_index_add (psf, 0, psf->dataoffset) ;
 		} ;
 
 	return psf->error ;
@@ -890,6 +957,23 @@ flac_command (SF_PRIVATE * psf, int command, void * data, int datasize)
 
 			return SF_TRUE ;
 
+		case SFC_SET_ENCODER_THREADS :
+			/* Frames are encoded in the same order either way, so the output doesn't change. */
+			if (psf->file.mode != SFM_WRITE || psf->have_written || datasize < 0 || datasize > FLAC_MAX_ENCODER_THREADS)
+				return SF_FALSE ;
+
+			if (FLAC_NATIVE_THREADS == 0 && FLAC_PIPELINE == 0 && datasize > 1)
+				return SF_FALSE ;
+
+			pflac->threads = datasize ;
+
+			psf_log_printf (psf, "%s : Setting SFC_SET_ENCODER_THREADS to %u.\n", __func__, pflac->threads) ;
+
+			if (flac_enc_init (psf))
+				return SF_FALSE ;
+
+			return SF_TRUE ;
+
 		default :
 			return SF_FALSE ;
 		} ;
@@ -1072,7 +1156,7 @@ flac_write_s2flac (SF_PRIVATE *psf, const short *ptr, sf_count_t len)
 	while (len > 0)
 	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
 		convert (ptr + total, buffer, writecount) ;
-		if (FLAC__stream_encoder_process_interleaved (pflac->fse, buffer, writecount / psf->sf.channels))
+		if (flac_enc_process (psf, pflac, buffer, writecount / psf->sf.channels))
 			thiswrite = writecount ;
 		else
 			break ;
@@ -1114,7 +1198,7 @@ flac_write_i2flac (SF_PRIVATE *psf, const int *ptr, sf_count_t len)
 	while (len > 0)
 	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
 		convert (ptr + total, buffer, writecount) ;
-		if (FLAC__stream_encoder_process_interleaved (pflac->fse, buffer, writecount / psf->sf.channels))
+		if (flac_enc_process (psf, pflac, buffer, writecount / psf->sf.channels))
 			thiswrite = writecount ;
 		else
 			break ;
@@ -1156,7 +1240,7 @@ flac_write_f2flac (SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 	while (len > 0)
 	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
 		convert (ptr + total, buffer, writecount, psf->norm_float) ;
-		if (FLAC__stream_encoder_process_interleaved (pflac->fse, buffer, writecount / psf->sf.channels))
+		if (flac_enc_process (psf, pflac, buffer, writecount / psf->sf.channels))
 			thiswrite = writecount ;
 		else
 			break ;
@@ -1287,7 +1371,7 @@ flac_write_d2flac (SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	while (len > 0)
 	{	writecount = (len >= bufferlen) ? bufferlen : (int) len ;
 		convert (ptr + total, buffer, writecount, psf->norm_double) ;
-		if (FLAC__stream_encoder_process_interleaved (pflac->fse, buffer, writecount / psf->sf.channels))
+		if (flac_enc_process (psf, pflac, buffer, writecount / psf->sf.channels))
 			thiswrite = writecount ;
 		else
 			break ;
@@ -1391,6 +1475,50 @@ d2flac24_array (const double *src, int32_t *dest, int count, int normalize)
 		dest [count] = lrint (src [count] * normfact) ;
 } /* d2flac24_array */
 
+static int
+flac_seek_indexed (SF_PRIVATE *psf, sf_count_t offset)
+{	FLAC_PRIVATE* pflac = (FLAC_PRIVATE*) psf->codec_data ;
+	const PSF_SEEK_POINT *point ;
+	sf_count_t next, frame ;
+
+	if (offset >= psf->sf.frames || (point = psf_seek_index_find (psf, offset, &next)) == NULL)
+		return SF_FALSE ;
+
+	/* Beyond the last known frame libFLAC's own search is quicker. */
+	if (next < 0 && offset - point->frame >= FLAC__MAX_BLOCK_SIZE)
+		return SF_FALSE ;
+
+	if (FLAC__stream_decoder_flush (pflac->fsd) == 0 || psf_fseek (psf, point->offset, SEEK_SET) != point->offset)
+		return SF_FALSE ;
+
+	/*
+	** Decode into the frame buffer from the recorded position. A point
+	** almost always starts the frame holding offset, but the index may
+	** have gaps so keep going until it is reached.
+	*/
+	pflac->ptr = NULL ;
+	frame = point->frame ;
+	do
+	{	pflac->frame = NULL ;
+		if (FLAC__stream_decoder_process_single (pflac->fsd) == 0 || pflac->frame == NULL)
+			return SF_FALSE ;
+
+		/* A stale point lands on the wrong frame, let the caller search instead. */
+		if (pflac->frame->header.number_type != FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER
+				|| (sf_count_t) pflac->frame->header.number.sample_number != frame)
+		{	psf_seek_index_clear (psf) ;
+			return SF_FALSE ;
+			} ;
+
+		frame += pflac->frame->header.blocksize ;
+		}
+	while (frame <= offset) ;
+
+	pflac->bufferpos = offset - pflac->frame->header.number.sample_number ;
+
+	return SF_TRUE ;
+} /* flac_seek_indexed */
+
 static sf_count_t
 flac_seek (SF_PRIVATE *psf, int UNUSED (mode), sf_count_t offset)
 {	FLAC_PRIVATE* pflac = (FLAC_PRIVATE*) psf->codec_data ;
@@ -1406,7 +1534,12 @@ flac_seek (SF_PRIVATE *psf, int UNUSED (mode), sf_count_t offset)
 	pflac->frame = NULL ;
 
 	if (psf->file.mode == SFM_READ)
-	{	if (FLAC__stream_decoder_seek_absolute (pflac->fsd, offset))
+	{	if (flac_seek_indexed (psf, offset))
+			return offset ;
+
+		pflac->frame = NULL ;
+
+		if (FLAC__stream_decoder_seek_absolute (pflac->fsd, offset))
 			return offset ;
 
 		if (offset == psf->sf.frames)
@@ -1437,6 +1570,293 @@ flac_byterate (SF_PRIVATE *psf)
 	return -1 ;
 } /* flac_byterate */
 
+static FLAC__bool
+flac_enc_process (SF_PRIVATE *psf, FLAC_PRIVATE *pflac, const int32_t *buffer, unsigned frames)
+{
+	if (pflac->pipe != NULL)
+		return flac_pipe_push (psf, pflac->pipe, buffer, frames) ;
+
+	return FLAC__stream_encoder_process_interleaved (pflac->fse, buffer, frames) ;
+} /* flac_enc_process */
+
+#if FLAC_PIPELINE
+
+/*------------------------------------------------------------------------------
+** Encoder pipeline. The caller converts samples into one of two buffers of
+** PIPE_FRAMES frames while a worker thread runs the encoder on the other.
+** The encoder sees the same samples in the same order as when it runs on
+** the caller's thread, so the output is identical. The worker never touches
+** the file : encoded bytes are queued and written out by the caller.
+*/
+
+struct flac_pipe
+{	FLAC_PRIVATE	*pflac ;
+	unsigned		channels ;
+
+	pthread_t		thread ;
+	pthread_mutex_t	mutex ;
+	pthread_cond_t	cond ;
+	int				running, busy, failed ;
+
+	int32_t			*pcm [2] ;
+	unsigned		frames [2] ;
+	int				fill, queued ;
+
+	/* out [0] is filled by the worker, out [1] is written by the caller. */
+	FLAC__byte		*out [2] ;
+	size_t			outlen [2], outsize [2] ;
+	FLAC__uint64	position ;
+} ;
+
+static void *
+flac_pipe_worker (void *data)
+{	struct flac_pipe *pipe = data ;
+	FLAC__bool ok ;
+	int k ;
+
+	pthread_mutex_lock (&pipe->mutex) ;
+
+	for ( ; ; )
+	{	while (pipe->queued < 0 && pipe->running)
+			pthread_cond_wait (&pipe->cond, &pipe->mutex) ;
+
+		if (pipe->queued < 0)
+			break ;
+
+		k = pipe->queued ;
+		pipe->queued = -1 ;
+		pipe->busy = 1 ;
+		pthread_mutex_unlock (&pipe->mutex) ;
+
+		ok = FLAC__stream_encoder_process_interleaved (pipe->pflac->fse, pipe->pcm [k], pipe->frames [k]) ;
+
+		pthread_mutex_lock (&pipe->mutex) ;
+		pipe->frames [k] = 0 ;
+		pipe->busy = 0 ;
+		if (! ok)
+			pipe->failed = 1 ;
+		pthread_cond_broadcast (&pipe->cond) ;
+		} ;
+
+	pthread_mutex_unlock (&pipe->mutex) ;
+
+	return NULL ;
+} /* flac_pipe_worker */
+
+static int
+flac_pipe_open (SF_PRIVATE *psf, FLAC_PRIVATE *pflac)
+{	struct flac_pipe *pipe ;
+	int k ;
+
+	if ((pipe = calloc (1, sizeof (struct flac_pipe))) == NULL)
+		return SFE_MALLOC_FAILED ;
+
+	pipe->pflac = pflac ;
+	pipe->channels = psf->sf.channels ;
+	pipe->running = 1 ;
+	pipe->queued = -1 ;
+	pipe->position = psf_ftell (psf) ;
+
+	for (k = 0 ; k < 2 ; k++)
+		if ((pipe->pcm [k] = malloc (PIPE_FRAMES * pipe->channels * sizeof (int32_t))) == NULL)
+			goto fail ;
+
+	pthread_mutex_init (&pipe->mutex, NULL) ;
+	pthread_cond_init (&pipe->cond, NULL) ;
+
+	if (pthread_create (&pipe->thread, NULL, flac_pipe_worker, pipe) != 0)
+	{	pthread_cond_destroy (&pipe->cond) ;
+		pthread_mutex_destroy (&pipe->mutex) ;
+		goto fail ;
+		} ;
+
+	pflac->pipe = pipe ;
+
+	return 0 ;
+
+fail :
+	/* Carry on encoding on the caller's thread. */
+	psf_log_printf (psf, "%s : could not start the encoder thread.\n", __func__) ;
+	free (pipe->pcm [0]) ;
+	free (pipe->pcm [1]) ;
+	free (pipe) ;
+
+	return SFE_MALLOC_FAILED ;
+} /* flac_pipe_open */
+
+static FLAC__StreamEncoderTellStatus
+flac_pipe_tell (struct flac_pipe *pipe, FLAC__uint64 *absolute_byte_offset)
+{
+	/* Where the queued bytes will end up. */
+	*absolute_byte_offset = pipe->position ;
+
+	return FLAC__STREAM_ENCODER_TELL_STATUS_OK ;
+} /* flac_pipe_tell */
+
+static FLAC__StreamEncoderWriteStatus
+flac_pipe_output (struct flac_pipe *pipe, const FLAC__byte buffer [], size_t bytes)
+{	FLAC__byte *out ;
+	size_t size ;
+
+	pthread_mutex_lock (&pipe->mutex) ;
+
+	if (pipe->outlen [0] + bytes > pipe->outsize [0])
+	{	size = SF_MAX (2 * pipe->outsize [0], pipe->outlen [0] + bytes) ;
+		if ((out = realloc (pipe->out [0], size)) == NULL)
+		{	pthread_mutex_unlock (&pipe->mutex) ;
+			return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR ;
+			} ;
+		pipe->out [0] = out ;
+		pipe->outsize [0] = size ;
+		} ;
+
+	memcpy (pipe->out [0] + pipe->outlen [0], buffer, bytes) ;
+	pipe->outlen [0] += bytes ;
+	pipe->position += bytes ;
+
+	pthread_mutex_unlock (&pipe->mutex) ;
+
+	return FLAC__STREAM_ENCODER_WRITE_STATUS_OK ;
+} /* flac_pipe_output */
+
+/* Writes out whatever the worker has encoded so far. */
+static int
+flac_pipe_flush (SF_PRIVATE *psf, struct flac_pipe *pipe)
+{	FLAC__byte *out ;
+	size_t size ;
+	int failed ;
+
+	pthread_mutex_lock (&pipe->mutex) ;
+	out = pipe->out [1] ;
+	size = pipe->outsize [1] ;
+	pipe->out [1] = pipe->out [0] ;
+	pipe->outsize [1] = pipe->outsize [0] ;
+	pipe->outlen [1] = pipe->outlen [0] ;
+	pipe->out [0] = out ;
+	pipe->outsize [0] = size ;
+	pipe->outlen [0] = 0 ;
+	pthread_mutex_unlock (&pipe->mutex) ;
+
+	failed = pipe->outlen [1] > 0 && psf_fwrite (pipe->out [1], 1, pipe->outlen [1], psf) != (sf_count_t) pipe->outlen [1] ;
+	pipe->outlen [1] = 0 ;
+
+	/* The worker may be setting failed too, so both go through the mutex. */
+	pthread_mutex_lock (&pipe->mutex) ;
+	if (failed)
+		pipe->failed = 1 ;
+	failed = pipe->failed ;
+	pthread_mutex_unlock (&pipe->mutex) ;
+
+	return (failed || psf->error) ? 1 : 0 ;
+} /* flac_pipe_flush */
+
+/* Hands the buffer being filled to the worker once it is idle. */
+static FLAC__bool
+flac_pipe_handoff (struct flac_pipe *pipe)
+{	FLAC__bool ok ;
+
+	pthread_mutex_lock (&pipe->mutex) ;
+
+	while (pipe->queued >= 0 || pipe->busy)
+		pthread_cond_wait (&pipe->cond, &pipe->mutex) ;
+
+	if ((ok = ! pipe->failed) && pipe->frames [pipe->fill] > 0)
+	{	pipe->queued = pipe->fill ;
+		pipe->fill ^= 1 ;
+		pthread_cond_broadcast (&pipe->cond) ;
+		} ;
+
+	pthread_mutex_unlock (&pipe->mutex) ;
+
+	return ok ;
+} /* flac_pipe_handoff */
+
+static FLAC__bool
+flac_pipe_push (SF_PRIVATE *psf, struct flac_pipe *pipe, const int32_t *buffer, unsigned frames)
+{	unsigned count ;
+	int k ;
+
+	while (frames > 0)
+	{	k = pipe->fill ;
+		count = SF_MIN (frames, PIPE_FRAMES - pipe->frames [k]) ;
+
+		memcpy (pipe->pcm [k] + pipe->frames [k] * pipe->channels, buffer, count * pipe->channels * sizeof (int32_t)) ;
+		pipe->frames [k] += count ;
+		buffer += count * pipe->channels ;
+		frames -= count ;
+
+		/* While the worker encodes this buffer, write out what it did before. */
+		if (pipe->frames [k] == PIPE_FRAMES && (! flac_pipe_handoff (pipe) || flac_pipe_flush (psf, pipe)))
+			return 0 ;
+		} ;
+
+	return 1 ;
+} /* flac_pipe_push */
+
+static int
+flac_pipe_close (SF_PRIVATE *psf, FLAC_PRIVATE *pflac)
+{	struct flac_pipe *pipe = pflac->pipe ;
+	int error ;
+
+	if (pipe == NULL)
+		return 0 ;
+
+	/* Queue the last partial buffer and wait for the worker to finish it. */
+	flac_pipe_handoff (pipe) ;
+
+	pthread_mutex_lock (&pipe->mutex) ;
+	pipe->running = 0 ;
+	pthread_cond_broadcast (&pipe->cond) ;
+	pthread_mutex_unlock (&pipe->mutex) ;
+
+	pthread_join (pipe->thread, NULL) ;
+
+	if ((error = flac_pipe_flush (psf, pipe)) != 0)
+		psf_log_printf (psf, "%s : the encoder thread failed.\n", __func__) ;
+
+	pthread_cond_destroy (&pipe->cond) ;
+	pthread_mutex_destroy (&pipe->mutex) ;
+
+	free (pipe->pcm [0]) ;
+	free (pipe->pcm [1]) ;
+	free (pipe->out [0]) ;
+	free (pipe->out [1]) ;
+	free (pipe) ;
+
+	pflac->pipe = NULL ;
+
+	return error ;
+} /* flac_pipe_close */
+
+#else /* FLAC_PIPELINE */
+
+static int
+flac_pipe_open (SF_PRIVATE * UNUSED (psf), FLAC_PRIVATE * UNUSED (pflac))
+{	return 0 ;
+} /* flac_pipe_open */
+
+static int
+flac_pipe_close (SF_PRIVATE * UNUSED (psf), FLAC_PRIVATE * UNUSED (pflac))
+{	return 0 ;
+} /* flac_pipe_close */
+
+static FLAC__bool
+flac_pipe_push (SF_PRIVATE * UNUSED (psf), struct flac_pipe * UNUSED (pipe), const int32_t * UNUSED (buffer), unsigned UNUSED (frames))
+{	return 0 ;
+} /* flac_pipe_push */
+
+static FLAC__StreamEncoderTellStatus
+flac_pipe_tell (struct flac_pipe * UNUSED (pipe), FLAC__uint64 * UNUSED (absolute_byte_offset))
+{	return FLAC__STREAM_ENCODER_TELL_STATUS_ERROR ;
+} /* flac_pipe_tell */
+
+static FLAC__StreamEncoderWriteStatus
+flac_pipe_output (struct flac_pipe * UNUSED (pipe), const FLAC__byte * UNUSED (buffer), size_t UNUSED (bytes))
+{	return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR ;
+} /* flac_pipe_output */
+
+#endif /* FLAC_PIPELINE */
+
 
 #else /* HAVE_EXTERNAL_XIPH_LIBS */
 
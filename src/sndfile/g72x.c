@@ -46,6 +46,7 @@ typedef struct
 } G72x_PRIVATE ;
 
 static	int	psf_g72x_decode_block (SF_PRIVATE *psf, G72x_PRIVATE *pg72x) ;
+static	void	psf_g72x_decode_block_float (SF_PRIVATE *psf, G72x_PRIVATE *pg72x, float *ptr, float normfact) ;
 static	int	psf_g72x_encode_block (SF_PRIVATE *psf, G72x_PRIVATE *pg72x) ;
 
 static	sf_count_t	g72x_read_s (SF_PRIVATE *psf, short *ptr, sf_count_t len) ;
@@ -199,6 +200,24 @@ psf_g72x_decode_block (SF_PRIVATE *psf, G72x_PRIVATE *pg72x)
 	return 1 ;
 } /* psf_g72x_decode_block */
 
+/*
+** Decode the next block straight into ptr as floats, leaving pg72x->samples
+** alone. Only called when the current block has been used up and there is
+** at least one more block to come.
+*/
+static void
+psf_g72x_decode_block_float (SF_PRIVATE *psf, G72x_PRIVATE *pg72x, float *ptr, float normfact)
+{	int	k ;
+
+	pg72x->block_curr ++ ;
+
+	if ((k = psf_fread (pg72x->block, 1, pg72x->bytesperblock, psf)) != pg72x->bytesperblock)
+		psf_log_printf (psf, "*** Warning : short read (%d != %d).\n", k, pg72x->bytesperblock) ;
+
+	pg72x->blocksize = k ;
+	g72x_decode_block_float (pg72x->private, pg72x->block, ptr, normfact) ;
+} /* psf_g72x_decode_block_float */
+
 static int
 g72x_read_block (SF_PRIVATE *psf, G72x_PRIVATE *pg72x, short *ptr, int len)
 {	int	count, total = 0, indx = 0 ;
@@ -224,6 +243,41 @@ g72x_read_block (SF_PRIVATE *psf, G72x_PRIVATE *pg72x, short *ptr, int len)
 	return total ;
 } /* g72x_read_block */
 
+static int
+g72x_read_block_float (SF_PRIVATE *psf, G72x_PRIVATE *pg72x, float *ptr, int len, float normfact)
+{	int	k, count, total = 0, indx = 0 ;
+
+	while (indx < len)
+	{	if (pg72x->block_curr > pg72x->blocks_total)
+		{	memset (&(ptr [indx]), 0, (len - indx) * sizeof (float)) ;
+			return total ;
+			} ;
+
+		if (pg72x->sample_curr >= pg72x->samplesperblock)
+		{	/* Whole blocks skip the short buffer and decode straight to float. */
+			if (pg72x->block_curr < pg72x->blocks_total && len - indx >= pg72x->samplesperblock)
+			{	psf_g72x_decode_block_float (psf, pg72x, &(ptr [indx]), normfact) ;
+				indx += pg72x->samplesperblock ;
+				total = indx ;
+				continue ;
+				} ;
+
+			psf_g72x_decode_block (psf, pg72x) ;
+			} ;
+
+		count = pg72x->samplesperblock - pg72x->sample_curr ;
+		count = (len - indx > count) ? count : len - indx ;
+
+		for (k = 0 ; k < count ; k++)
+			ptr [indx + k] = normfact * pg72x->samples [pg72x->sample_curr + k] ;
+		indx += count ;
+		pg72x->sample_curr += count ;
+		total = indx ;
+		} ;
+
+	return total ;
+} /* g72x_read_block_float */
+
 static sf_count_t
 g72x_read_s (SF_PRIVATE *psf, short *ptr, sf_count_t len)
 {	G72x_PRIVATE 	*pg72x ;
@@ -281,10 +335,8 @@ g72x_read_i (SF_PRIVATE *psf, int *ptr, sf_count_t len)
 
 static sf_count_t
 g72x_read_f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
-{	BUF_UNION	ubuf ;
-	G72x_PRIVATE *pg72x ;
-	short		*sptr ;
-	int			k, bufferlen, readcount = 0, count ;
+{	G72x_PRIVATE *pg72x ;
+	int			readcount, count ;
 	sf_count_t	total = 0 ;
 	float 		normfact ;
 
@@ -294,16 +346,14 @@ g72x_read_f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 
 	normfact = (psf->norm_float == SF_TRUE) ? 1.0 / ((float) 0x8000) : 1.0 ;
 
-	sptr = ubuf.sbuf ;
-	bufferlen = SF_BUFFER_LEN / sizeof (short) ;
 	while (len > 0)
-	{	readcount = (len >= bufferlen) ? bufferlen : len ;
-		count = g72x_read_block (psf, pg72x, sptr, readcount) ;
-		for (k = 0 ; k < readcount ; k++)
-			ptr [total + k] = normfact * sptr [k] ;
+	{	readcount = (len > 0x10000000) ? 0x10000000 : (int) len ;
+
+		count = g72x_read_block_float (psf, pg72x, ptr + total, readcount, normfact) ;
 
 		total += count ;
-		len -= readcount ;
+		len -= count ;
+
 		if (count != readcount)
 			break ;
 		} ;
@@ -23,6 +23,10 @@
 #include <string.h>
 #include <math.h>
 
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include "sndfile.h"
 #include "sfendian.h"
 #include "common.h"
@@ -32,6 +36,19 @@
 #define	GSM610_BLOCKSIZE		33
 #define	GSM610_SAMPLES			160
 
+/*
+** Batch transcoding opens and closes many short GSM files in a row, so the
+** codec state of closed files is kept on a small free list and reset for the
+** next file instead of going back to malloc. Without pthreads there is no
+** pool and every file allocates its own.
+*/
+#if defined (_POSIX_THREADS) && (_POSIX_THREADS > 0)
+#define	GSM610_POOL_SIZE		32
+#include <pthread.h>
+#else
+#define	GSM610_POOL_SIZE		0
+#endif
+
 typedef struct gsm610_tag
 {	int				blocks ;
 	int				blockcount, samplecount ;
@@ -70,6 +87,16 @@ static sf_count_t	gsm610_seek	(SF_PRIVATE *psf, int mode, sf_count_t offset) ;
 
 static int	gsm610_close	(SF_PRIVATE *psf) ;
 
+static GSM610_PRIVATE *	gsm610_private_new		(void) ;
+static void				gsm610_private_release	(GSM610_PRIVATE *pgsm610) ;
+
+#if GSM610_POOL_SIZE
+static pthread_mutex_t	gsm610_pool_lock = PTHREAD_MUTEX_INITIALIZER ;
+static GSM610_PRIVATE	*gsm610_pool [GSM610_POOL_SIZE] ;
+static int				gsm610_pool_count = 0 ;
+static int				gsm610_pool_enabled = SF_TRUE ;
+#endif
+
 /*============================================================================================
 ** WAV GSM610 initialisation function.
 */
@@ -89,22 +116,17 @@ gsm610_init	(SF_PRIVATE *psf)
 
 	psf->sf.seekable = SF_FALSE ;
 
-	if ((pgsm610 = calloc (1, sizeof (GSM610_PRIVATE))) == NULL)
-		return SFE_MALLOC_FAILED ;
-
-	psf->codec_data = pgsm610 ;
-
-	memset (pgsm610, 0, sizeof (GSM610_PRIVATE)) ;
-
 /*============================================================
 
 Need separate gsm_data structs for encode and decode.
 
 ============================================================*/
 
-	if ((pgsm610->gsm_data = gsm_create ()) == NULL)
+	if ((pgsm610 = gsm610_private_new ()) == NULL)
 		return SFE_MALLOC_FAILED ;
 
+	psf->codec_data = pgsm610 ;
+
 	switch (SF_CONTAINER (psf->sf.format))
 	{	case SF_FORMAT_WAV :
 		case SF_FORMAT_WAVEX :
@@ -619,9 +641,100 @@ gsm610_close	(SF_PRIVATE *psf)
 			pgsm610->encode_block (psf, pgsm610) ;
 		} ;
 
-	if (pgsm610->gsm_data)
-		gsm_destroy (pgsm610->gsm_data) ;
+	/* The struct goes back to the pool, so psf_close must not free it. */
+	gsm610_private_release (pgsm610) ;
+	psf->codec_data = NULL ;
 
 	return 0 ;
 } /* gsm610_close */
 
+/*============================================================================================
+** Codec state pool.
+*/
+
+static GSM610_PRIVATE *
+gsm610_private_new (void)
+{	GSM610_PRIVATE *pgsm610 = NULL ;
+
+#if GSM610_POOL_SIZE
+	gsm		gsm_data ;
+
+	pthread_mutex_lock (&gsm610_pool_lock) ;
+	if (gsm610_pool_count > 0)
+		pgsm610 = gsm610_pool [-- gsm610_pool_count] ;
+	pthread_mutex_unlock (&gsm610_pool_lock) ;
+
+	if (pgsm610 != NULL)
+	{	gsm_data = pgsm610->gsm_data ;
+		memset (pgsm610, 0, sizeof (GSM610_PRIVATE)) ;
+
+		gsm_init (gsm_data) ;
+		pgsm610->gsm_data = gsm_data ;
+		return pgsm610 ;
+		} ;
+#endif
+
+	if ((pgsm610 = calloc (1, sizeof (GSM610_PRIVATE))) == NULL)
+		return NULL ;
+
+	if ((pgsm610->gsm_data = gsm_create ()) == NULL)
+	{	free (pgsm610) ;
+		return NULL ;
+		} ;
+
+	return pgsm610 ;
+} /* gsm610_private_new */
+
+static void
+gsm610_private_release (GSM610_PRIVATE *pgsm610)
+{
+#if GSM610_POOL_SIZE
+	pthread_mutex_lock (&gsm610_pool_lock) ;
+	if (gsm610_pool_enabled && gsm610_pool_count < GSM610_POOL_SIZE)
+	{	gsm610_pool [gsm610_pool_count ++] = pgsm610 ;
+		pgsm610 = NULL ;
+		} ;
+	pthread_mutex_unlock (&gsm610_pool_lock) ;
+
+	if (pgsm610 == NULL)
+		return ;
+#endif
+
+	gsm_destroy (pgsm610->gsm_data) ;
+	free (pgsm610) ;
+} /* gsm610_private_release */
+
+/*
+** Turns the pool on or off for the files opened after it, and returns the
+** previous setting. Turning it off frees the states it holds. Meant for
+** measuring what the pool saves.
+*/
+#if GSM610_POOL_SIZE
+int
+gsm610_set_pool (int enable)
+{	GSM610_PRIVATE *pool [GSM610_POOL_SIZE] ;
+	int count = 0, k, old_value ;
+
+	pthread_mutex_lock (&gsm610_pool_lock) ;
+	old_value = gsm610_pool_enabled ;
+	gsm610_pool_enabled = enable ? SF_TRUE : SF_FALSE ;
+	if (! gsm610_pool_enabled)
+	{	count = gsm610_pool_count ;
+		memcpy (pool, gsm610_pool, count * sizeof (pool [0])) ;
+		gsm610_pool_count = 0 ;
+		} ;
+	pthread_mutex_unlock (&gsm610_pool_lock) ;
+
+	for (k = 0 ; k < count ; k++)
+	{	gsm_destroy (pool [k]->gsm_data) ;
+		free (pool [k]) ;
+		} ;
+
+	return old_value ;
+} /* gsm610_set_pool */
+#else
+int
+gsm610_set_pool (int UNUSED (enable))
+{	return SF_FALSE ;
+} /* gsm610_set_pool */
+#endif
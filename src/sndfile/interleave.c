@@ -25,16 +25,33 @@
 
 #define		INTERLEAVE_CHANNELS		6
 
-typedef struct
-{	double	buffer [SF_BUFFER_LEN / sizeof (double)] ;
+/*
+** Frames of every channel kept in memory. Reading them a span at a time
+** means seeking once per channel per span instead of on every call.
+*/
+#define		INTERLEAVE_SPAN_FRAMES	1024
 
-	sf_count_t		channel_len ;
+enum
+{	SPAN_NONE = 0,
+	SPAN_SHORT,
+	SPAN_INT,
+	SPAN_FLOAT,
+	SPAN_DOUBLE
+} ;
+
+typedef struct
+{	sf_count_t		channel_len ;
 
 	sf_count_t		(*read_short)	(SF_PRIVATE*, short *ptr, sf_count_t len) ;
 	sf_count_t		(*read_int)	(SF_PRIVATE*, int *ptr, sf_count_t len) ;
 	sf_count_t		(*read_float)	(SF_PRIVATE*, float *ptr, sf_count_t len) ;
 	sf_count_t		(*read_double)	(SF_PRIVATE*, double *ptr, sf_count_t len) ;
 
+	/* Frames span_start to span_start + span_frames of each channel, as span_type. */
+	sf_count_t		span_start ;
+	int				span_frames, span_type ;
+
+	double			span [] ;
 } INTERLEAVE_DATA ;
 
 
@@ -44,8 +61,11 @@ static sf_count_t	interleave_read_int	(SF_PRIVATE *psf, int *ptr, sf_count_t len
 static sf_count_t	interleave_read_float	(SF_PRIVATE *psf, float *ptr, sf_count_t len) ;
 static sf_count_t	interleave_read_double	(SF_PRIVATE *psf, double *ptr, sf_count_t len) ;
 
+static sf_count_t	interleave_read_float_planar	(SF_PRIVATE *psf, float * const *ptr, sf_count_t frames) ;
+
 static sf_count_t	interleave_seek	(SF_PRIVATE*, int mode, sf_count_t samples_from_start) ;
 
+static int	interleave_span	(SF_PRIVATE *psf, INTERLEAVE_DATA *pdata, int type, sf_count_t frame) ;
 
 
 
@@ -62,11 +82,9 @@ interleave_init	(SF_PRIVATE *psf)
 		} ;
 
 	/* Free this in sf_close() function. */
-	if (! (pdata = malloc (sizeof (INTERLEAVE_DATA))))
+	if (! (pdata = malloc (sizeof (INTERLEAVE_DATA) + psf->sf.channels * INTERLEAVE_SPAN_FRAMES * sizeof (double))))
 		return SFE_MALLOC_FAILED ;
 
-puts ("interleave_init") ;
-
 	psf->interleave = pdata ;
 
 	/* Save the existing methods. */
@@ -77,12 +95,18 @@ puts ("interleave_init") ;
 
 	pdata->channel_len = psf->sf.frames * psf->bytewidth ;
 
+	pdata->span_start = 0 ;
+	pdata->span_frames = 0 ;
+	pdata->span_type = SPAN_NONE ;
+
 	/* Insert our new methods. */
 	psf->read_short		= interleave_read_short ;
 	psf->read_int		= interleave_read_int ;
 	psf->read_float		= interleave_read_float ;
 	psf->read_double	= interleave_read_double ;
 
+	psf->read_float_planar = interleave_read_float_planar ;
+
 	psf->seek = interleave_seek ;
 
 	return 0 ;
@@ -94,194 +118,236 @@ puts ("interleave_init") ;
 static sf_count_t
 interleave_read_short	(SF_PRIVATE *psf, short *ptr, sf_count_t len)
 {	INTERLEAVE_DATA *pdata ;
-	sf_count_t	offset, templen ;
+	sf_count_t	frames, frame, total = 0 ;
 	int			chan, count, k ;
 	short		*inptr, *outptr ;
 
 	if (! (pdata = psf->interleave))
 		return 0 ;
 
-	inptr = (short*) pdata->buffer ;
+	frames = len / psf->sf.channels ;
+	frame = psf->read_current ;
 
-	for (chan = 0 ; chan < psf->sf.channels ; chan++)
-	{	outptr = ptr + chan ;
+	while (total < frames)
+	{	if ((count = interleave_span (psf, pdata, SPAN_SHORT, frame)) <= 0)
+			break ;
 
-		offset = psf->dataoffset + chan * psf->bytewidth * psf->read_current ;
+		count = frames - total < count ? (int) (frames - total) : count ;
 
-		if (psf_fseek (psf, offset, SEEK_SET) != offset)
-		{	psf->error = SFE_INTERLEAVE_SEEK ;
-			return 0 ;
-			} ;
-
-		templen = len / psf->sf.channels ;
-
-		while (templen > 0)
-		{	if (templen > SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (short))
-				count = SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (short) ;
-			else
-				count = (int) templen ;
-
-			if (pdata->read_short (psf, inptr, count) != count)
-			{	psf->error = SFE_INTERLEAVE_READ ;
-				return 0 ;
-				} ;
+		for (chan = 0 ; chan < psf->sf.channels ; chan++)
+		{	inptr = (short*) (pdata->span + chan * INTERLEAVE_SPAN_FRAMES) + (frame - pdata->span_start) ;
+			outptr = ptr + total * psf->sf.channels + chan ;
 
 			for (k = 0 ; k < count ; k++)
 			{	*outptr = inptr [k] ;
 				outptr += psf->sf.channels ;
 				} ;
-
-			templen -= count ;
 			} ;
+
+		total += count ;
+		frame += count ;
 		} ;
 
-	return len ;
+	return total * psf->sf.channels ;
 } /* interleave_read_short */
 
 static sf_count_t
 interleave_read_int	(SF_PRIVATE *psf, int *ptr, sf_count_t len)
 {	INTERLEAVE_DATA *pdata ;
-	sf_count_t	offset, templen ;
+	sf_count_t	frames, frame, total = 0 ;
 	int			chan, count, k ;
 	int		*inptr, *outptr ;
 
 	if (! (pdata = psf->interleave))
 		return 0 ;
 
-	inptr = (int*) pdata->buffer ;
-
-	for (chan = 0 ; chan < psf->sf.channels ; chan++)
-	{	outptr = ptr + chan ;
-
-		offset = psf->dataoffset + chan * psf->bytewidth * psf->read_current ;
-
-		if (psf_fseek (psf, offset, SEEK_SET) != offset)
-		{	psf->error = SFE_INTERLEAVE_SEEK ;
-			return 0 ;
-			} ;
+	frames = len / psf->sf.channels ;
+	frame = psf->read_current ;
 
-		templen = len / psf->sf.channels ;
+	while (total < frames)
+	{	if ((count = interleave_span (psf, pdata, SPAN_INT, frame)) <= 0)
+			break ;
 
-		while (templen > 0)
-		{	if (templen > SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (int))
-				count = SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (int) ;
-			else
-				count = (int) templen ;
+		count = frames - total < count ? (int) (frames - total) : count ;
 
-			if (pdata->read_int (psf, inptr, count) != count)
-			{	psf->error = SFE_INTERLEAVE_READ ;
-				return 0 ;
-				} ;
+		for (chan = 0 ; chan < psf->sf.channels ; chan++)
+		{	inptr = (int*) (pdata->span + chan * INTERLEAVE_SPAN_FRAMES) + (frame - pdata->span_start) ;
+			outptr = ptr + total * psf->sf.channels + chan ;
 
 			for (k = 0 ; k < count ; k++)
 			{	*outptr = inptr [k] ;
 				outptr += psf->sf.channels ;
 				} ;
-
-			templen -= count ;
 			} ;
+
+		total += count ;
+		frame += count ;
 		} ;
 
-	return len ;
+	return total * psf->sf.channels ;
 } /* interleave_read_int */
 
 static sf_count_t
 interleave_read_float	(SF_PRIVATE *psf, float *ptr, sf_count_t len)
 {	INTERLEAVE_DATA *pdata ;
-	sf_count_t	offset, templen ;
+	sf_count_t	frames, frame, total = 0 ;
 	int			chan, count, k ;
 	float		*inptr, *outptr ;
 
 	if (! (pdata = psf->interleave))
 		return 0 ;
 
-	inptr = (float*) pdata->buffer ;
+	frames = len / psf->sf.channels ;
+	frame = psf->read_current ;
 
-	for (chan = 0 ; chan < psf->sf.channels ; chan++)
-	{	outptr = ptr + chan ;
+	while (total < frames)
+	{	if ((count = interleave_span (psf, pdata, SPAN_FLOAT, frame)) <= 0)
+			break ;
 
-		offset = psf->dataoffset + pdata->channel_len * chan + psf->read_current * psf->bytewidth ;
+		count = frames - total < count ? (int) (frames - total) : count ;
 
-/*-printf ("chan : %d     read_current : %6lld    offset : %6lld\n", chan, psf->read_current, offset) ;-*/
+		for (chan = 0 ; chan < psf->sf.channels ; chan++)
+		{	inptr = (float*) (pdata->span + chan * INTERLEAVE_SPAN_FRAMES) + (frame - pdata->span_start) ;
+			outptr = ptr + total * psf->sf.channels + chan ;
 
-		if (psf_fseek (psf, offset, SEEK_SET) != offset)
-		{	psf->error = SFE_INTERLEAVE_SEEK ;
-/*-puts ("interleave_seek error") ; exit (1) ;-*/
-			return 0 ;
+			for (k = 0 ; k < count ; k++)
+			{	*outptr = inptr [k] ;
+				outptr += psf->sf.channels ;
+				} ;
 			} ;
 
-		templen = len / psf->sf.channels ;
+		total += count ;
+		frame += count ;
+		} ;
 
-		while (templen > 0)
-		{	if (templen > SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (float))
-				count = SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (float) ;
-			else
-				count = (int) templen ;
+	return total * psf->sf.channels ;
+} /* interleave_read_float */
 
-			if (pdata->read_float (psf, inptr, count) != count)
-			{	psf->error = SFE_INTERLEAVE_READ ;
-/*-puts ("interleave_read error") ; exit (1) ;-*/
-				return 0 ;
-				} ;
+static sf_count_t
+interleave_read_double	(SF_PRIVATE *psf, double *ptr, sf_count_t len)
+{	INTERLEAVE_DATA *pdata ;
+	sf_count_t	frames, frame, total = 0 ;
+	int			chan, count, k ;
+	double		*inptr, *outptr ;
+
+	if (! (pdata = psf->interleave))
+		return 0 ;
+
+	frames = len / psf->sf.channels ;
+	frame = psf->read_current ;
+
+	while (total < frames)
+	{	if ((count = interleave_span (psf, pdata, SPAN_DOUBLE, frame)) <= 0)
+			break ;
+
+		count = frames - total < count ? (int) (frames - total) : count ;
+
+		for (chan = 0 ; chan < psf->sf.channels ; chan++)
+		{	inptr = pdata->span + chan * INTERLEAVE_SPAN_FRAMES + (frame - pdata->span_start) ;
+			outptr = ptr + total * psf->sf.channels + chan ;
 
 			for (k = 0 ; k < count ; k++)
 			{	*outptr = inptr [k] ;
 				outptr += psf->sf.channels ;
 				} ;
-
-			templen -= count ;
 			} ;
+
+		total += count ;
+		frame += count ;
 		} ;
 
-	return len ;
-} /* interleave_read_float */
+	return total * psf->sf.channels ;
+} /* interleave_read_double */
+
+/*------------------------------------------------------------------------------
+*/
 
 static sf_count_t
-interleave_read_double	(SF_PRIVATE *psf, double *ptr, sf_count_t len)
+interleave_read_float_planar	(SF_PRIVATE *psf, float * const *ptr, sf_count_t frames)
 {	INTERLEAVE_DATA *pdata ;
-	sf_count_t	offset, templen ;
-	int			chan, count, k ;
-	double		*inptr, *outptr ;
+	sf_count_t	offset, count ;
+	int			chan ;
 
 	if (! (pdata = psf->interleave))
 		return 0 ;
 
-	inptr = (double*) pdata->buffer ;
+	if (frames > psf->sf.frames - psf->read_current)
+		frames = psf->sf.frames - psf->read_current ;
 
+	/* The channels are already apart, read each one straight into its array. */
 	for (chan = 0 ; chan < psf->sf.channels ; chan++)
-	{	outptr = ptr + chan ;
-
-		offset = psf->dataoffset + chan * psf->bytewidth * psf->read_current ;
+	{	offset = psf->dataoffset + pdata->channel_len * chan + psf->read_current * psf->bytewidth ;
 
 		if (psf_fseek (psf, offset, SEEK_SET) != offset)
 		{	psf->error = SFE_INTERLEAVE_SEEK ;
 			return 0 ;
 			} ;
 
-		templen = len / psf->sf.channels ;
+		if ((count = pdata->read_float (psf, ptr [chan], frames)) != frames)
+		{	psf->error = SFE_INTERLEAVE_READ ;
+			return 0 ;
+			} ;
+		} ;
+
+	return frames ;
+} /* interleave_read_float_planar */
 
-		while (templen > 0)
-		{	if (templen > SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (double))
-				count = SIGNED_SIZEOF (pdata->buffer) / SIGNED_SIZEOF (double) ;
-			else
-				count = (int) templen ;
+/*------------------------------------------------------------------------------
+*/
 
-			if (pdata->read_double (psf, inptr, count) != count)
-			{	psf->error = SFE_INTERLEAVE_READ ;
-				return 0 ;
-				} ;
+static int
+interleave_span	(SF_PRIVATE *psf, INTERLEAVE_DATA *pdata, int type, sf_count_t frame)
+{	sf_count_t	offset, count ;
+	double		*span ;
+	int			chan, frames ;
 
-			for (k = 0 ; k < count ; k++)
-			{	*outptr = inptr [k] ;
-				outptr += psf->sf.channels ;
-				} ;
+	if (type == pdata->span_type && frame >= pdata->span_start && frame < pdata->span_start + pdata->span_frames)
+		return (int) (pdata->span_start + pdata->span_frames - frame) ;
+
+	pdata->span_type = SPAN_NONE ;
+
+	if (frame >= psf->sf.frames)
+		return 0 ;
+
+	frames = psf->sf.frames - frame > INTERLEAVE_SPAN_FRAMES ? INTERLEAVE_SPAN_FRAMES : (int) (psf->sf.frames - frame) ;
 
-			templen -= count ;
+	for (chan = 0 ; chan < psf->sf.channels ; chan++)
+	{	offset = psf->dataoffset + pdata->channel_len * chan + frame * psf->bytewidth ;
+
+		if (psf_fseek (psf, offset, SEEK_SET) != offset)
+		{	psf->error = SFE_INTERLEAVE_SEEK ;
+			return -1 ;
+			} ;
+
+		span = pdata->span + chan * INTERLEAVE_SPAN_FRAMES ;
+
+		switch (type)
+		{	case SPAN_SHORT :
+				count = pdata->read_short (psf, (short*) span, frames) ;
+				break ;
+			case SPAN_INT :
+				count = pdata->read_int (psf, (int*) span, frames) ;
+				break ;
+			case SPAN_FLOAT :
+				count = pdata->read_float (psf, (float*) span, frames) ;
+				break ;
+			default :
+				count = pdata->read_double (psf, span, frames) ;
+				break ;
+			} ;
+
+		if (count != frames)
+		{	psf->error = SFE_INTERLEAVE_READ ;
+			return -1 ;
 			} ;
 		} ;
 
-	return len ;
-} /* interleave_read_double */
+	pdata->span_start = frame ;
+	pdata->span_frames = frames ;
+	pdata->span_type = type ;
+
+	return frames ;
+} /* interleave_span */
 
 /*------------------------------------------------------------------------------
 */
@@ -296,4 +362,3 @@ interleave_seek	(SF_PRIVATE * UNUSED (psf), int UNUSED (mode), sf_count_t sample
 
 	return samples_from_start ;
 } /* interleave_seek */
-
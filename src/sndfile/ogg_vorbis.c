@@ -86,6 +86,7 @@ static int	vorbis_close (SF_PRIVATE *psf) ;
 static int	vorbis_command (SF_PRIVATE *psf, int command, void *data, int datasize) ;
 static int	vorbis_byterate (SF_PRIVATE *psf) ;
 static sf_count_t	vorbis_seek (SF_PRIVATE *psf, int mode, sf_count_t offset) ;
+static int	vorbis_seek_page (SF_PRIVATE *psf, const PSF_SEEK_POINT *point) ;
 static sf_count_t	vorbis_read_s (SF_PRIVATE *psf, short *ptr, sf_count_t len) ;
 static sf_count_t	vorbis_read_i (SF_PRIVATE *psf, int *ptr, sf_count_t len) ;
 static sf_count_t	vorbis_read_f (SF_PRIVATE *psf, float *ptr, sf_count_t len) ;
@@ -129,6 +130,10 @@ typedef struct
 
 	/* Encoding quality in range [0.0, 1.0]. */
 	double quality ;
+
+	/* Position of the last page read and whether its first packet is still to be decoded. */
+	sf_count_t pageoffset ;
+	int newpage ;
 } VORBIS_PRIVATE ;
 
 static int
@@ -519,6 +524,9 @@ ogg_vorbis_open (SF_PRIVATE *psf)
 		psf->read_float		= vorbis_read_f ;
 		psf->read_double	= vorbis_read_d ;
 		psf->sf.frames		= vorbis_length (psf) ;
+
+		/* Pages are indexed as they are decoded. */
+		psf->seekidx.enabled = psf->sf.seekable ;
 		} ;
 
 	psf->codec_close = vorbis_close ;
@@ -682,7 +690,16 @@ vorbis_read_sample (SF_PRIVATE *psf, void *ptr, sf_count_t lens, convert_func *t
 				psf_log_printf (psf, "Corrupt or missing data in bitstream ; continuing...\n") ;
 				}
 			else
-			{	/* can safely ignore errors at this point */
+			{	/*
+				**	Decoding can restart at a page which does not continue a
+				**	packet. Its position gets indexed once the first packet
+				**	is decoded and the frame it leads to is known.
+				*/
+				vdata->newpage = psf->seekidx.enabled && ogg_page_continued (&odata->opage) == 0 ;
+				vdata->pageoffset = psf_ftell (psf) - (odata->osync.fill - odata->osync.returned)
+										- (odata->opage.header_len + odata->opage.body_len) ;
+
+				/* can safely ignore errors at this point */
 				ogg_stream_pagein (&odata->ostream, &odata->opage) ;
 			start0:
 				while (1)
@@ -696,7 +713,17 @@ vorbis_read_sample (SF_PRIVATE *psf, void *ptr, sf_count_t lens, convert_func *t
 					else
 					{	/* we have a packet.	Decode it */
 						if (vorbis_synthesis (&vdata->vblock, &odata->opacket) == 0) /* test for success! */
-							vorbis_synthesis_blockin (&vdata->vdsp, &vdata->vblock) ;
+						{	vorbis_synthesis_blockin (&vdata->vdsp, &vdata->vblock) ;
+
+							/*
+							**	A restarted decoder discards the output of the first
+							**	packet, so the point is the frame after it.
+							*/
+							if (vdata->newpage)
+								psf_seek_index_add (psf, vdata->loc + vorbis_synthesis_pcmout (&vdata->vdsp, NULL), vdata->pageoffset) ;
+							} ;
+						vdata->newpage = SF_FALSE ;
+
 						/*
 						** pcm is a multichannel float vector.	 In stereo, for
 						** example, pcm [0] is left, and pcm [1] is right.	 samples is
@@ -860,6 +887,49 @@ vorbis_write_d (SF_PRIVATE *psf, const double *ptr, sf_count_t lens)
 	return lens ;
 } /* vorbis_write_d */
 
+static int
+vorbis_seek_page (SF_PRIVATE *psf, const PSF_SEEK_POINT *point)
+{	OGG_PRIVATE *odata = (OGG_PRIVATE *) psf->container_data ;
+	VORBIS_PRIVATE *vdata = (VORBIS_PRIVATE *) psf->codec_data ;
+	char *buffer ;
+	int bytes, result ;
+
+	if (psf_fseek (psf, point->offset, SEEK_SET) != point->offset)
+		return SF_FALSE ;
+
+	ogg_sync_reset (&odata->osync) ;
+	ogg_stream_reset (&odata->ostream) ;
+	vorbis_synthesis_restart (&vdata->vdsp) ;
+	odata->eos = 0 ;
+
+	/*
+	**	Load the page here, vorbis_read_sample () checks the last page it
+	**	decoded for the end of stream and that must not be the one from
+	**	before the seek. The page is indexed already.
+	*/
+	while ((result = ogg_sync_pageout (&odata->osync, &odata->opage)) != 1)
+	{	if (result < 0)
+			continue ;
+
+		buffer = ogg_sync_buffer (&odata->osync, 4096) ;
+		if ((bytes = psf_fread (buffer, 1, 4096, psf)) <= 0)
+			return SF_FALSE ;
+		ogg_sync_wrote (&odata->osync, bytes) ;
+		} ;
+
+	if (ogg_stream_pagein (&odata->ostream, &odata->opage) < 0)
+		return SF_FALSE ;
+	vdata->newpage = SF_FALSE ;
+
+	/*
+	**	The first packet of the page only primes the restarted decoder, the
+	**	output after that matches decoding from the start of the stream.
+	*/
+	vdata->loc = point->frame ;
+
+	return SF_TRUE ;
+} /* vorbis_seek_page */
+
 static sf_count_t
 vorbis_seek (SF_PRIVATE *psf, int UNUSED (mode), sf_count_t offset)
 {
@@ -875,9 +945,18 @@ vorbis_seek (SF_PRIVATE *psf, int UNUSED (mode), sf_count_t offset)
 		} ;
 
 	if (psf->file.mode == SFM_READ)
-	{	sf_count_t target = offset - vdata->loc ;
+	{	const PSF_SEEK_POINT *point ;
+		sf_count_t target ;
+		int rewind = SF_FALSE ;
+
+		/* Jump to an indexed page when it saves rewinding or decoding up to it. */
+		point = psf_seek_index_find (psf, offset, NULL) ;
+		if (point != NULL && (offset < vdata->loc || point->frame > vdata->loc))
+			rewind = vorbis_seek_page (psf, point) == SF_FALSE ;
+
+		target = offset - vdata->loc ;
 
-		if (target < 0)
+		if (target < 0 || rewind)
 		{	/* 12 to allow for OggS bit */
 			psf_fseek (psf, 12, SEEK_SET) ;
 			vorbis_read_header (psf, 0) ; /* Reset state */
@@ -19,6 +19,7 @@
 #include	"sfconfig.h"
 
 #include <math.h>
+#include <string.h>
 
 #include	"sndfile.h"
 #include	"sfendian.h"
@@ -104,6 +105,34 @@ static sf_count_t	pcm_write_d2let (SF_PRIVATE *psf, const double *ptr, sf_count_
 static sf_count_t	pcm_write_d2bei (SF_PRIVATE *psf, const double *ptr, sf_count_t len) ;
 static sf_count_t	pcm_write_d2lei (SF_PRIVATE *psf, const double *ptr, sf_count_t len) ;
 
+static void	f2bes_convert (const float *src, short *dest, int count, int normalize) ;
+static void	f2les_convert (const float *src, short *dest, int count, int normalize) ;
+static void	f2bet_convert (const float *src, tribyte *dest, int count, int normalize) ;
+static void	f2let_convert (const float *src, tribyte *dest, int count, int normalize) ;
+static void	f2bei_convert (const float *src, int *dest, int count, int normalize) ;
+static void	f2lei_convert (const float *src, int *dest, int count, int normalize) ;
+
+static void	f2bes_clip_convert (const float *src, short *dest, int count, int normalize) ;
+static void	f2les_clip_convert (const float *src, short *dest, int count, int normalize) ;
+static void	f2bet_clip_convert (const float *src, tribyte *dest, int count, int normalize) ;
+static void	f2let_clip_convert (const float *src, tribyte *dest, int count, int normalize) ;
+static void	f2bei_clip_convert (const float *src, int *dest, int count, int normalize) ;
+static void	f2lei_clip_convert (const float *src, int *dest, int count, int normalize) ;
+
+static void	d2bes_convert (const double *src, short *dest, int count, int normalize) ;
+static void	d2les_convert (const double *src, short *dest, int count, int normalize) ;
+static void	d2bet_convert (const double *src, tribyte *dest, int count, int normalize) ;
+static void	d2let_convert (const double *src, tribyte *dest, int count, int normalize) ;
+static void	d2bei_convert (const double *src, int *dest, int count, int normalize) ;
+static void	d2lei_convert (const double *src, int *dest, int count, int normalize) ;
+
+static void	d2bes_clip_convert (const double *src, short *dest, int count, int normalize) ;
+static void	d2les_clip_convert (const double *src, short *dest, int count, int normalize) ;
+static void	d2bet_clip_convert (const double *src, tribyte *dest, int count, int normalize) ;
+static void	d2let_clip_convert (const double *src, tribyte *dest, int count, int normalize) ;
+static void	d2bei_clip_convert (const double *src, int *dest, int count, int normalize) ;
+static void	d2lei_clip_convert (const double *src, int *dest, int count, int normalize) ;
+
 /*-----------------------------------------------------------------------------------------------
 */
 
@@ -564,6 +593,324 @@ bei2d_array (int *src, int count, double *dest, double normfact)
 		} ;
 } /* bei2d_array */
 
+/*--------------------------------------------------------------------------
+** Vectorised versions of the integer to float/double converters above.
+**
+** The kernels widen the samples to 32 bit ints exactly like the scalar
+** converters do (tribytes end up in the top 24 bits) and then multiply by
+** the same normfact, so their output is bit for bit the same. The SIMD
+** level is queried on every call, which is just a load and a test, so no
+** global state needs to be set up or protected.
+**
+** Only x86 with GCC or Clang is vectorised, everything else (and the tail
+** of every buffer) goes through the scalar converters.
+*/
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+#define	PCM_X86_SIMD	1
+#else
+#define	PCM_X86_SIMD	0
+#endif
+
+enum
+{	PCM_SIMD_NONE = 0,
+	PCM_SIMD_SSE2,
+	PCM_SIMD_SSSE3,
+	PCM_SIMD_AVX2
+} ;
+
+#if PCM_X86_SIMD
+
+#include <immintrin.h>
+
+#define	PCM_TARGET_SSE2		__attribute__ ((target ("sse2")))
+#define	PCM_TARGET_SSSE3	__attribute__ ((target ("ssse3")))
+#define	PCM_TARGET_AVX2		__attribute__ ((target ("avx2")))
+
+static inline int
+pcm_simd_level (void)
+{	if (__builtin_cpu_supports ("avx2"))
+		return PCM_SIMD_AVX2 ;
+	if (__builtin_cpu_supports ("ssse3"))
+		return PCM_SIMD_SSSE3 ;
+	if (__builtin_cpu_supports ("sse2"))
+		return PCM_SIMD_SSE2 ;
+	return PCM_SIMD_NONE ;
+} /* pcm_simd_level */
+
+/*
+** Each decoder turns the samples at ptr into four (SSE) or eight (AVX2)
+** ints. The kernels only call them while at least the given number of
+** samples is left, so the loads never read past the end of the buffer.
+*/
+
+static inline PCM_TARGET_SSE2 __m128i
+sc_decode_sse (const unsigned char *ptr)
+{	int32_t	bytes ;
+	__m128i	value ;
+
+	memcpy (&bytes, ptr, 4) ;
+	value = _mm_cvtsi32_si128 (bytes) ;
+	value = _mm_unpacklo_epi8 (value, value) ;
+	value = _mm_unpacklo_epi16 (value, value) ;
+	return _mm_srai_epi32 (value, 24) ;
+} /* sc_decode_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+uc_decode_sse (const unsigned char *ptr)
+{	int32_t	bytes ;
+	__m128i	value, zero = _mm_setzero_si128 () ;
+
+	memcpy (&bytes, ptr, 4) ;
+	value = _mm_cvtsi32_si128 (bytes) ;
+	value = _mm_unpacklo_epi8 (value, zero) ;
+	value = _mm_unpacklo_epi16 (value, zero) ;
+	return _mm_sub_epi32 (value, _mm_set1_epi32 (128)) ;
+} /* uc_decode_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+les_decode_sse (const unsigned char *ptr)
+{	__m128i value = _mm_loadl_epi64 ((const __m128i *) ptr) ;
+
+	return _mm_srai_epi32 (_mm_unpacklo_epi16 (value, value), 16) ;
+} /* les_decode_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+bes_decode_sse (const unsigned char *ptr)
+{	__m128i value = _mm_loadl_epi64 ((const __m128i *) ptr) ;
+
+	value = _mm_or_si128 (_mm_slli_epi16 (value, 8), _mm_srli_epi16 (value, 8)) ;
+	return _mm_srai_epi32 (_mm_unpacklo_epi16 (value, value), 16) ;
+} /* bes_decode_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+lei_decode_sse (const unsigned char *ptr)
+{	return _mm_loadu_si128 ((const __m128i *) ptr) ;
+} /* lei_decode_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+pcm_bswap32_sse (__m128i value)
+{	return _mm_or_si128 (
+				_mm_or_si128 (_mm_slli_epi32 (value, 24), _mm_srli_epi32 (value, 24)),
+				_mm_or_si128 (_mm_and_si128 (_mm_slli_epi32 (value, 8), _mm_set1_epi32 (0x00FF0000)),
+					_mm_and_si128 (_mm_srli_epi32 (value, 8), _mm_set1_epi32 (0x0000FF00)))) ;
+} /* pcm_bswap32_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+bei_decode_sse (const unsigned char *ptr)
+{	return pcm_bswap32_sse (_mm_loadu_si128 ((const __m128i *) ptr)) ;
+} /* bei_decode_sse */
+
+static inline PCM_TARGET_SSSE3 __m128i
+let_decode_ssse3 (const unsigned char *ptr)
+{	const __m128i shuffle = _mm_setr_epi8 (-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11) ;
+
+	return _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) ptr), shuffle) ;
+} /* let_decode_ssse3 */
+
+static inline PCM_TARGET_SSSE3 __m128i
+bet_decode_ssse3 (const unsigned char *ptr)
+{	const __m128i shuffle = _mm_setr_epi8 (-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9) ;
+
+	return _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) ptr), shuffle) ;
+} /* bet_decode_ssse3 */
+
+static inline PCM_TARGET_AVX2 __m256i
+sc_decode_avx2 (const unsigned char *ptr)
+{	return _mm256_cvtepi8_epi32 (_mm_loadl_epi64 ((const __m128i *) ptr)) ;
+} /* sc_decode_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+uc_decode_avx2 (const unsigned char *ptr)
+{	return _mm256_sub_epi32 (_mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) ptr)), _mm256_set1_epi32 (128)) ;
+} /* uc_decode_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+les_decode_avx2 (const unsigned char *ptr)
+{	return _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i *) ptr)) ;
+} /* les_decode_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+bes_decode_avx2 (const unsigned char *ptr)
+{	const __m128i shuffle = _mm_setr_epi8 (1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) ;
+
+	return _mm256_cvtepi16_epi32 (_mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) ptr), shuffle)) ;
+} /* bes_decode_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+lei_decode_avx2 (const unsigned char *ptr)
+{	return _mm256_loadu_si256 ((const __m256i *) ptr) ;
+} /* lei_decode_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+bei_decode_avx2 (const unsigned char *ptr)
+{	const __m256i shuffle = _mm256_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+								3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12) ;
+
+	return _mm256_shuffle_epi8 (_mm256_loadu_si256 ((const __m256i *) ptr), shuffle) ;
+} /* bei_decode_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+let_decode_avx2 (const unsigned char *ptr)
+{	const __m256i shuffle = _mm256_setr_epi8 (-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+								-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11) ;
+	__m256i value ;
+
+	value = _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) ptr)) ;
+	value = _mm256_inserti128_si256 (value, _mm_loadu_si128 ((const __m128i *) (ptr + 12)), 1) ;
+	return _mm256_shuffle_epi8 (value, shuffle) ;
+} /* let_decode_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+bet_decode_avx2 (const unsigned char *ptr)
+{	const __m256i shuffle = _mm256_setr_epi8 (-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+								-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9) ;
+	__m256i value ;
+
+	value = _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) ptr)) ;
+	value = _mm256_inserti128_si256 (value, _mm_loadu_si128 ((const __m128i *) (ptr + 12)), 1) ;
+	return _mm256_shuffle_epi8 (value, shuffle) ;
+} /* bet_decode_avx2 */
+
+/*
+** Kernel generators. bytes is the size of one sample in the file, safe is the
+** number of samples that must be left for one decoder call to stay in bounds.
+*/
+
+#define	PCM_SSE_READ_KERNELS(prefix, srctype, bytes, safe, decode, target)			\
+static target void																	\
+prefix##2f_sse (srctype *src, int count, float *dest, float normfact)				\
+{	const unsigned char	*ucptr = (const unsigned char *) src ;						\
+	__m128				scale = _mm_set1_ps (normfact) ;							\
+	int					k = 0 ;														\
+																					\
+	for ( ; k + (safe) <= count ; k += 4)											\
+		_mm_storeu_ps (dest + k, _mm_mul_ps (_mm_cvtepi32_ps (decode (ucptr + k * (bytes))), scale)) ;	\
+																					\
+	prefix##2f_array ((srctype *) (ucptr + k * (bytes)), count - k, dest + k, normfact) ;	\
+} 																					\
+																					\
+static target void																	\
+prefix##2d_sse (srctype *src, int count, double *dest, double normfact)				\
+{	const unsigned char	*ucptr = (const unsigned char *) src ;						\
+	__m128d				scale = _mm_set1_pd (normfact) ;							\
+	__m128i				value ;														\
+	int					k = 0 ;														\
+																					\
+	for ( ; k + (safe) <= count ; k += 4)											\
+	{	value = decode (ucptr + k * (bytes)) ;										\
+		_mm_storeu_pd (dest + k, _mm_mul_pd (_mm_cvtepi32_pd (value), scale)) ;		\
+		_mm_storeu_pd (dest + k + 2, _mm_mul_pd (_mm_cvtepi32_pd (_mm_shuffle_epi32 (value, 0xEE)), scale)) ;	\
+		} ;																			\
+																					\
+	prefix##2d_array ((srctype *) (ucptr + k * (bytes)), count - k, dest + k, normfact) ;	\
+}
+
+#define	PCM_AVX2_READ_KERNELS(prefix, srctype, bytes, safe)							\
+static PCM_TARGET_AVX2 void															\
+prefix##2f_avx2 (srctype *src, int count, float *dest, float normfact)				\
+{	const unsigned char	*ucptr = (const unsigned char *) src ;						\
+	__m256				scale = _mm256_set1_ps (normfact) ;							\
+	int					k = 0 ;														\
+																					\
+	for ( ; k + (safe) <= count ; k += 8)											\
+		_mm256_storeu_ps (dest + k, _mm256_mul_ps (_mm256_cvtepi32_ps (prefix##_decode_avx2 (ucptr + k * (bytes))), scale)) ;	\
+																					\
+	prefix##2f_array ((srctype *) (ucptr + k * (bytes)), count - k, dest + k, normfact) ;	\
+} 																					\
+																					\
+static PCM_TARGET_AVX2 void															\
+prefix##2d_avx2 (srctype *src, int count, double *dest, double normfact)			\
+{	const unsigned char	*ucptr = (const unsigned char *) src ;						\
+	__m256d				scale = _mm256_set1_pd (normfact) ;							\
+	__m256i				value ;														\
+	int					k = 0 ;														\
+																					\
+	for ( ; k + (safe) <= count ; k += 8)											\
+	{	value = prefix##_decode_avx2 (ucptr + k * (bytes)) ;						\
+		_mm256_storeu_pd (dest + k, _mm256_mul_pd (_mm256_cvtepi32_pd (_mm256_castsi256_si128 (value)), scale)) ;	\
+		_mm256_storeu_pd (dest + k + 4, _mm256_mul_pd (_mm256_cvtepi32_pd (_mm256_extracti128_si256 (value, 1)), scale)) ;	\
+		} ;																			\
+																					\
+	prefix##2d_array ((srctype *) (ucptr + k * (bytes)), count - k, dest + k, normfact) ;	\
+}
+
+#define	PCM_READ_DISPATCH(prefix, srctype, sse_level)								\
+static inline void																	\
+prefix##2f_convert (srctype *src, int count, float *dest, float normfact)			\
+{	int level = pcm_simd_level () ;												\
+																					\
+	if (level >= PCM_SIMD_AVX2)														\
+		prefix##2f_avx2 (src, count, dest, normfact) ;								\
+	else if (level >= (sse_level))													\
+		prefix##2f_sse (src, count, dest, normfact) ;								\
+	else																			\
+		prefix##2f_array (src, count, dest, normfact) ;								\
+} 																					\
+																					\
+static inline void																	\
+prefix##2d_convert (srctype *src, int count, double *dest, double normfact)		\
+{	int level = pcm_simd_level () ;												\
+																					\
+	if (level >= PCM_SIMD_AVX2)														\
+		prefix##2d_avx2 (src, count, dest, normfact) ;								\
+	else if (level >= (sse_level))													\
+		prefix##2d_sse (src, count, dest, normfact) ;								\
+	else																			\
+		prefix##2d_array (src, count, dest, normfact) ;								\
+}
+
+PCM_SSE_READ_KERNELS (sc, signed char, 1, 4, sc_decode_sse, PCM_TARGET_SSE2)
+PCM_SSE_READ_KERNELS (uc, unsigned char, 1, 4, uc_decode_sse, PCM_TARGET_SSE2)
+PCM_SSE_READ_KERNELS (les, short, 2, 4, les_decode_sse, PCM_TARGET_SSE2)
+PCM_SSE_READ_KERNELS (bes, short, 2, 4, bes_decode_sse, PCM_TARGET_SSE2)
+PCM_SSE_READ_KERNELS (let, tribyte, 3, 6, let_decode_ssse3, PCM_TARGET_SSSE3)
+PCM_SSE_READ_KERNELS (bet, tribyte, 3, 6, bet_decode_ssse3, PCM_TARGET_SSSE3)
+PCM_SSE_READ_KERNELS (lei, int, 4, 4, lei_decode_sse, PCM_TARGET_SSE2)
+PCM_SSE_READ_KERNELS (bei, int, 4, 4, bei_decode_sse, PCM_TARGET_SSE2)
+
+PCM_AVX2_READ_KERNELS (sc, signed char, 1, 8)
+PCM_AVX2_READ_KERNELS (uc, unsigned char, 1, 8)
+PCM_AVX2_READ_KERNELS (les, short, 2, 8)
+PCM_AVX2_READ_KERNELS (bes, short, 2, 8)
+PCM_AVX2_READ_KERNELS (let, tribyte, 3, 10)
+PCM_AVX2_READ_KERNELS (bet, tribyte, 3, 10)
+PCM_AVX2_READ_KERNELS (lei, int, 4, 8)
+PCM_AVX2_READ_KERNELS (bei, int, 4, 8)
+
+PCM_READ_DISPATCH (sc, signed char, PCM_SIMD_SSE2)
+PCM_READ_DISPATCH (uc, unsigned char, PCM_SIMD_SSE2)
+PCM_READ_DISPATCH (les, short, PCM_SIMD_SSE2)
+PCM_READ_DISPATCH (bes, short, PCM_SIMD_SSE2)
+PCM_READ_DISPATCH (let, tribyte, PCM_SIMD_SSSE3)
+PCM_READ_DISPATCH (bet, tribyte, PCM_SIMD_SSSE3)
+PCM_READ_DISPATCH (lei, int, PCM_SIMD_SSE2)
+PCM_READ_DISPATCH (bei, int, PCM_SIMD_SSE2)
+
+#else /* PCM_X86_SIMD */
+
+#define	PCM_READ_DISPATCH(prefix, srctype)											\
+static inline void																	\
+prefix##2f_convert (srctype *src, int count, float *dest, float normfact)			\
+{	prefix##2f_array (src, count, dest, normfact) ;									\
+} 																					\
+																					\
+static inline void																	\
+prefix##2d_convert (srctype *src, int count, double *dest, double normfact)		\
+{	prefix##2d_array (src, count, dest, normfact) ;									\
+}
+
+PCM_READ_DISPATCH (sc, signed char)
+PCM_READ_DISPATCH (uc, unsigned char)
+PCM_READ_DISPATCH (les, short)
+PCM_READ_DISPATCH (bes, short)
+PCM_READ_DISPATCH (let, tribyte)
+PCM_READ_DISPATCH (bet, tribyte)
+PCM_READ_DISPATCH (lei, int)
+PCM_READ_DISPATCH (bei, int)
+
+#endif /* PCM_X86_SIMD */
+
 /*--------------------------------------------------------------------------
 */
 
@@ -1034,7 +1381,7 @@ pcm_read_sc2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.scbuf, sizeof (signed char), bufferlen, psf) ;
-		sc2f_array (ubuf.scbuf, readcount, ptr + total, normfact) ;
+		sc2f_convert (ubuf.scbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1059,7 +1406,7 @@ pcm_read_uc2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ucbuf, sizeof (unsigned char), bufferlen, psf) ;
-		uc2f_array (ubuf.ucbuf, readcount, ptr + total, normfact) ;
+		uc2f_convert (ubuf.ucbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1084,7 +1431,7 @@ pcm_read_bes2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.sbuf, sizeof (short), bufferlen, psf) ;
-		bes2f_array (ubuf.sbuf, readcount, ptr + total, normfact) ;
+		bes2f_convert (ubuf.sbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1109,7 +1456,7 @@ pcm_read_les2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.sbuf, sizeof (short), bufferlen, psf) ;
-		les2f_array (ubuf.sbuf, readcount, ptr + total, normfact) ;
+		les2f_convert (ubuf.sbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1135,7 +1482,7 @@ pcm_read_bet2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen, psf) ;
-		bet2f_array ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
+		bet2f_convert ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1161,7 +1508,7 @@ pcm_read_let2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen, psf) ;
-		let2f_array ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
+		let2f_convert ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1186,7 +1533,7 @@ pcm_read_bei2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ibuf, sizeof (int), bufferlen, psf) ;
-		bei2f_array (ubuf.ibuf, readcount, ptr + total, normfact) ;
+		bei2f_convert (ubuf.ibuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1211,7 +1558,7 @@ pcm_read_lei2f (SF_PRIVATE *psf, float *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ibuf, sizeof (int), bufferlen, psf) ;
-		lei2f_array (ubuf.ibuf, readcount, ptr + total, normfact) ;
+		lei2f_convert (ubuf.ibuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1239,7 +1586,7 @@ pcm_read_sc2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.scbuf, sizeof (signed char), bufferlen, psf) ;
-		sc2d_array (ubuf.scbuf, readcount, ptr + total, normfact) ;
+		sc2d_convert (ubuf.scbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1264,7 +1611,7 @@ pcm_read_uc2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ucbuf, sizeof (unsigned char), bufferlen, psf) ;
-		uc2d_array (ubuf.ucbuf, readcount, ptr + total, normfact) ;
+		uc2d_convert (ubuf.ucbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1289,7 +1636,7 @@ pcm_read_bes2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.sbuf, sizeof (short), bufferlen, psf) ;
-		bes2d_array (ubuf.sbuf, readcount, ptr + total, normfact) ;
+		bes2d_convert (ubuf.sbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1314,7 +1661,7 @@ pcm_read_les2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.sbuf, sizeof (short), bufferlen, psf) ;
-		les2d_array (ubuf.sbuf, readcount, ptr + total, normfact) ;
+		les2d_convert (ubuf.sbuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1339,7 +1686,7 @@ pcm_read_bet2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen, psf) ;
-		bet2d_array ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
+		bet2d_convert ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1365,7 +1712,7 @@ pcm_read_let2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ucbuf, SIZEOF_TRIBYTE, bufferlen, psf) ;
-		let2d_array ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
+		let2d_convert ((tribyte*) (ubuf.ucbuf), readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1390,7 +1737,7 @@ pcm_read_bei2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ibuf, sizeof (int), bufferlen, psf) ;
-		bei2d_array (ubuf.ibuf, readcount, ptr + total, normfact) ;
+		bei2d_convert (ubuf.ibuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1415,7 +1762,7 @@ pcm_read_lei2d (SF_PRIVATE *psf, double *ptr, sf_count_t len)
 	{	if (len < bufferlen)
 			bufferlen = (int) len ;
 		readcount = psf_fread (ubuf.ibuf, sizeof (int), bufferlen, psf) ;
-		lei2d_array (ubuf.ibuf, readcount, ptr + total, normfact) ;
+		lei2d_convert (ubuf.ibuf, readcount, ptr + total, normfact) ;
 		total += readcount ;
 		if (readcount < bufferlen)
 			break ;
@@ -1974,7 +2321,7 @@ pcm_write_f2bes	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? f2bes_clip_array : f2bes_array ;
+	convert = (psf->add_clipping) ? f2bes_clip_convert : f2bes_convert ;
 	bufferlen = ARRAY_LEN (ubuf.sbuf) ;
 
 	while (len > 0)
@@ -2047,7 +2394,7 @@ pcm_write_f2les	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? f2les_clip_array : f2les_array ;
+	convert = (psf->add_clipping) ? f2les_clip_convert : f2les_convert ;
 	bufferlen = ARRAY_LEN (ubuf.sbuf) ;
 
 	while (len > 0)
@@ -2124,7 +2471,7 @@ pcm_write_f2let	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? f2let_clip_array : f2let_array ;
+	convert = (psf->add_clipping) ? f2let_clip_convert : f2let_convert ;
 	bufferlen = sizeof (ubuf.ucbuf) / SIZEOF_TRIBYTE ;
 
 	while (len > 0)
@@ -2201,7 +2548,7 @@ pcm_write_f2bet	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? f2bet_clip_array : f2bet_array ;
+	convert = (psf->add_clipping) ? f2bet_clip_convert : f2bet_convert ;
 	bufferlen = sizeof (ubuf.ucbuf) / SIZEOF_TRIBYTE ;
 
 	while (len > 0)
@@ -2281,7 +2628,7 @@ pcm_write_f2bei	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? f2bei_clip_array : f2bei_array ;
+	convert = (psf->add_clipping) ? f2bei_clip_convert : f2bei_convert ;
 	bufferlen = ARRAY_LEN (ubuf.ibuf) ;
 
 	while (len > 0)
@@ -2362,7 +2709,7 @@ pcm_write_f2lei	(SF_PRIVATE *psf, const float *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? f2lei_clip_array : f2lei_array ;
+	convert = (psf->add_clipping) ? f2lei_clip_convert : f2lei_convert ;
 	bufferlen = ARRAY_LEN (ubuf.ibuf) ;
 
 	while (len > 0)
@@ -2553,7 +2900,7 @@ pcm_write_d2bes	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? d2bes_clip_array : d2bes_array ;
+	convert = (psf->add_clipping) ? d2bes_clip_convert : d2bes_convert ;
 	bufferlen = ARRAY_LEN (ubuf.sbuf) ;
 
 	while (len > 0)
@@ -2626,7 +2973,7 @@ pcm_write_d2les	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? d2les_clip_array : d2les_array ;
+	convert = (psf->add_clipping) ? d2les_clip_convert : d2les_convert ;
 	bufferlen = ARRAY_LEN (ubuf.sbuf) ;
 
 	while (len > 0)
@@ -2703,7 +3050,7 @@ pcm_write_d2let	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? d2let_clip_array : d2let_array ;
+	convert = (psf->add_clipping) ? d2let_clip_convert : d2let_convert ;
 	bufferlen = sizeof (ubuf.ucbuf) / SIZEOF_TRIBYTE ;
 
 	while (len > 0)
@@ -2780,7 +3127,7 @@ pcm_write_d2bet	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? d2bet_clip_array : d2bet_array ;
+	convert = (psf->add_clipping) ? d2bet_clip_convert : d2bet_convert ;
 	bufferlen = sizeof (ubuf.ucbuf) / SIZEOF_TRIBYTE ;
 
 	while (len > 0)
@@ -2861,7 +3208,7 @@ pcm_write_d2bei	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? d2bei_clip_array : d2bei_array ;
+	convert = (psf->add_clipping) ? d2bei_clip_convert : d2bei_convert ;
 	bufferlen = ARRAY_LEN (ubuf.ibuf) ;
 
 	while (len > 0)
@@ -2942,7 +3289,7 @@ pcm_write_d2lei	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	int			bufferlen, writecount ;
 	sf_count_t	total = 0 ;
 
-	convert = (psf->add_clipping) ? d2lei_clip_array : d2lei_array ;
+	convert = (psf->add_clipping) ? d2lei_clip_convert : d2lei_convert ;
 	bufferlen = ARRAY_LEN (ubuf.ibuf) ;
 
 	while (len > 0)
@@ -2959,3 +3306,347 @@ pcm_write_d2lei	(SF_PRIVATE *psf, const double *ptr, sf_count_t len)
 	return total ;
 } /* pcm_write_d2lei */
 
+
+/*--------------------------------------------------------------------------
+** Vectorised versions of the float/double to 16, 24 and 32 bit converters.
+**
+** The kernels scale, round (with the current rounding mode, like lrint)
+** and saturate four or eight samples at a time and then narrow and byte
+** swap them in registers, so the 24 bit formats are packed with a shuffle
+** instead of three byte stores per sample.
+**
+** On x86-64 lrint returns a 64 bit long which the scalar code truncates to
+** an int. The clipping converters never leave the int range except for
+** NaNs, which truncate to 0. The non clipping converters can overflow, so
+** any group of samples that converted to INT_MIN is redone with the scalar
+** converter. That keeps the output bit for bit the same as before. 32 bit
+** x86 builds (32 bit lrint, possibly x87 maths) stay on the scalar path.
+*/
+
+#if PCM_X86_SIMD && defined (__x86_64__)
+
+#define	PCM_INT_MIN		(-0x7FFFFFFF - 1)
+
+static inline PCM_TARGET_SSE2 __m128i
+f2i_sse (const float *src, float normfact)
+{	return _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (src), _mm_set1_ps (normfact))) ;
+} /* f2i_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+f2i_clip_sse (const float *src, float normfact)
+{	__m128	scaled = _mm_mul_ps (_mm_loadu_ps (src), _mm_set1_ps (normfact)) ;
+	__m128i	value = _mm_cvtps_epi32 (scaled) ;
+
+	/* Overflowing lanes convert to INT_MIN, flipping every bit gives INT_MAX. */
+	value = _mm_xor_si128 (value, _mm_castps_si128 (_mm_cmpge_ps (scaled, _mm_set1_ps (2147483648.0f)))) ;
+	return _mm_andnot_si128 (_mm_castps_si128 (_mm_cmpunord_ps (scaled, scaled)), value) ;
+} /* f2i_clip_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+d2i_sse (const double *src, double normfact)
+{	__m128d	scale = _mm_set1_pd (normfact) ;
+
+	return _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (_mm_mul_pd (_mm_loadu_pd (src), scale)),
+				_mm_cvtpd_epi32 (_mm_mul_pd (_mm_loadu_pd (src + 2), scale))) ;
+} /* d2i_sse */
+
+static inline PCM_TARGET_SSE2 __m128i
+d2i_clip_sse (const double *src, double normfact)
+{	__m128d	scale = _mm_set1_pd (normfact), limit = _mm_set1_pd (1.0 * 0x7FFFFFFF) ;
+	__m128d	low = _mm_mul_pd (_mm_loadu_pd (src), scale) ;
+	__m128d	high = _mm_mul_pd (_mm_loadu_pd (src + 2), scale) ;
+
+	low = _mm_min_pd (limit, _mm_and_pd (low, _mm_cmpord_pd (low, low))) ;
+	high = _mm_min_pd (limit, _mm_and_pd (high, _mm_cmpord_pd (high, high))) ;
+	return _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (low), _mm_cvtpd_epi32 (high)) ;
+} /* d2i_clip_sse */
+
+static inline PCM_TARGET_AVX2 __m256i
+f2i_avx2 (const float *src, float normfact)
+{	return _mm256_cvtps_epi32 (_mm256_mul_ps (_mm256_loadu_ps (src), _mm256_set1_ps (normfact))) ;
+} /* f2i_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+f2i_clip_avx2 (const float *src, float normfact)
+{	__m256	scaled = _mm256_mul_ps (_mm256_loadu_ps (src), _mm256_set1_ps (normfact)) ;
+	__m256i	value = _mm256_cvtps_epi32 (scaled) ;
+
+	value = _mm256_xor_si256 (value, _mm256_castps_si256 (_mm256_cmp_ps (scaled, _mm256_set1_ps (2147483648.0f), _CMP_GE_OQ))) ;
+	return _mm256_andnot_si256 (_mm256_castps_si256 (_mm256_cmp_ps (scaled, scaled, _CMP_UNORD_Q)), value) ;
+} /* f2i_clip_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+d2i_avx2 (const double *src, double normfact)
+{	__m256d	scale = _mm256_set1_pd (normfact) ;
+	__m256i	value ;
+
+	value = _mm256_castsi128_si256 (_mm256_cvtpd_epi32 (_mm256_mul_pd (_mm256_loadu_pd (src), scale))) ;
+	return _mm256_inserti128_si256 (value, _mm256_cvtpd_epi32 (_mm256_mul_pd (_mm256_loadu_pd (src + 4), scale)), 1) ;
+} /* d2i_avx2 */
+
+static inline PCM_TARGET_AVX2 __m256i
+d2i_clip_avx2 (const double *src, double normfact)
+{	__m256d	scale = _mm256_set1_pd (normfact), limit = _mm256_set1_pd (1.0 * 0x7FFFFFFF) ;
+	__m256d	low = _mm256_mul_pd (_mm256_loadu_pd (src), scale) ;
+	__m256d	high = _mm256_mul_pd (_mm256_loadu_pd (src + 4), scale) ;
+	__m256i	value ;
+
+	low = _mm256_min_pd (limit, _mm256_and_pd (low, _mm256_cmp_pd (low, low, _CMP_ORD_Q))) ;
+	high = _mm256_min_pd (limit, _mm256_and_pd (high, _mm256_cmp_pd (high, high, _CMP_ORD_Q))) ;
+	value = _mm256_castsi128_si256 (_mm256_cvtpd_epi32 (low)) ;
+	return _mm256_inserti128_si256 (value, _mm256_cvtpd_epi32 (high), 1) ;
+} /* d2i_clip_avx2 */
+
+/*
+** Each encoder stores the low 2, 3 or 4 bytes of every int in the given byte
+** order, exactly like the scalar converters store their value.
+*/
+
+static inline PCM_TARGET_SSE2 void
+les_encode_sse (unsigned char *ptr, __m128i value)
+{	value = _mm_srai_epi32 (_mm_slli_epi32 (value, 16), 16) ;
+	_mm_storel_epi64 ((__m128i *) ptr, _mm_packs_epi32 (value, value)) ;
+} /* les_encode_sse */
+
+static inline PCM_TARGET_SSE2 void
+bes_encode_sse (unsigned char *ptr, __m128i value)
+{	value = _mm_srai_epi32 (_mm_slli_epi32 (value, 16), 16) ;
+	value = _mm_packs_epi32 (value, value) ;
+	value = _mm_or_si128 (_mm_slli_epi16 (value, 8), _mm_srli_epi16 (value, 8)) ;
+	_mm_storel_epi64 ((__m128i *) ptr, value) ;
+} /* bes_encode_sse */
+
+static inline PCM_TARGET_SSSE3 void
+tribyte_store_ssse3 (unsigned char *ptr, __m128i packed)
+{	int32_t last = _mm_cvtsi128_si32 (_mm_srli_si128 (packed, 8)) ;
+
+	_mm_storel_epi64 ((__m128i *) ptr, packed) ;
+	memcpy (ptr + 8, &last, 4) ;
+} /* tribyte_store_ssse3 */
+
+static inline PCM_TARGET_SSSE3 void
+let_encode_ssse3 (unsigned char *ptr, __m128i value)
+{	const __m128i shuffle = _mm_setr_epi8 (0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1) ;
+
+	tribyte_store_ssse3 (ptr, _mm_shuffle_epi8 (value, shuffle)) ;
+} /* let_encode_ssse3 */
+
+static inline PCM_TARGET_SSSE3 void
+bet_encode_ssse3 (unsigned char *ptr, __m128i value)
+{	const __m128i shuffle = _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1) ;
+
+	tribyte_store_ssse3 (ptr, _mm_shuffle_epi8 (value, shuffle)) ;
+} /* bet_encode_ssse3 */
+
+static inline PCM_TARGET_SSE2 void
+lei_encode_sse (unsigned char *ptr, __m128i value)
+{	_mm_storeu_si128 ((__m128i *) ptr, value) ;
+} /* lei_encode_sse */
+
+static inline PCM_TARGET_SSE2 void
+bei_encode_sse (unsigned char *ptr, __m128i value)
+{	_mm_storeu_si128 ((__m128i *) ptr, pcm_bswap32_sse (value)) ;
+} /* bei_encode_sse */
+
+static inline PCM_TARGET_AVX2 __m128i
+shorts_pack_avx2 (__m256i value)
+{	value = _mm256_srai_epi32 (_mm256_slli_epi32 (value, 16), 16) ;
+	return _mm_packs_epi32 (_mm256_castsi256_si128 (value), _mm256_extracti128_si256 (value, 1)) ;
+} /* shorts_pack_avx2 */
+
+static inline PCM_TARGET_AVX2 void
+les_encode_avx2 (unsigned char *ptr, __m256i value)
+{	_mm_storeu_si128 ((__m128i *) ptr, shorts_pack_avx2 (value)) ;
+} /* les_encode_avx2 */
+
+static inline PCM_TARGET_AVX2 void
+bes_encode_avx2 (unsigned char *ptr, __m256i value)
+{	const __m128i shuffle = _mm_setr_epi8 (1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) ;
+
+	_mm_storeu_si128 ((__m128i *) ptr, _mm_shuffle_epi8 (shorts_pack_avx2 (value), shuffle)) ;
+} /* bes_encode_avx2 */
+
+static inline PCM_TARGET_AVX2 void
+tribyte_store_avx2 (unsigned char *ptr, __m256i packed)
+{	/* Each half holds 12 packed bytes, move them next to each other. */
+	packed = _mm256_permutevar8x32_epi32 (packed, _mm256_setr_epi32 (0, 1, 2, 4, 5, 6, 3, 7)) ;
+	_mm_storeu_si128 ((__m128i *) ptr, _mm256_castsi256_si128 (packed)) ;
+	_mm_storel_epi64 ((__m128i *) (ptr + 16), _mm256_extracti128_si256 (packed, 1)) ;
+} /* tribyte_store_avx2 */
+
+static inline PCM_TARGET_AVX2 void
+let_encode_avx2 (unsigned char *ptr, __m256i value)
+{	const __m256i shuffle = _mm256_setr_epi8 (0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+								0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1) ;
+
+	tribyte_store_avx2 (ptr, _mm256_shuffle_epi8 (value, shuffle)) ;
+} /* let_encode_avx2 */
+
+static inline PCM_TARGET_AVX2 void
+bet_encode_avx2 (unsigned char *ptr, __m256i value)
+{	const __m256i shuffle = _mm256_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+								2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1) ;
+
+	tribyte_store_avx2 (ptr, _mm256_shuffle_epi8 (value, shuffle)) ;
+} /* bet_encode_avx2 */
+
+static inline PCM_TARGET_AVX2 void
+lei_encode_avx2 (unsigned char *ptr, __m256i value)
+{	_mm256_storeu_si256 ((__m256i *) ptr, value) ;
+} /* lei_encode_avx2 */
+
+static inline PCM_TARGET_AVX2 void
+bei_encode_avx2 (unsigned char *ptr, __m256i value)
+{	const __m256i shuffle = _mm256_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+								3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12) ;
+
+	_mm256_storeu_si256 ((__m256i *) ptr, _mm256_shuffle_epi8 (value, shuffle)) ;
+} /* bei_encode_avx2 */
+
+/*
+** Kernel generators. max and clipfact are the normfacts of the scalar
+** converters, shift moves a clipped 32 bit value down to the file's width.
+*/
+
+#define	PCM_WRITE_KERNELS(s, srctype, prefix, desttype, bytes, max, clipfact, shift, sse_encode, sse_target)	\
+static sse_target void																\
+s##2##prefix##_sse (const srctype *src, desttype *dest, int count, int normalize)	\
+{	unsigned char	*ucptr = (unsigned char *) dest ;								\
+	srctype			normfact = normalize ? (1.0 * (max)) : 1.0 ;					\
+	__m128i			value ;															\
+	int				k = 0 ;															\
+																					\
+	for ( ; k + 4 <= count ; k += 4)												\
+	{	value = s##2i_sse (src + k, normfact) ;										\
+		if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (value, _mm_set1_epi32 (PCM_INT_MIN))))	\
+			s##2##prefix##_array (src + k, (desttype *) (ucptr + k * (bytes)), 4, normalize) ;	\
+		else																		\
+			sse_encode (ucptr + k * (bytes), value) ;								\
+		} ;																			\
+																					\
+	s##2##prefix##_array (src + k, (desttype *) (ucptr + k * (bytes)), count - k, normalize) ;	\
+} 																					\
+																					\
+static sse_target void																\
+s##2##prefix##_clip_sse (const srctype *src, desttype *dest, int count, int normalize)	\
+{	unsigned char	*ucptr = (unsigned char *) dest ;								\
+	srctype			normfact = normalize ? (8.0 * 0x10000000) : (1.0 * (clipfact)) ;	\
+	int				k = 0 ;															\
+																					\
+	for ( ; k + 4 <= count ; k += 4)												\
+		sse_encode (ucptr + k * (bytes), _mm_srai_epi32 (s##2i_clip_sse (src + k, normfact), (shift))) ;	\
+																					\
+	s##2##prefix##_clip_array (src + k, (desttype *) (ucptr + k * (bytes)), count - k, normalize) ;	\
+} 																					\
+																					\
+static PCM_TARGET_AVX2 void															\
+s##2##prefix##_avx2 (const srctype *src, desttype *dest, int count, int normalize)	\
+{	unsigned char	*ucptr = (unsigned char *) dest ;								\
+	srctype			normfact = normalize ? (1.0 * (max)) : 1.0 ;					\
+	__m256i			value ;															\
+	int				k = 0 ;															\
+																					\
+	for ( ; k + 8 <= count ; k += 8)												\
+	{	value = s##2i_avx2 (src + k, normfact) ;									\
+		if (_mm256_movemask_epi8 (_mm256_cmpeq_epi32 (value, _mm256_set1_epi32 (PCM_INT_MIN))))	\
+			s##2##prefix##_array (src + k, (desttype *) (ucptr + k * (bytes)), 8, normalize) ;	\
+		else																		\
+			prefix##_encode_avx2 (ucptr + k * (bytes), value) ;						\
+		} ;																			\
+																					\
+	s##2##prefix##_array (src + k, (desttype *) (ucptr + k * (bytes)), count - k, normalize) ;	\
+} 																					\
+																					\
+static PCM_TARGET_AVX2 void															\
+s##2##prefix##_clip_avx2 (const srctype *src, desttype *dest, int count, int normalize)	\
+{	unsigned char	*ucptr = (unsigned char *) dest ;								\
+	srctype			normfact = normalize ? (8.0 * 0x10000000) : (1.0 * (clipfact)) ;	\
+	int				k = 0 ;															\
+																					\
+	for ( ; k + 8 <= count ; k += 8)												\
+		prefix##_encode_avx2 (ucptr + k * (bytes), _mm256_srai_epi32 (s##2i_clip_avx2 (src + k, normfact), (shift))) ;	\
+																					\
+	s##2##prefix##_clip_array (src + k, (desttype *) (ucptr + k * (bytes)), count - k, normalize) ;	\
+}
+
+#define	PCM_WRITE_DISPATCH(s, srctype, prefix, desttype, sse_level)				\
+static void																			\
+s##2##prefix##_convert (const srctype *src, desttype *dest, int count, int normalize)	\
+{	int level = pcm_simd_level () ;												\
+																					\
+	if (level >= PCM_SIMD_AVX2)														\
+		s##2##prefix##_avx2 (src, dest, count, normalize) ;							\
+	else if (level >= (sse_level))													\
+		s##2##prefix##_sse (src, dest, count, normalize) ;							\
+	else																			\
+		s##2##prefix##_array (src, dest, count, normalize) ;						\
+} 																					\
+																					\
+static void																			\
+s##2##prefix##_clip_convert (const srctype *src, desttype *dest, int count, int normalize)	\
+{	int level = pcm_simd_level () ;												\
+																					\
+	if (level >= PCM_SIMD_AVX2)														\
+		s##2##prefix##_clip_avx2 (src, dest, count, normalize) ;					\
+	else if (level >= (sse_level))													\
+		s##2##prefix##_clip_sse (src, dest, count, normalize) ;						\
+	else																			\
+		s##2##prefix##_clip_array (src, dest, count, normalize) ;					\
+}
+
+PCM_WRITE_KERNELS (f, float, bes, short, 2, 0x7FFF, 0x10000, 16, bes_encode_sse, PCM_TARGET_SSE2)
+PCM_WRITE_KERNELS (f, float, les, short, 2, 0x7FFF, 0x10000, 16, les_encode_sse, PCM_TARGET_SSE2)
+PCM_WRITE_KERNELS (f, float, bet, tribyte, 3, 0x7FFFFF, 0x100, 8, bet_encode_ssse3, PCM_TARGET_SSSE3)
+PCM_WRITE_KERNELS (f, float, let, tribyte, 3, 0x7FFFFF, 0x100, 8, let_encode_ssse3, PCM_TARGET_SSSE3)
+PCM_WRITE_KERNELS (f, float, bei, int, 4, 0x7FFFFFFF, 1, 0, bei_encode_sse, PCM_TARGET_SSE2)
+PCM_WRITE_KERNELS (f, float, lei, int, 4, 0x7FFFFFFF, 1, 0, lei_encode_sse, PCM_TARGET_SSE2)
+
+PCM_WRITE_KERNELS (d, double, bes, short, 2, 0x7FFF, 0x10000, 16, bes_encode_sse, PCM_TARGET_SSE2)
+PCM_WRITE_KERNELS (d, double, les, short, 2, 0x7FFF, 0x10000, 16, les_encode_sse, PCM_TARGET_SSE2)
+PCM_WRITE_KERNELS (d, double, bet, tribyte, 3, 0x7FFFFF, 0x100, 8, bet_encode_ssse3, PCM_TARGET_SSSE3)
+PCM_WRITE_KERNELS (d, double, let, tribyte, 3, 0x7FFFFF, 0x100, 8, let_encode_ssse3, PCM_TARGET_SSSE3)
+PCM_WRITE_KERNELS (d, double, bei, int, 4, 0x7FFFFFFF, 1, 0, bei_encode_sse, PCM_TARGET_SSE2)
+PCM_WRITE_KERNELS (d, double, lei, int, 4, 0x7FFFFFFF, 1, 0, lei_encode_sse, PCM_TARGET_SSE2)
+
+PCM_WRITE_DISPATCH (f, float, bes, short, PCM_SIMD_SSE2)
+PCM_WRITE_DISPATCH (f, float, les, short, PCM_SIMD_SSE2)
+PCM_WRITE_DISPATCH (f, float, bet, tribyte, PCM_SIMD_SSSE3)
+PCM_WRITE_DISPATCH (f, float, let, tribyte, PCM_SIMD_SSSE3)
+PCM_WRITE_DISPATCH (f, float, bei, int, PCM_SIMD_SSE2)
+PCM_WRITE_DISPATCH (f, float, lei, int, PCM_SIMD_SSE2)
+
+PCM_WRITE_DISPATCH (d, double, bes, short, PCM_SIMD_SSE2)
+PCM_WRITE_DISPATCH (d, double, les, short, PCM_SIMD_SSE2)
+PCM_WRITE_DISPATCH (d, double, bet, tribyte, PCM_SIMD_SSSE3)
+PCM_WRITE_DISPATCH (d, double, let, tribyte, PCM_SIMD_SSSE3)
+PCM_WRITE_DISPATCH (d, double, bei, int, PCM_SIMD_SSE2)
+PCM_WRITE_DISPATCH (d, double, lei, int, PCM_SIMD_SSE2)
+
+#else /* PCM_X86_SIMD && __x86_64__ */
+
+#define	PCM_WRITE_DISPATCH(s, srctype, prefix, desttype)							\
+static void																			\
+s##2##prefix##_convert (const srctype *src, desttype *dest, int count, int normalize)	\
+{	s##2##prefix##_array (src, dest, count, normalize) ;							\
+} 																					\
+																					\
+static void																			\
+s##2##prefix##_clip_convert (const srctype *src, desttype *dest, int count, int normalize)	\
+{	s##2##prefix##_clip_array (src, dest, count, normalize) ;						\
+}
+
+PCM_WRITE_DISPATCH (f, float, bes, short)
+PCM_WRITE_DISPATCH (f, float, les, short)
+PCM_WRITE_DISPATCH (f, float, bet, tribyte)
+PCM_WRITE_DISPATCH (f, float, let, tribyte)
+PCM_WRITE_DISPATCH (f, float, bei, int)
+PCM_WRITE_DISPATCH (f, float, lei, int)
+
+PCM_WRITE_DISPATCH (d, double, bes, short)
+PCM_WRITE_DISPATCH (d, double, les, short)
+PCM_WRITE_DISPATCH (d, double, bet, tribyte)
+PCM_WRITE_DISPATCH (d, double, let, tribyte)
+PCM_WRITE_DISPATCH (d, double, bei, int)
+PCM_WRITE_DISPATCH (d, double, lei, int)
+
+#endif /* PCM_X86_SIMD && __x86_64__ */
@@ -286,6 +286,9 @@ static int	validate_psf (SF_PRIVATE *psf) ;
 static void	save_header_info (SF_PRIVATE *psf) ;
 static int	copy_filename (SF_PRIVATE *psf, const char *path) ;
 static int	psf_close (SF_PRIVATE *psf) ;
+static int	psf_build_seek_index (SF_PRIVATE *psf) ;
+static sf_count_t	planar_read_float (SF_PRIVATE *psf, float * const *ptr, sf_count_t frames) ;
+static sf_count_t	planar_write_float (SF_PRIVATE *psf, const float * const *ptr, sf_count_t frames) ;
 
 static int	try_resource_fork (SF_PRIVATE * psf) ;
 
@@ -419,6 +422,62 @@ sf_open_virtual	(SF_VIRTUAL_IO *sfvirtual, int mode, SF_INFO *sfinfo, void *user
 	return psf_open_file (psf, sfinfo) ;
 } /* sf_open_virtual */
 
+int
+sf_probe	(const char *path, SF_PROBE_INFO *probe)
+{	SF_PRIVATE 	*psf ;
+	const char	*str ;
+	size_t		len, used = 0 ;
+	int			k ;
+
+	if (probe == NULL)
+		return (sf_errno = SFE_BAD_SF_INFO_PTR) ;
+
+	memset (&probe->info, 0, sizeof (probe->info)) ;
+	for (k = SF_STR_FIRST ; k <= SF_STR_LAST ; k++)
+		probe->str_offset [k - SF_STR_FIRST] = -1 ;
+
+	if ((psf = psf_allocate ()) == NULL)
+		return (sf_errno = SFE_MALLOC_FAILED) ;
+
+	psf_init_files (psf) ;
+
+	/*
+	** The headers of most files fit in the first few kilobytes, so a full
+	** sized buffer would mostly be filled with audio data that is never
+	** looked at. Chunks further into the file still get read on demand.
+	** This only trims the header parsing: psf_open_file () below runs the
+	** codec set up as usual, which for FLAC and Ogg means starting the
+	** decoder and, for Vorbis, seeking to the last page for the length.
+	*/
+	psf->iobuf.size = SF_PROBE_HEAD_LEN ;
+	psf->no_parselog = SF_TRUE ;
+
+	psf->file.mode = SFM_READ ;
+	if (copy_filename (psf, path) == 0)
+		psf->error = psf_fopen (psf) ;
+
+	/* On failure psf_open_file () has already freed psf. */
+	if (psf_open_file (psf, &probe->info) == NULL)
+		return sf_errno ;
+
+	for (k = SF_STR_FIRST ; k <= SF_STR_LAST ; k++)
+	{	if ((str = psf_get_string (psf, k)) == NULL)
+			continue ;
+
+		len = strlen (str) + 1 ;
+		if (len > sizeof (probe->str_data) - used)
+			continue ;
+
+		memcpy (probe->str_data + used, str, len) ;
+		probe->str_offset [k - SF_STR_FIRST] = (int) used ;
+		used += len ;
+		} ;
+
+	psf_close (psf) ;
+
+	return 0 ;
+} /* sf_probe */
+
 int
 sf_close	(SNDFILE *sndfile)
 {	SF_PRIVATE	*psf ;
@@ -940,6 +999,10 @@ sf_command	(SNDFILE *sndfile, int command, void *data, int datasize)
 			return psf_get_format_info (data) ;
 		} ;
 
+	/* Library wide, returns the previous setting. */
+	if (sndfile == NULL && command == SFC_SET_CODEC_STATE_POOL)
+		return gsm610_set_pool (datasize) ;
+
 	if (sndfile == NULL && command == SFC_GET_LOG_INFO)
 	{	if (data == NULL)
 			return (sf_errno = SFE_BAD_COMMAND_PARAM) ;
@@ -1312,6 +1375,102 @@ sf_command	(SNDFILE *sndfile, int command, void *data, int datasize)
 		case SFC_RAW_DATA_NEEDS_ENDSWAP :
 			return psf->data_endswap ;
 
+		case SFC_GET_RAW_DATA_INFO :
+			if (data == NULL || datasize != SIGNED_SIZEOF (SF_RAW_DATA_INFO))
+				return (psf->error = SFE_BAD_COMMAND_PARAM) ;
+
+			/* Only plain interleaved integer and float data can be read directly. */
+			switch (SF_CONTAINER (psf->sf.format))
+			{	case SF_FORMAT_WAV :
+				case SF_FORMAT_WAVEX :
+				case SF_FORMAT_W64 :
+				case SF_FORMAT_RF64 :
+				case SF_FORMAT_AIFF :
+				case SF_FORMAT_AU :
+				case SF_FORMAT_CAF :
+				case SF_FORMAT_RAW :
+					break ;
+				default :
+					return SF_FALSE ;
+				} ;
+
+			switch (SF_CODEC (psf->sf.format))
+			{	case SF_FORMAT_PCM_S8 :
+				case SF_FORMAT_PCM_U8 :
+				case SF_FORMAT_PCM_16 :
+				case SF_FORMAT_PCM_24 :
+				case SF_FORMAT_PCM_32 :
+				case SF_FORMAT_FLOAT :
+				case SF_FORMAT_DOUBLE :
+					break ;
+				default :
+					return SF_FALSE ;
+				} ;
+
+			if (psf->file.mode != SFM_READ || psf->dataoffset < 0 || psf->datalength <= 0
+					|| psf->bytewidth <= 0)
+				return SF_FALSE ;
+
+			((SF_RAW_DATA_INFO*) data)->offset = psf->fileoffset + psf->dataoffset ;
+			((SF_RAW_DATA_INFO*) data)->length = psf->datalength ;
+			((SF_RAW_DATA_INFO*) data)->bytewidth = psf->bytewidth ;
+			((SF_RAW_DATA_INFO*) data)->endswap = psf->data_endswap ;
+			return SF_TRUE ;
+
+		case SFC_SET_IO_BUFFER_SIZE :
+			/* A datasize of zero turns buffering off. */
+			if (datasize < 0 || datasize > SF_IO_BUFFER_MAX)
+			{	psf->error = SFE_BAD_COMMAND_PARAM ;
+				return SF_FALSE ;
+				} ;
+
+			if ((psf->error = psf_set_io_buffer (psf, datasize)) != 0)
+				return SF_FALSE ;
+			return SF_TRUE ;
+
+		case SFC_GET_IO_BUFFER_SIZE :
+			return (int) psf->iobuf.size ;
+
+		case SFC_SET_IO_READAHEAD :
+			/* The number of buffer sized blocks to read in the background, 0 for none. */
+			if (datasize < 0 || datasize > SF_IO_READAHEAD_MAX)
+			{	psf->error = SFE_BAD_COMMAND_PARAM ;
+				return SF_FALSE ;
+				} ;
+
+			if ((psf->error = psf_set_io_readahead (psf, datasize)) != 0)
+				return SF_FALSE ;
+			return SF_TRUE ;
+
+		case SFC_GET_IO_READAHEAD :
+			return psf->iobuf.ahead ;
+
+		case SFC_SET_SEEK_INDEX_SIDECAR :
+			/* Keep the seek index of a FLAC or Vorbis file in "<path>.sfidx". */
+			if (psf->seekidx.enabled == 0 || psf->file.mode != SFM_READ)
+				return SF_FALSE ;
+
+			if ((psf->error = psf_seek_index_set_sidecar (psf, datasize)) != 0)
+				return SF_FALSE ;
+			return SF_TRUE ;
+
+		case SFC_BUILD_SEEK_INDEX :
+			if (psf->seekidx.enabled == 0 || psf->file.mode != SFM_READ)
+				return SF_FALSE ;
+
+			if ((psf->error = psf_build_seek_index (psf)) != 0)
+				return SF_FALSE ;
+			return SF_TRUE ;
+
+		case SFC_GET_IO_STATS :
+			if (data == NULL || datasize != SIGNED_SIZEOF (SF_IO_STATS))
+			{	psf->error = SFE_BAD_COMMAND_PARAM ;
+				return SF_FALSE ;
+				} ;
+
+			memcpy (data, &psf->io_stats, sizeof (SF_IO_STATS)) ;
+			return SF_TRUE ;
+
 		case SFC_GET_CHANNEL_MAP_INFO :
 			if (psf->channel_map == NULL)
 				return SF_FALSE ;
@@ -2567,10 +2726,200 @@ sf_writef_double	(SNDFILE *sndfile, const double *ptr, sf_count_t frames)
 	return count / psf->sf.channels ;
 } /* sf_writef_double */
 
+/*------------------------------------------------------------------------------
+** Planar read/write functions. Each channel has its own array of frames.
+*/
+
+sf_count_t
+sf_readf_float_planar	(SNDFILE *sndfile, float * const *ptr, sf_count_t frames)
+{	SF_PRIVATE 	*psf ;
+	sf_count_t	count ;
+	int			chan ;
+
+	if (frames == 0)
+		return 0 ;
+
+	VALIDATE_SNDFILE_AND_ASSIGN_PSF (sndfile, psf, 1) ;
+
+	if (frames <= 0)
+	{	psf->error = SFE_NEGATIVE_RW_LEN ;
+		return 0 ;
+		} ;
+
+	if (ptr == NULL)
+	{	psf->error = SFE_BAD_INT_PTR ;
+		return 0 ;
+		} ;
+
+	if (psf->file.mode == SFM_WRITE)
+	{	psf->error = SFE_NOT_READMODE ;
+		return 0 ;
+		} ;
+
+	if (psf->read_current >= psf->sf.frames)
+	{	for (chan = 0 ; chan < psf->sf.channels ; chan++)
+			psf_memset (ptr [chan], 0, frames * sizeof (float)) ;
+		return 0 ;
+		} ;
+
+	if (psf->read_float == NULL || psf->seek == NULL)
+	{	psf->error = SFE_UNIMPLEMENTED ;
+		return	0 ;
+		} ;
+
+	if (psf->last_op != SFM_READ)
+		if (psf->seek (psf, SFM_READ, psf->read_current) < 0)
+			return 0 ;
+
+	/* Files that already store each channel separately skip interleaving altogether. */
+	if (psf->read_float_planar != NULL)
+		count = psf->read_float_planar (psf, ptr, frames) ;
+	else
+		count = planar_read_float (psf, ptr, frames) ;
+
+	if (psf->read_current + count > psf->sf.frames)
+		count = psf->sf.frames - psf->read_current ;
+
+	if (count < frames)
+		for (chan = 0 ; chan < psf->sf.channels ; chan++)
+			psf_memset (ptr [chan] + count, 0, (frames - count) * sizeof (float)) ;
+
+	psf->read_current += count ;
+
+	psf->last_op = SFM_READ ;
+
+	return count ;
+} /* sf_readf_float_planar */
+
+sf_count_t
+sf_writef_float_planar	(SNDFILE *sndfile, const float * const *ptr, sf_count_t frames)
+{	SF_PRIVATE 	*psf ;
+	sf_count_t	count ;
+
+	if (frames == 0)
+		return 0 ;
+
+	VALIDATE_SNDFILE_AND_ASSIGN_PSF (sndfile, psf, 1) ;
+
+	if (frames <= 0)
+	{	psf->error = SFE_NEGATIVE_RW_LEN ;
+		return 0 ;
+		} ;
+
+	if (ptr == NULL)
+	{	psf->error = SFE_BAD_INT_PTR ;
+		return 0 ;
+		} ;
+
+	if (psf->file.mode == SFM_READ)
+	{	psf->error = SFE_NOT_WRITEMODE ;
+		return 0 ;
+		} ;
+
+	if (psf->write_float == NULL || psf->seek == NULL)
+	{	psf->error = SFE_UNIMPLEMENTED ;
+		return 0 ;
+		} ;
+
+	if (psf->last_op != SFM_WRITE)
+		if (psf->seek (psf, SFM_WRITE, psf->write_current) < 0)
+			return 0 ;
+
+	if (psf->have_written == SF_FALSE && psf->write_header != NULL)
+	{	if ((psf->error = psf->write_header (psf, SF_FALSE)))
+			return 0 ;
+		} ;
+	psf->have_written = SF_TRUE ;
+
+	count = planar_write_float (psf, ptr, frames) ;
+
+	psf->write_current += count ;
+
+	psf->last_op = SFM_WRITE ;
+
+	if (psf->write_current > psf->sf.frames)
+	{	psf->sf.frames = psf->write_current ;
+		psf->dataend = 0 ;
+		} ;
+
+	if (psf->auto_header && psf->write_header != NULL)
+		psf->write_header (psf, SF_TRUE) ;
+
+	return count ;
+} /* sf_writef_float_planar */
+
 /*=========================================================================
 ** Private functions.
 */
 
+/*
+** Codecs only deal in interleaved samples, so planar reads and writes go
+** through a buffer a few thousand samples at a time.
+*/
+
+static sf_count_t
+planar_read_float (SF_PRIVATE *psf, float * const *ptr, sf_count_t frames)
+{	BUF_UNION	ubuf ;
+	sf_count_t	total = 0, count ;
+	int			bufferframes, chan, channels, k ;
+
+	channels = psf->sf.channels ;
+	bufferframes = ARRAY_LEN (ubuf.fbuf) / channels ;
+
+	while (total < frames)
+	{	count = frames - total > bufferframes ? bufferframes : frames - total ;
+		count = psf->read_float (psf, ubuf.fbuf, count * channels) / channels ;
+
+		if (count <= 0)
+			break ;
+
+		for (chan = 0 ; chan < channels ; chan++)
+		{	const float *src = ubuf.fbuf + chan ;
+			float *dest = ptr [chan] + total ;
+
+			for (k = 0 ; k < count ; k++)
+				dest [k] = src [k * channels] ;
+			} ;
+
+		total += count ;
+
+		if (count < bufferframes && total < frames)
+			break ;
+		} ;
+
+	return total ;
+} /* planar_read_float */
+
+static sf_count_t
+planar_write_float (SF_PRIVATE *psf, const float * const *ptr, sf_count_t frames)
+{	BUF_UNION	ubuf ;
+	sf_count_t	total = 0, count, written ;
+	int			bufferframes, chan, channels, k ;
+
+	channels = psf->sf.channels ;
+	bufferframes = ARRAY_LEN (ubuf.fbuf) / channels ;
+
+	while (total < frames)
+	{	count = frames - total > bufferframes ? bufferframes : frames - total ;
+
+		for (chan = 0 ; chan < channels ; chan++)
+		{	const float *src = ptr [chan] + total ;
+			float *dest = ubuf.fbuf + chan ;
+
+			for (k = 0 ; k < count ; k++)
+				dest [k * channels] = src [k] ;
+			} ;
+
+		written = psf->write_float (psf, ubuf.fbuf, count * channels) / channels ;
+		total += written ;
+
+		if (written < count)
+			break ;
+		} ;
+
+	return total ;
+} /* planar_write_float */
+
 static int
 try_resource_fork (SF_PRIVATE * psf)
 {	int old_error = psf->error ;
@@ -2814,6 +3163,31 @@ save_header_info (SF_PRIVATE *psf)
 {	snprintf (sf_parselog, sizeof (sf_parselog), "%s", psf->parselog.buf) ;
 } /* save_header_info */
 
+static int
+psf_build_seek_index (SF_PRIVATE *psf)
+{	BUF_UNION	ubuf ;
+	sf_count_t	current ;
+	int			items ;
+
+	if (psf->seek == NULL || psf->read_float == NULL)
+		return SFE_UNIMPLEMENTED ;
+
+	current = psf->read_current ;
+	items = ARRAY_LEN (ubuf.fbuf) - ARRAY_LEN (ubuf.fbuf) % psf->sf.channels ;
+
+	if (psf->seek (psf, SFM_READ, 0) != 0)
+		return psf->error ? psf->error : SFE_BAD_SEEK ;
+
+	/* The codec records the seek points as it decodes. */
+	while (psf->read_float (psf, ubuf.fbuf, items) > 0)
+		/* Do nothing. */ ;
+
+	if (psf->seek (psf, SFM_READ, current) != current)
+		return psf->error ? psf->error : SFE_BAD_SEEK ;
+
+	return psf->error ;
+} /* psf_build_seek_index */
+
 static int
 copy_filename (SF_PRIVATE *psf, const char *path)
 {	const char *ccptr ;
@@ -2859,11 +3233,14 @@ psf_close (SF_PRIVATE *psf)
 	if (psf->container_close)
 		error = psf->container_close (psf) ;
 
+	psf_seek_index_close (psf) ;
+
 	error = psf_fclose (psf) ;
 	psf_close_rsrc (psf) ;
 
 	/* For an ISO C compliant implementation it is ok to free a NULL pointer. */
 	free (psf->header.ptr) ;
+	free (psf->iobuf.ptr) ;
 	free (psf->container_data) ;
 	free (psf->codec_data) ;
 	free (psf->interleave) ;